@@ -0,0 +1,112 @@
+// =====================================================================================
+//
+//       Filename:  BinaryFileUtils.h
+//
+//    Description:  Helpers shared by our memory mapped binary data files
+//
+//        Version:  1.0
+//        Created:  10/19/2026 06:02:44 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef BINARYFILEUTILS_H_
+#define BINARYFILEUTILS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <thread>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// our binary files are a header followed by sections of packed arrays.  Each
+// section starts on an 8 byte boundary so the arrays can be used in place
+// from a memory mapping.
+
+constexpr std::size_t AlignUp(std::size_t offset)
+{
+    return (offset + 7) & ~std::size_t{7};
+}
+
+template <typename T>
+void WriteSection(std::ofstream &output, const T *data, std::size_t count)
+{
+    const auto bytes = count * sizeof(T);
+    output.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+
+    constexpr std::array<char, 8> padding{};
+    output.write(padding.data(), static_cast<std::streamsize>(AlignUp(bytes) - bytes));
+}
+
+// FNV-1a.  Quick and plenty good for hash tables, file names and telling a
+// damaged record from a good one.  To hash more data after some, pass the
+// hash so far as hash.
+
+constexpr std::uint32_t FNV1a32(std::string_view data, std::uint32_t hash = 2166136261U)
+{
+    for (const unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+constexpr std::uint64_t FNV1a64(std::string_view data, std::uint64_t hash = 0xcbf29ce484222325ULL)
+{
+    for (const unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// files derived from an index file remember the index file's size and this
+// so they can tell when they are out of date.
+
+inline std::int64_t FileModificationTime(const fs::path &file_name)
+{
+    return static_cast<std::int64_t>(fs::last_write_time(file_name).time_since_epoch().count());
+}
+
+// new files are written under a temporary name and renamed into place so
+// anyone else looking for the file sees all of it or none of it.  The name is
+// unique to this process and thread.
+
+inline fs::path MakeTempFileName(const fs::path &file_name)
+{
+    auto temp_file_name = file_name;
+    temp_file_name += std::format(".{}.{}.tmp", ::getpid(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    return temp_file_name;
+}
+
+#endif /* BINARYFILEUTILS_H_ */
@@ -0,0 +1,394 @@
+// =====================================================================================
+//
+//       Filename:  BinaryIndexFile.cpp
+//
+//    Description:  Implements compact binary columnar copy of an EDGAR index
+//    file
+//
+//        Version:  1.0
+//        Created:  10/19/2026 03:10:51 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryFileUtils.h"
+#include "BinaryIndexFile.h"
+#include "CIKFilter.h"
+#include "IndexRecordScanner.h"
+
+// the file starts with this header.  Everything after it is at an offset we
+// can compute from the counts in the header.  Each section starts on an 8 byte
+// boundary so the columns can be used in place.
+//
+//  form type offsets   uint32[form_count + 1]
+//  form type names     char[form_names_size]
+//  CIKs                uint32[row_count]
+//  form IDs            uint16[row_count]
+//  dates filed         int32[row_count]
+//  file name offsets   uint32[row_count + 1]
+//  file names          char[strings_size]
+
+namespace
+{
+constexpr std::array<char, 8> k_magic{'C', 'O', 'L', 'I', 'D', 'X', '0', '1'};
+constexpr std::uint32_t k_version = 2;
+
+// which columns the rows are in order by.  master.idx is sorted by CIK and
+// form.idx by form type.  Form IDs are handed out in the order we first see
+// each form type so a file sorted by form type is also sorted by form ID.
+
+constexpr std::uint32_t k_sorted_by_CIK = 1;
+constexpr std::uint32_t k_sorted_by_form_type = 2;
+
+struct BinaryIndexHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t row_count;
+    std::uint32_t form_count;
+    std::uint32_t form_names_size;
+    std::uint32_t sorted_columns;
+    std::uint32_t unused;
+    std::uint64_t source_size;
+    std::int64_t source_mtime;
+    std::uint64_t strings_size;
+};
+static_assert(sizeof(BinaryIndexHeader) == 56);
+
+struct BinaryIndexLayout
+{
+    std::size_t form_offsets;
+    std::size_t form_names;
+    std::size_t CIKs;
+    std::size_t form_IDs;
+    std::size_t dates_filed;
+    std::size_t file_name_offsets;
+    std::size_t strings;
+    std::size_t total_size;
+};
+
+BinaryIndexLayout ComputeLayout(const BinaryIndexHeader &header)
+{
+    BinaryIndexLayout layout;
+    layout.form_offsets = AlignUp(sizeof(BinaryIndexHeader));
+    layout.form_names = AlignUp(layout.form_offsets + (std::size_t{header.form_count} + 1) * sizeof(std::uint32_t));
+    layout.CIKs = AlignUp(layout.form_names + header.form_names_size);
+    layout.form_IDs = AlignUp(layout.CIKs + header.row_count * sizeof(std::uint32_t));
+    layout.dates_filed = AlignUp(layout.form_IDs + header.row_count * sizeof(std::uint16_t));
+    layout.file_name_offsets = AlignUp(layout.dates_filed + header.row_count * sizeof(std::int32_t));
+    layout.strings = AlignUp(layout.file_name_offsets + (std::size_t{header.row_count} + 1) * sizeof(std::uint32_t));
+    layout.total_size = layout.strings + header.strings_size;
+    return layout;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  BinaryIndexFile
+//      Method:  BinaryIndexFile
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+BinaryIndexFile::BinaryIndexFile(const fs::path &binary_index_file_name)
+    : binary_file_{binary_index_file_name, MemoryMappedFile::AccessPattern::sequential}
+{
+    const auto data = binary_file_.GetView();
+
+    if (data.size() < sizeof(BinaryIndexHeader))
+    {
+        throw std::runtime_error(catenate("Binary index file: ", binary_index_file_name.string(), " is too short."));
+    }
+
+    BinaryIndexHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != k_magic || header.version != k_version)
+    {
+        throw std::runtime_error(
+            catenate("File: ", binary_index_file_name.string(), " is not a version ", k_version, " binary index file."));
+    }
+
+    // form IDs are uint16 so there can't be more form types than that.  Check
+    // before we do any arithmetic with the counts.
+
+    if (header.form_count > std::numeric_limits<std::uint16_t>::max() ||
+        header.row_count == std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::runtime_error(catenate("Binary index file: ", binary_index_file_name.string(), " is damaged."));
+    }
+
+    const auto layout = ComputeLayout(header);
+    if (layout.total_size != data.size())
+    {
+        throw std::runtime_error(
+            catenate("Binary index file: ", binary_index_file_name.string(), " has the wrong size for its contents."));
+    }
+
+    source_size_ = header.source_size;
+    source_mtime_ = header.source_mtime;
+    sorted_by_CIK_ = (header.sorted_columns & k_sorted_by_CIK) != 0;
+    sorted_by_form_type_ = (header.sorted_columns & k_sorted_by_form_type) != 0;
+
+    // the sections are aligned and the mapping is page aligned so we can use
+    // the columns right where they are.
+
+    auto column = [&data](std::size_t offset) { return data.data() + offset; };
+
+    const std::span<const std::uint32_t> form_offsets{
+        reinterpret_cast<const std::uint32_t *>(column(layout.form_offsets)), std::size_t{header.form_count} + 1};
+    const COL::sview form_names{column(layout.form_names), header.form_names_size};
+
+    CIKs_ = {reinterpret_cast<const std::uint32_t *>(column(layout.CIKs)), header.row_count};
+    form_IDs_ = {reinterpret_cast<const std::uint16_t *>(column(layout.form_IDs)), header.row_count};
+    dates_filed_ = {reinterpret_cast<const std::int32_t *>(column(layout.dates_filed)), header.row_count};
+    file_name_offsets_ = {reinterpret_cast<const std::uint32_t *>(column(layout.file_name_offsets)),
+                          std::size_t{header.row_count} + 1};
+    strings_ = {column(layout.strings), header.strings_size};
+
+    // a damaged file could send us off the end of our mapping so check the
+    // things we will be using as offsets and indexes.
+
+    if (!std::ranges::is_sorted(form_offsets) || form_offsets.back() != form_names.size() ||
+        !std::ranges::is_sorted(file_name_offsets_) || file_name_offsets_.back() != strings_.size() ||
+        std::ranges::any_of(form_IDs_, [&header](auto form_ID) { return form_ID >= header.form_count; }))
+    {
+        throw std::runtime_error(catenate("Binary index file: ", binary_index_file_name.string(), " is damaged."));
+    }
+
+    form_types_.reserve(header.form_count);
+    for (std::size_t form_ID = 0; form_ID < header.form_count; ++form_ID)
+    {
+        form_types_.push_back(form_names.substr(form_offsets[form_ID], form_offsets[form_ID + 1] - form_offsets[form_ID]));
+    }
+} // -----  end of method BinaryIndexFile::BinaryIndexFile  (constructor)  -----
+
+BinaryIndexFile BinaryIndexFile::OpenForTextIndexFile(const fs::path &text_index_file_name)
+{
+    const auto binary_index_file_name = MakeBinaryIndexFileName(text_index_file_name);
+
+    if (fs::exists(binary_index_file_name))
+    {
+        try
+        {
+            BinaryIndexFile binary_index{binary_index_file_name};
+            if (binary_index.IsCurrentFor(text_index_file_name))
+            {
+                return binary_index;
+            }
+            spdlog::debug(catenate("B: Binary index file: ", binary_index_file_name.string(),
+                                   " is out of date. Rebuilding it."));
+        }
+        catch (const std::runtime_error &e)
+        {
+            spdlog::debug(catenate("B: ", e.what(), " Rebuilding it."));
+        }
+    }
+
+    ConvertTextIndexFile(text_index_file_name, binary_index_file_name);
+    return BinaryIndexFile{binary_index_file_name};
+} // -----  end of method BinaryIndexFile::OpenForTextIndexFile  -----
+
+bool BinaryIndexFile::IsCurrentFor(const fs::path &text_index_file_name) const
+{
+    std::error_code err;
+    const auto text_file_size = fs::file_size(text_index_file_name, err);
+    if (err)
+    {
+        return false;
+    }
+    return text_file_size == source_size_ && FileModificationTime(text_index_file_name) == source_mtime_;
+} // -----  end of method BinaryIndexFile::IsCurrentFor  -----
+
+std::vector<BinaryIndexFile::RowRange> BinaryIndexFile::FindCIKRows(const std::vector<std::uint32_t> &CIKs) const
+{
+    BOOST_ASSERT_MSG(sorted_by_CIK_, "Binary index file is not in order by CIK.");
+
+    // CIKs are sorted so each search can start where the last one ended and
+    // the ranges come out in file order.
+
+    std::vector<RowRange> row_ranges;
+    auto search_start = CIKs_.begin();
+    for (const auto CIK : CIKs)
+    {
+        const auto [first, last] = std::equal_range(search_start, CIKs_.end(), CIK);
+        if (first != last)
+        {
+            row_ranges.emplace_back(first - CIKs_.begin(), last - CIKs_.begin());
+        }
+        search_start = last;
+    }
+    return row_ranges;
+} // -----  end of method BinaryIndexFile::FindCIKRows  -----
+
+std::vector<BinaryIndexFile::RowRange> BinaryIndexFile::FindFormTypeRows(
+    const std::vector<std::uint16_t> &form_IDs) const
+{
+    BOOST_ASSERT_MSG(sorted_by_form_type_, "Binary index file is not in order by form type.");
+
+    std::vector<RowRange> row_ranges;
+    auto search_start = form_IDs_.begin();
+    for (const auto form_ID : form_IDs)
+    {
+        const auto [first, last] = std::equal_range(search_start, form_IDs_.end(), form_ID);
+        if (first != last)
+        {
+            row_ranges.emplace_back(first - form_IDs_.begin(), last - form_IDs_.begin());
+        }
+        search_start = last;
+    }
+    return row_ranges;
+} // -----  end of method BinaryIndexFile::FindFormTypeRows  -----
+
+fs::path BinaryIndexFile::MakeBinaryIndexFileName(const fs::path &text_index_file_name)
+{
+    auto binary_index_file_name = text_index_file_name;
+    binary_index_file_name.replace_extension("cidx");
+    return binary_index_file_name;
+} // -----  end of method BinaryIndexFile::MakeBinaryIndexFileName  -----
+
+void BinaryIndexFile::ConvertTextIndexFile(const fs::path &text_index_file_name, const fs::path &binary_index_file_name)
+{
+    const auto convert_start = std::chrono::steady_clock::now();
+
+    // get these before we read anything.  If the text file changes while we
+    // are working, our binary file will just look out of date next time.
+
+    BinaryIndexHeader header{};
+    header.magic = k_magic;
+    header.version = k_version;
+    header.source_size = fs::file_size(text_index_file_name);
+    header.source_mtime = FileModificationTime(text_index_file_name);
+
+    const MemoryMappedFile text_file{text_index_file_name};
+    const auto text_data = text_file.GetView();
+
+    const auto data_start = FindIndexDataStart(text_data);
+
+    BOOST_ASSERT_MSG(data_start != COL::sview::npos,
+                     catenate("Unable to find start of index entries in file: ", text_index_file_name.string()).c_str());
+
+    const std::size_t form_type_width = FindFormTypeColumnWidth(text_data, data_start).value_or(0);
+    const auto index_records = text_data.substr(data_start);
+
+    // there are only a few hundred different form types so number them as we
+    // find them.
+
+    std::map<std::string, std::uint16_t, std::less<>> form_IDs;
+    std::vector<std::uint32_t> form_offsets{0};
+    std::string form_names;
+
+    std::vector<std::uint32_t> CIKs;
+    std::vector<std::uint16_t> row_form_IDs;
+    std::vector<std::int32_t> dates_filed;
+    std::vector<std::uint32_t> file_name_offsets{0};
+    std::string file_names;
+
+    IndexRecordScanner scanner = form_type_width > 0 ? IndexRecordScanner{index_records, form_type_width}
+                                                     : IndexRecordScanner{index_records};
+    IndexRecord record;
+
+    while (scanner.NextRecord(record))
+    {
+        auto form_entry = form_IDs.find(record.form_type);
+        if (form_entry == form_IDs.end())
+        {
+            BOOST_ASSERT_MSG(form_IDs.size() < std::numeric_limits<std::uint16_t>::max(),
+                             catenate("Too many form types in index file: ", text_index_file_name.string()).c_str());
+
+            form_entry =
+                form_IDs.emplace(std::string{record.form_type}, static_cast<std::uint16_t>(form_IDs.size())).first;
+            form_names.append(record.form_type);
+            form_offsets.push_back(static_cast<std::uint32_t>(form_names.size()));
+        }
+
+        // an unusable CIK becomes 0 which is not a real CIK so it will not
+        // match anything we look for.  Same idea for dates.
+
+        CIKs.push_back(ParseCIK(record.CIK).value_or(0));
+        row_form_IDs.push_back(form_entry->second);
+        dates_filed.push_back(ParseIndexDate(record.date_filed)
+                                  .value_or(std::chrono::sys_days{})
+                                  .time_since_epoch()
+                                  .count());
+
+        auto file_name = record.file_name;
+        file_name.remove_suffix(file_name.size() - (file_name.find_last_not_of(" \r\t") + 1));
+        file_names.append(file_name);
+
+        BOOST_ASSERT_MSG(file_names.size() < std::numeric_limits<std::uint32_t>::max(),
+                         catenate("Too much data in index file: ", text_index_file_name.string()).c_str());
+        file_name_offsets.push_back(static_cast<std::uint32_t>(file_names.size()));
+    }
+
+    header.row_count = static_cast<std::uint32_t>(CIKs.size());
+    header.form_count = static_cast<std::uint32_t>(form_IDs.size());
+    header.form_names_size = static_cast<std::uint32_t>(form_names.size());
+    header.strings_size = file_names.size();
+    header.sorted_columns = (std::ranges::is_sorted(CIKs) ? k_sorted_by_CIK : 0) |
+                            (std::ranges::is_sorted(row_form_IDs) ? k_sorted_by_form_type : 0);
+
+    // write under a temporary name then rename so anyone else looking for
+    // this file sees all of it or none of it.
+
+    const auto temp_file_name = MakeTempFileName(binary_index_file_name);
+
+    {
+        std::ofstream output{temp_file_name, std::ios::out | std::ios::binary | std::ios::trunc};
+        BOOST_ASSERT_MSG(output.is_open(), catenate("Unable to open binary index file: ", temp_file_name.string()).c_str());
+
+        WriteSection(output, &header, 1);
+        WriteSection(output, form_offsets.data(), form_offsets.size());
+        WriteSection(output, form_names.data(), form_names.size());
+        WriteSection(output, CIKs.data(), CIKs.size());
+        WriteSection(output, row_form_IDs.data(), row_form_IDs.size());
+        WriteSection(output, dates_filed.data(), dates_filed.size());
+        WriteSection(output, file_name_offsets.data(), file_name_offsets.size());
+        output.write(file_names.data(), static_cast<std::streamsize>(file_names.size()));
+
+        output.close();
+        if (output.fail())
+        {
+            fs::remove(temp_file_name);
+            throw std::runtime_error(catenate("Unable to write binary index file: ", temp_file_name.string()));
+        }
+    }
+    fs::rename(temp_file_name, binary_index_file_name);
+
+    const std::chrono::duration<double> convert_time = std::chrono::steady_clock::now() - convert_start;
+
+    spdlog::debug(std::format("B: Converted index file: {} with {} rows and {} form types to: {} in {:.3f} seconds.",
+                              text_index_file_name, header.row_count, header.form_count, binary_index_file_name,
+                              convert_time.count()));
+} // -----  end of method BinaryIndexFile::ConvertTextIndexFile  -----
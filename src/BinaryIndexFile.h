@@ -0,0 +1,186 @@
+// =====================================================================================
+//
+//       Filename:  BinaryIndexFile.h
+//
+//    Description:  Compact binary columnar copy of an EDGAR index file
+//
+//        Version:  1.0
+//        Created:  10/19/2026 03:02:18 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef BINARYINDEXFILE_H_
+#define BINARYINDEXFILE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Collector_Utils.h"
+#include "MemoryMappedFile.h"
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  BinaryIndexFile
+//  Description:  read-only view of the binary form of a text index file.
+//
+//                Each column is stored as a packed array so a search only
+//                touches the columns it needs:
+//                  CIK         - uint32
+//                  form type   - uint16 ID into the file's form type table
+//                  date filed  - int32 days since 1970-01-01
+//                  file name   - uint32 offset into a string blob
+//
+//                Rows are kept in the same order as the text file so searches
+//                give the same results in the same order.  Like the text
+//                files, we can binary search the CIK column of a master index
+//                and the form ID column of a form index.
+//
+//                The binary file lives next to the text file and records the
+//                text file's size and modification time.  If either changes,
+//                the binary file is rebuilt.
+// =====================================================================================
+class BinaryIndexFile
+{
+public:
+    // [first, last) rows
+
+    using RowRange = std::pair<std::size_t, std::size_t>;
+
+    // ====================  LIFECYCLE     =======================================
+
+    BinaryIndexFile() = delete;
+
+    // throws if the file is not a valid binary index file.
+
+    explicit BinaryIndexFile(const fs::path &binary_index_file_name);
+
+    BinaryIndexFile(const BinaryIndexFile &rhs) = delete;
+    BinaryIndexFile(BinaryIndexFile &&rhs) noexcept = default;
+
+    ~BinaryIndexFile() = default;
+
+    // use an existing binary file if it is current, otherwise convert the text
+    // file first.
+
+    static BinaryIndexFile OpenForTextIndexFile(const fs::path &text_index_file_name);
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] std::size_t GetRowCount() const
+    {
+        return CIKs_.size();
+    }
+    [[nodiscard]] const std::vector<COL::sview> &GetFormTypes() const
+    {
+        return form_types_;
+    }
+
+    [[nodiscard]] std::span<const std::uint32_t> GetCIKs() const
+    {
+        return CIKs_;
+    }
+    [[nodiscard]] std::span<const std::uint16_t> GetFormIDs() const
+    {
+        return form_IDs_;
+    }
+    [[nodiscard]] std::span<const std::int32_t> GetDatesFiled() const
+    {
+        return dates_filed_;
+    }
+
+    [[nodiscard]] std::chrono::sys_days GetDateFiled(std::size_t row) const
+    {
+        return std::chrono::sys_days{std::chrono::days{dates_filed_[row]}};
+    }
+    [[nodiscard]] COL::sview GetFileName(std::size_t row) const
+    {
+        return strings_.substr(file_name_offsets_[row], file_name_offsets_[row + 1] - file_name_offsets_[row]);
+    }
+
+    [[nodiscard]] bool IsSortedByCIK() const
+    {
+        return sorted_by_CIK_;
+    }
+    [[nodiscard]] bool IsSortedByFormType() const
+    {
+        return sorted_by_form_type_;
+    }
+
+    // the rows for each of the given sorted CIKs or form IDs, in file order.
+    // Only for files sorted on that column.
+
+    [[nodiscard]] std::vector<RowRange> FindCIKRows(const std::vector<std::uint32_t> &CIKs) const;
+    [[nodiscard]] std::vector<RowRange> FindFormTypeRows(const std::vector<std::uint16_t> &form_IDs) const;
+
+    // does our header still describe the given text file.
+
+    [[nodiscard]] bool IsCurrentFor(const fs::path &text_index_file_name) const;
+
+    // ====================  MUTATORS      =======================================
+
+    BinaryIndexFile &operator=(const BinaryIndexFile &rhs) = delete;
+    BinaryIndexFile &operator=(BinaryIndexFile &&rhs) noexcept = default;
+
+    // ====================  OPERATORS     =======================================
+
+    // master.idx -> master.cidx,  form.20240102.idx -> form.20240102.cidx
+
+    static fs::path MakeBinaryIndexFileName(const fs::path &text_index_file_name);
+
+    // parse the text file and write its binary form.  The new file is written
+    // under a temporary name and renamed into place so readers never see a
+    // partial file.
+
+    static void ConvertTextIndexFile(const fs::path &text_index_file_name, const fs::path &binary_index_file_name);
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // ====================  DATA MEMBERS  =======================================
+
+    MemoryMappedFile binary_file_;
+
+    std::uint64_t source_size_ = 0;
+    std::int64_t source_mtime_ = 0;
+    bool sorted_by_CIK_ = false;
+    bool sorted_by_form_type_ = false;
+
+    std::vector<COL::sview> form_types_;
+
+    std::span<const std::uint32_t> CIKs_;
+    std::span<const std::uint16_t> form_IDs_;
+    std::span<const std::int32_t> dates_filed_;
+    std::span<const std::uint32_t> file_name_offsets_;
+    COL::sview strings_;
+
+}; // -----  end of class BinaryIndexFile  -----
+
+#endif /* BINARYINDEXFILE_H_ */
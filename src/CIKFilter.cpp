@@ -0,0 +1,158 @@
+// =====================================================================================
+//
+//       Filename:  CIKFilter.cpp
+//
+//    Description:  Implements integer based CIK membership test for index
+//    filtering
+//
+//        Version:  1.0
+//        Created:  10/19/2026 01:14:20 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+#include "CIKFilter.h"
+
+//--------------------------------------------------------------------------------------
+//       Class:  CIKFilter
+//      Method:  CIKFilter
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+CIKFilter::CIKFilter(const TickerConverter::TickerCIKMap &ticker_map) : active_{!ticker_map.empty()}
+{
+    // tickers we could not convert have a marker instead of a CIK.  They
+    // just drop out here.
+
+    for (const auto &[ticker, CIK] : ticker_map)
+    {
+        if (auto as_number = ParseCIK(CIK); as_number)
+        {
+            CIKs_.push_back(*as_number);
+        }
+    }
+    BuildLookup();
+} // -----  end of method CIKFilter::CIKFilter  (constructor)  -----
+
+CIKFilter::CIKFilter(const std::vector<std::uint32_t> &CIKs) : CIKs_{CIKs}, active_{!CIKs.empty()}
+{
+    BuildLookup();
+} // -----  end of method CIKFilter::CIKFilter  (constructor)  -----
+
+CIKFilter::CIKFilter(const std::vector<std::uint32_t> &CIKs, std::uint32_t max_bitmap_bits)
+    : CIKs_{CIKs}, max_bitmap_bits_{max_bitmap_bits}, active_{!CIKs.empty()}
+{
+    BuildLookup();
+} // -----  end of method CIKFilter::CIKFilter  (constructor)  -----
+
+void CIKFilter::BuildLookup()
+{
+    std::ranges::sort(CIKs_);
+    CIKs_.erase(std::unique(CIKs_.begin(), CIKs_.end()), CIKs_.end());
+
+    if (CIKs_.empty())
+    {
+        return;
+    }
+
+    min_CIK_ = CIKs_.front();
+    max_CIK_ = CIKs_.back();
+
+    if (max_CIK_ - min_CIK_ < max_bitmap_bits_)
+    {
+        bitmap_.assign((max_CIK_ - min_CIK_) / 64 + 1, 0);
+        for (const auto CIK : CIKs_)
+        {
+            const auto bit = CIK - min_CIK_;
+            bitmap_[bit >> 6] |= std::uint64_t{1} << (bit & 63);
+        }
+    }
+} // -----  end of method CIKFilter::BuildLookup  -----
+
+bool CIKFilter::Contains(COL::sview CIK) const
+{
+    if (!active_)
+    {
+        return true;
+    }
+    auto as_number = ParseCIK(CIK);
+    return as_number && Contains(*as_number);
+} // -----  end of method CIKFilter::Contains  -----
+
+std::optional<std::uint32_t> ParseCIK(COL::sview CIK)
+{
+    std::uint32_t result = 0;
+    const auto [ptr, ec] = std::from_chars(CIK.data(), CIK.data() + CIK.size(), result);
+    if (ec != std::errc{} || ptr != CIK.data() + CIK.size() || CIK.empty())
+    {
+        return std::nullopt;
+    }
+    return result;
+} // -----  end of function ParseCIK  -----
+
+void BenchmarkCIKFilter(std::size_t lookup_count)
+{
+    BOOST_ASSERT_MSG(lookup_count > 0, "Need CIKs to look up.");
+
+    // CIKs run up to about 2 million.  Most of what we look up is not on a
+    // watch list, just like scanning an index file.
+
+    constexpr std::uint32_t k_highest_CIK = 2'000'000;
+
+    std::mt19937 random_numbers{20261019};
+    std::uniform_int_distribution<std::uint32_t> random_CIK{1, k_highest_CIK};
+
+    std::vector<std::uint32_t> lookups(lookup_count);
+    std::ranges::generate(lookups, [&]() { return random_CIK(random_numbers); });
+
+    for (const std::size_t watch_list_size : {10, 100, 1'000, 10'000, 100'000})
+    {
+        std::vector<std::uint32_t> watch_list(watch_list_size);
+        std::ranges::generate(watch_list, [&]() { return random_CIK(random_numbers); });
+
+        const CIKFilter bitmap_filter{watch_list};
+        const CIKFilter binary_search_filter{watch_list, 0};
+
+        for (const auto *cik_filter : {&bitmap_filter, &binary_search_filter})
+        {
+            const auto lookup_start = std::chrono::steady_clock::now();
+            const auto found =
+                std::ranges::count_if(lookups, [cik_filter](auto CIK) { return cik_filter->Contains(CIK); });
+            const std::chrono::duration<double> lookup_time = std::chrono::steady_clock::now() - lookup_start;
+
+            spdlog::info(std::format("K: {} CIKs using {}: {} lookups in {:.3f} seconds. {:.1f} M lookups/sec. "
+                                     "Found: {}.",
+                                     cik_filter->GetCIKs().size(),
+                                     cik_filter->UsesBitmap() ? "bitmap" : "binary search", lookups.size(),
+                                     lookup_time.count(),
+                                     static_cast<double>(lookups.size()) / lookup_time.count() / 1'000'000, found));
+        }
+    }
+} // -----  end of function BenchmarkCIKFilter  -----
@@ -0,0 +1,145 @@
+// =====================================================================================
+//
+//       Filename:  CIKFilter.h
+//
+//    Description:  Integer based CIK membership test for index filtering
+//
+//        Version:  1.0
+//        Created:  10/19/2026 01:05:44 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef CIKFILTER_H_
+#define CIKFILTER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Collector_Utils.h"
+#include "TickerConverter.h"
+
+// =====================================================================================
+//        Class:  CIKFilter
+//  Description:  holds the CIKs from a ticker map as integers so index records
+//                can be tested without string compares.  The ticker cache has
+//                CIKs padded with leading zeroes and the index files do not
+//                so converting to integers sidesteps that too.
+//
+//                A bitmap over the range of our CIKs is used when that range
+//                is reasonably small (the usual case since CIKs are at most
+//                7 digits).  Otherwise we binary search a sorted vector.
+// =====================================================================================
+class CIKFilter
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    CIKFilter() = default; // no filtering.  Everything passes.
+    explicit CIKFilter(const TickerConverter::TickerCIKMap &ticker_map);
+    explicit CIKFilter(const std::vector<std::uint32_t> &CIKs);
+
+    // use a bitmap only if it needs no more than max_bitmap_bits.  0 means
+    // always binary search.  For comparing the two.
+
+    CIKFilter(const std::vector<std::uint32_t> &CIKs, std::uint32_t max_bitmap_bits);
+
+    // ====================  ACCESSORS     =======================================
+
+    // an inactive filter passes everything.  Note that a filter built from a
+    // ticker map where no tickers could be converted is still active and
+    // passes nothing.
+
+    [[nodiscard]] bool IsActive() const
+    {
+        return active_;
+    }
+    [[nodiscard]] const std::vector<std::uint32_t> &GetCIKs() const
+    {
+        return CIKs_;
+    }
+    [[nodiscard]] bool UsesBitmap() const
+    {
+        return !bitmap_.empty();
+    }
+
+    [[nodiscard]] bool Contains(std::uint32_t CIK) const
+    {
+        if (!active_)
+        {
+            return true;
+        }
+        if (!bitmap_.empty())
+        {
+            if (CIK < min_CIK_ || CIK > max_CIK_)
+            {
+                return false;
+            }
+            const auto bit = CIK - min_CIK_;
+            return (bitmap_[bit >> 6] >> (bit & 63)) & 1U;
+        }
+        return std::ranges::binary_search(CIKs_, CIK);
+    }
+
+    // for CIKs straight from an index file.
+
+    [[nodiscard]] bool Contains(COL::sview CIK) const;
+
+    // ====================  MUTATORS      =======================================
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    void BuildLookup();
+
+    // ====================  DATA MEMBERS  =======================================
+
+    // don't spend more than this on a bitmap.
+
+    static constexpr std::uint32_t k_max_bitmap_bits = 32 * 1024 * 1024;
+
+    std::vector<std::uint32_t> CIKs_;
+    std::vector<std::uint64_t> bitmap_;
+    std::uint32_t min_CIK_ = 0;
+    std::uint32_t max_CIK_ = 0;
+    std::uint32_t max_bitmap_bits_ = k_max_bitmap_bits;
+    bool active_ = false;
+
+}; // -----  end of class CIKFilter  -----
+
+// CIK text to integer.  Leading zeroes are fine.  Nothing if the text is not
+// a valid CIK.
+
+std::optional<std::uint32_t> ParseCIK(COL::sview CIK);
+
+// makes up watch lists of several sizes and logs how fast lookup_count
+// lookups go using a bitmap and using binary search.
+
+void BenchmarkCIKFilter(std::size_t lookup_count);
+
+#endif /* CIKFILTER_H_ */
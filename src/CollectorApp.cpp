@@ -37,7 +37,7 @@
 //--------------------------------------------------------------------------------------
 
 #include <iostream>
-#include <random> //	just for initial development.  used in Quarterly form retrievals
+#include <optional>
 
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -45,11 +45,24 @@
 
 #include "CollectorApp.h"
 
+#include "CIKFilter.h"
 #include "Collector_Utils.h"
+#include "CompressedFormFiles.h"
 #include "DailyIndexFileRetriever.h"
+#include "ContentStore.h"
+#include "DownloadManifest.h"
+#include "FileWriter.h"
+#include "FilingCatalog.h"
 #include "FinancialStatementsAndNotes.h"
+#include "FormDirectoryLayout.h"
 #include "FormFileRetriever.h"
+#include "FormTypeMatcher.h"
+#include "GroupCommit.h"
+#include "IndexRecordScanner.h"
+#include "IndexStreamFilter.h"
 #include "QuarterlyIndexFileRetriever.h"
+#include "RunJournal.h"
+#include "SegmentStore.h"
 
 /*
  *--------------------------------------------------------------------------------------
@@ -185,8 +198,8 @@ void CollectorApp::SetupProgramOptions()
         ("form-dir", po::value<fs::path>(&this->local_form_file_directory_), "directory form files are downloaded to.")
         ( "host", po::value<std::string>(&this->HTTPS_host_)->default_value("www.sec.gov"), "web site we download from. Default is 'www.sec.gov'.")
         ( "port", po::value<std::string>(&this->HTTPS_port_)->default_value("443"), "Port number to use for web site. Default is '443' for SSL.")
-        ( "mode", po::value<std::string>(&this->mode_)->default_value("daily"), "'daily' or 'quarterly' for index files, 'ticker-only' or 'notes'. Default is 'daily'.")
-        ("form", po::value<std::string>(&this->form_)->default_value("10-Q"), "name of form type[s] we are downloading. Default is '10-Q'.")
+        ( "mode", po::value<std::string>(&this->mode_)->default_value("daily"), "'daily' or 'quarterly' for index files, 'ticker-only', 'notes', 'query' to search the local filing catalog, 'export' to write out the segment store, 'train-dictionaries' to make compression dictionaries for the given forms from the files in 'form-dir', 'migrate-layout' to move the files in 'form-dir' to the 'form-dir-layout' layout, 'benchmark-writes' to time each 'file-writer' writing small files in 'form-dir', 'benchmark-scan' to time scanning made up index data with and without SIMD, 'benchmark-cik-filter' to time CIK lookups with a bitmap and with binary search or 'benchmark-segments' to compare writing and reading small files in 'form-dir' as a file each and in a segment store. Default is 'daily'.")
+        ("form", po::value<std::string>(&this->form_)->default_value("10-Q"), "name of form type[s] we are downloading. A trailing '*' matches all forms starting with the given text, e.g. '10-K*'. Default is '10-Q'.")
         ( "ticker", po::value<std::string>(&this->ticker_), "ticker[s] to lookup and filter form downloads.")
         ( "log-path", po::value<fs::path>(&this->log_file_path_name_), "path name for log file")
         ( "ticker-cache", po::value<fs::path>(&this->ticker_cache_file_name_), "path name for ticker-to-CIK cache file.")
@@ -198,6 +211,28 @@ void CollectorApp::SetupProgramOptions()
         ( "replace-notes-files", po::value<bool>(&this->replace_notes_files_)->implicit_value(true), "over write local financial notes files if specified. Default is 'false'.")
         ( "log-new-form-files", po::value<bool>(&this->log_new_form_files_)->implicit_value(true), "log path names of newly downloaded forms files. Default is 'false'.")
         ("index-only", po::value<bool>(&this->index_only_)->implicit_value(true), "do not download form files. Default is 'false'.")
+        ("binary-index", po::value<bool>(&this->use_binary_index_)->default_value(true), "search binary copies of index files, made as needed next to the text files. Default is 'true'.")
+        ("query-cache", po::value<bool>(&this->use_query_cache_)->default_value(true), "save the results of searching each index file next to it and reuse them when the same index file is searched with the same forms, tickers and dates. Default is 'true'.")
+        ("manifest", po::value<bool>(&this->use_download_manifest_)->default_value(true), "keep a list of downloaded files in the top of the index and form directories and use it to decide what to skip instead of checking the file system for each file. Default is 'true'.")
+        ("reconcile-manifest", po::value<bool>(&this->reconcile_manifest_)->implicit_value(true), "rebuild the download manifests from the file system before downloading. This is done automatically every 30 days. Default is 'false'.")
+        ("content-store", po::value<bool>(&this->use_content_store_)->implicit_value(true), "keep one copy of each distinct form file, named by its SHA-256 hash, in '.content' in the 'form-dir' directory and hard link the usual form file names to it. Default is 'false'.")
+        ("segment-forms", po::value<std::string>(&this->segment_forms_), "form type[s] to append to segment files in '.segments' in the 'form-dir' directory instead of saving each as a separate file, e.g. '3,4,5'.")
+        ("compress-forms", po::value<bool>(&this->compress_forms_)->implicit_value(true), "zstd compress form files after downloading them. Forms with a dictionary in '.dictionaries' in the 'form-dir' directory are compressed with it. Default is 'false'.")
+        ("compression-level", po::value<int>(&this->compression_level_)->default_value(9), "zstd compression level for 'compress-forms'. Default is 9.")
+        ("durable-writes", po::value<bool>(&this->durable_writes_)->implicit_value(true), "download form files to temp files and only give them their real names once they are flushed to disk, a batch at a time. After a crash, any form file with its real name is complete. Default is 'false'.")
+        ("commit-batch-size", po::value<int>(&this->commit_batch_size_)->default_value(500), "how many form files 'durable-writes' flushes to disk at a time. Default is 500.")
+        ("commit-interval", po::value<int>(&this->commit_interval_)->default_value(1000), "longest time in milliseconds 'durable-writes' waits to fill a batch. Default is 1000.")
+        ("file-writer", po::value<std::string>(&this->file_writer_name_)->default_value("stream"), "how concurrent downloads write form files. 'stream' writes each on its download thread. 'io_uring' hands them to an io_uring, if we have one, so the download threads don't wait. Default is 'stream'.")
+        ("journal", po::value<fs::path>(&this->journal_file_name_), "path name for a new run journal. The run's options, the index files it uses, its filing plans and each form file as it is done or fails are recorded in it, a batch at a time like 'durable-writes', so an interrupted run can be picked up with 'resume'. Uses 'commit-batch-size' and 'commit-interval'.")
+        ("resume", po::value<fs::path>(&this->resume_journal_file_name_), "path name of the run journal of an interrupted run to carry on with. Its options are used unless given again and its filing plans are used as is. Form files it has as done are skipped without looking for them.")
+        ("benchmark-files", po::value<int>(&this->benchmark_file_count_)->default_value(100'000), "how many files 'benchmark-writes' and 'benchmark-segments' modes write. Default is 100000.")
+        ("benchmark-file-size", po::value<int>(&this->benchmark_file_size_)->default_value(4096), "size in bytes of the files 'benchmark-writes' and 'benchmark-segments' modes write. Default is 4096.")
+        ("benchmark-rows", po::value<int>(&this->benchmark_row_count_)->default_value(1'000'000), "how many rows of index data 'benchmark-scan' mode makes up. Default is 1000000.")
+        ("benchmark-lookups", po::value<int>(&this->benchmark_lookup_count_)->default_value(10'000'000), "how many CIKs 'benchmark-cik-filter' mode looks up for each watch list size. Default is 10000000.")
+        ("form-dir-layout", po::value<std::string>(&this->form_dir_layout_), "'flat' puts the CIK directories directly in 'form-dir'. 'sharded' puts them 2 levels down, e.g. 'ab/cd/<CIK>', by a hash of the CIK. Default is whatever 'form-dir' already uses or 'flat' for a new one.")
+        ("export-dir", po::value<fs::path>(&this->export_directory_), "directory 'export' mode writes the files in the segment store to, using the same layout as 'form-dir'.")
+        ("catalog", po::value<fs::path>(&this->catalog_file_name_), "path name for the filing catalog used by 'query' mode. Default is 'filing_catalog.ccat' in the 'index-dir' directory.")
+        ("use-form-index", po::value<bool>(&this->use_form_index_)->implicit_value(true), "use the 'form' index files, which are sorted by form type, instead of the 'master' index files. Much less to search when looking for just a few form types. Default is 'false'.")
         ( "pause,p", po::value<int>(&this->pause_)->default_value(1), "how long to wait between downloads. Default: 1 second.")
         ( "max", po::value<int>(&this->max_forms_to_download_)->default_value(-1), "Maximun number of forms to download -- mainly for testing. Default of -1 means no limit.")
         ("log-level,l", po::value<std::string>(&this->logging_level_)->default_value("information"), "logging level. Must be 'none|error|information|debug'. Default is 'information'.")
@@ -215,6 +250,7 @@ void CollectorApp::ParseProgramOptions()
 {
     auto options = po::parse_command_line(mArgc, mArgv, *mNewOptions);
     po::store(options, mVariableMap);
+    StoreResumedOptions();
     if (this->mArgc == 1 || mVariableMap.count("help") == 1)
     {
         std::cout << *mNewOptions << "\n";
@@ -228,6 +264,7 @@ void CollectorApp::ParseProgramOptions(const std::vector<std::string> &tokens)
 {
     auto options = po::command_line_parser(tokens).options(*mNewOptions).run();
     po::store(options, mVariableMap);
+    StoreResumedOptions();
     if (mVariableMap.count("help") == 1)
     {
         std::cout << *mNewOptions << "\n";
@@ -236,14 +273,42 @@ void CollectorApp::ParseProgramOptions(const std::vector<std::string> &tokens)
     po::notify(mVariableMap);
 } /* -----  end of method CollectorApp::ParseProgramOptions  ----- */
 
+void CollectorApp::StoreResumedOptions()
+{
+    if (mVariableMap.count("resume") == 0)
+    {
+        return;
+    }
+
+    // store doesn't replace a value that is already there so anything given
+    // on the command line wins.  Defaults don't count.
+
+    const auto journal_file_name = mVariableMap["resume"].as<fs::path>();
+    auto options = po::command_line_parser(RunJournal::ReadArguments(journal_file_name)).options(*mNewOptions).run();
+    po::store(options, mVariableMap);
+} /* -----  end of method CollectorApp::StoreResumedOptions  ----- */
+
 bool CollectorApp::CheckArgs()
 {
-    BOOST_ASSERT_MSG(mode_ == "daily" || mode_ == "quarterly" || mode_ == "ticker-only" || mode_ == "notes",
-                     catenate("Mode must be either 'daily','quarterly', 'notes', "
-                              "or 'ticker-only' ==> ",
+    BOOST_ASSERT_MSG(mode_ == "daily" || mode_ == "quarterly" || mode_ == "ticker-only" || mode_ == "notes" ||
+                         mode_ == "query" || mode_ == "export" || mode_ == "train-dictionaries" ||
+                         mode_ == "migrate-layout" || mode_ == "benchmark-writes" || mode_ == "benchmark-scan" ||
+                         mode_ == "benchmark-cik-filter" || mode_ == "benchmark-segments",
+                     catenate("Mode must be either 'daily','quarterly', 'notes', 'query', 'export', "
+                              "'train-dictionaries', 'migrate-layout', 'benchmark-writes', 'benchmark-scan', "
+                              "'benchmark-cik-filter', 'benchmark-segments' or 'ticker-only' ==> ",
                               mode_)
                          .c_str());
 
+    // a resumed run keeps adding to its journal.
+
+    if (!resume_journal_file_name_.empty())
+    {
+        journal_file_name_ = resume_journal_file_name_;
+    }
+    BOOST_ASSERT_MSG(journal_file_name_.empty() || ((mode_ == "daily" || mode_ == "quarterly") && !index_only_),
+                     "A run journal is only for downloading form files in 'daily' or 'quarterly' mode.");
+
     //	the user may specify multiple stock tickers in a comma delimited list.
     // We need to parse the entries out 	of that list and place into ultimate
     // home. If just a single entry, copy it to our form list destination too.
@@ -267,6 +332,67 @@ bool CollectorApp::CheckArgs()
         return true;
     }
 
+    if (!segment_forms_.empty())
+    {
+        segment_form_list_ = split_string_to_strings(segment_forms_, ',');
+    }
+
+    BOOST_ASSERT_MSG(form_dir_layout_.empty() || form_dir_layout_ == "flat" || form_dir_layout_ == "sharded",
+                     catenate("Form directory layout must be 'flat' or 'sharded' ==> ", form_dir_layout_).c_str());
+
+    BOOST_ASSERT_MSG(file_writer_name_ == "stream" || file_writer_name_ == "io_uring",
+                     catenate("File writer must be 'stream' or 'io_uring' ==> ", file_writer_name_).c_str());
+
+    if (mode_ == "benchmark-writes" || mode_ == "benchmark-segments")
+    {
+        BOOST_ASSERT_MSG(!local_form_file_directory_.empty(), "Must specify 'form-dir' to benchmark writes in.");
+        BOOST_ASSERT_MSG(benchmark_file_count_ > 0 && benchmark_file_size_ >= 0,
+                         "'benchmark-files' must be > 0 and 'benchmark-file-size' >= 0.");
+        return true;
+    }
+
+    if (mode_ == "benchmark-scan")
+    {
+        BOOST_ASSERT_MSG(benchmark_row_count_ > 0, "'benchmark-rows' must be > 0.");
+        return true;
+    }
+
+    if (mode_ == "benchmark-cik-filter")
+    {
+        BOOST_ASSERT_MSG(benchmark_lookup_count_ > 0, "'benchmark-lookups' must be > 0.");
+        return true;
+    }
+
+    if (mode_ == "migrate-layout")
+    {
+        BOOST_ASSERT_MSG(!local_form_file_directory_.empty(), "Must specify 'form-dir' when changing its layout.");
+        BOOST_ASSERT_MSG(!form_dir_layout_.empty(), "Must specify 'form-dir-layout' when changing layouts.");
+        return true;
+    }
+
+    if (mode_ == "export")
+    {
+        BOOST_ASSERT_MSG(!local_form_file_directory_.empty(), "Must specify 'form-dir' when exporting segments.");
+        BOOST_ASSERT_MSG(!export_directory_.empty(), "Must specify 'export-dir' when exporting segments.");
+        return true;
+    }
+
+    if (mode_ == "train-dictionaries")
+    {
+        BOOST_ASSERT_MSG(!local_form_file_directory_.empty(), "Must specify 'form-dir' when making dictionaries.");
+        form_list_ = split_string_to_strings(form_, ',');
+        return true;
+    }
+
+    // the content store links files together so they can't be compressed
+    // one at a time.
+
+    BOOST_ASSERT_MSG(!(compress_forms_ && use_content_store_),
+                     "Can't use 'compress-forms' and 'content-store' together.");
+
+    BOOST_ASSERT_MSG(commit_batch_size_ > 0 && commit_interval_ > 0,
+                     "'commit-batch-size' and 'commit-interval' must be > 0.");
+
     if (!start_date_.empty())
     {
         std::istringstream in{start_date_};
@@ -302,6 +428,19 @@ bool CollectorApp::CheckArgs()
         BOOST_ASSERT_MSG(end_date_.ok(), catenate("Invalid end date: ", stop_date_).c_str());
     }
 
+    // queries are answered from the index files we already have.  Dates are
+    // optional there.
+
+    if (mode_ == "query")
+    {
+        BOOST_ASSERT_MSG(!local_index_file_directory_.empty(), "Must specify 'index-dir' when querying the catalog.");
+        if (!form_.empty())
+        {
+            form_list_ = split_string_to_strings(form_, ',');
+        }
+        return true;
+    }
+
     BOOST_ASSERT_MSG(!start_date_.empty(),
                      "Must specify 'begin-date' for index and/or form downloads "
                      "and/or notes files downloads.");
@@ -377,6 +516,38 @@ void CollectorApp::Run()
     {
         Do_Run_FinancialNotesDownload();
     }
+    else if (mode_ == "query")
+    {
+        Do_Run_CatalogQuery();
+    }
+    else if (mode_ == "export")
+    {
+        Do_Run_SegmentExport();
+    }
+    else if (mode_ == "train-dictionaries")
+    {
+        Do_Run_TrainDictionaries();
+    }
+    else if (mode_ == "migrate-layout")
+    {
+        Do_Run_MigrateFormDirectoryLayout();
+    }
+    else if (mode_ == "benchmark-writes")
+    {
+        Do_Run_BenchmarkFileWriters();
+    }
+    else if (mode_ == "benchmark-scan")
+    {
+        Do_Run_BenchmarkIndexScan();
+    }
+    else if (mode_ == "benchmark-cik-filter")
+    {
+        Do_Run_BenchmarkCIKFilter();
+    }
+    else if (mode_ == "benchmark-segments")
+    {
+        Do_Run_BenchmarkSegmentStore();
+    }
     else if (mode_ == "daily")
     {
         Do_Run_DailyIndexFiles();
@@ -386,6 +557,41 @@ void CollectorApp::Run()
         Do_Run_QuarterlyIndexFiles();
     }
 
+    if (content_store_)
+    {
+        content_store_->LogStatistics();
+    }
+    if (segment_store_)
+    {
+        segment_store_->LogStatistics();
+    }
+    if (form_file_compressor_)
+    {
+        form_file_compressor_->WaitForAllTasks();
+        form_file_compressor_->LogStatistics();
+    }
+
+    if (file_writer_)
+    {
+        file_writer_->LogStatistics();
+    }
+
+    // after the compressor.  It commits the files it makes too.
+
+    if (group_commit_)
+    {
+        group_commit_->Flush();
+        group_commit_->LogStatistics();
+    }
+
+    // after group commit.  Filings are done when their files are committed.
+
+    if (run_journal_)
+    {
+        run_journal_->Flush();
+        run_journal_->LogStatistics();
+    }
+
 } // -----  end of method CollectorApp::Do_Run  -----
 
 void CollectorApp::Do_Run_TickerDownload()
@@ -411,51 +617,105 @@ void CollectorApp::Do_Run_TickerFileLookup()
 void CollectorApp::Do_Run_DailyIndexFiles()
 {
     // FTP_Server a_server{"localhost", "anonymous", "aaa@bbb.net"};
-    DailyIndexFileRetriever idxFileRet{HTTPS_host_, HTTPS_port_, "/Archives/edgar/daily-index"};
+    DailyIndexFileRetriever idxFileRet{HTTPS_host_, HTTPS_port_, "/Archives/edgar/daily-index",
+                                       use_form_index_ ? COL::IndexFileType::form : COL::IndexFileType::master};
 
     Do_TickerMap_Setup();
+    Do_Storage_Setup();
+    idxFileRet.UseDownloadManifest(index_manifest_.get());
 
     if (begin_date_ == end_date_)
     {
-        auto remote_daily_index_file_name = idxFileRet.FindRemoteIndexFileNameNearestDate(this->begin_date_);
-        auto local_daily_index_file_name = idxFileRet.HierarchicalCopyRemoteIndexFileTo(
-            remote_daily_index_file_name, this->local_index_file_directory_, replace_index_files_);
-
-        if (!index_only_)
+        if (index_only_)
         {
+            auto remote_daily_index_file_name = idxFileRet.FindRemoteIndexFileNameNearestDate(this->begin_date_);
+            idxFileRet.HierarchicalCopyRemoteIndexFileTo(remote_daily_index_file_name,
+                                                         this->local_index_file_directory_, replace_index_files_);
+        }
+        else
+        {
+            // we may end up with the index file for a nearby date so don't
+            // filter on the date we were given.
+
             FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
-            decltype(auto) form_file_list =
-                form_file_getter.FindFilesForForms(form_list_, local_daily_index_file_name, ticker_map_);
+            Do_FormFileRetriever_Setup(form_file_getter, false);
 
-            if (max_forms_to_download_ > -1)
+            // a resumed run takes its plan from the run journal and skips all
+            // of this.
+
+            auto make_plan = [&]()
             {
-                for (auto &[form, files] : form_file_list)
+                auto remote_daily_index_file_name = idxFileRet.FindRemoteIndexFileNameNearestDate(this->begin_date_);
+
+                // look for our forms while the index file downloads so the list
+                // is ready as soon as the download is done.
+
+                IndexStreamFilter index_filter{form_file_getter, form_list_, ticker_map_};
+                auto local_daily_index_file_name = idxFileRet.HierarchicalCopyRemoteIndexFileTo(
+                    remote_daily_index_file_name, this->local_index_file_directory_, replace_index_files_,
+                    [&index_filter](COL::sview index_data) { index_filter.AddData(index_data); });
+                decltype(auto) form_file_list = index_filter.Finish(local_daily_index_file_name);
+
+                if (max_forms_to_download_ > -1)
                 {
                     // I don't remember why I'm doing this...it's for testing !!
                     // If we are downloading only some of the files possible
                     // to download, then take a random selection of those files.
 
-                    if (files.size() > max_forms_to_download_)
-                    {
-                        std::default_random_engine dre;
-                        std::shuffle(files.begin(), files.end(), dre);
-                        files.resize(max_forms_to_download_);
-                    }
+                    form_file_list.LimitFilingsPerFormType(max_forms_to_download_);
                 }
-            }
-            form_file_getter.ConcurrentlyRetrieveSpecifiedFiles(form_file_list, this->local_form_file_directory_,
-                                                                max_at_a_time_, replace_form_files_);
+                return form_file_list;
+            };
+            form_file_getter.RetrieveFilesForPlan(RunJournal::k_all_index_files, make_plan,
+                                                  this->local_form_file_directory_, max_at_a_time_,
+                                                  replace_form_files_);
         }
     }
-    else
+    else if (!index_only_ && max_forms_to_download_ < 0)
+    {
+        // start on the form files for each index file as soon as we have it
+        // instead of waiting for all the index files.  (Picking a random
+        // sample of forms needs the whole list so that still does it the
+        // other way.)
+
+        auto remote_daily_index_file_list = Do_Journal_IndexFiles(
+            [&]() { return idxFileRet.FindRemoteIndexFileNamesForDateRange(begin_date_, end_date_); });
+
+        FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
+        Do_FormFileRetriever_Setup(form_file_getter);
+
+        auto copy_index_file = [this, &idxFileRet](const fs::path &remote_index_file_name,
+                                                   const HTTPS_Downloader::DataHandler &handle_data)
+        {
+            return idxFileRet.HierarchicalCopyRemoteIndexFileTo(remote_index_file_name, local_index_file_directory_,
+                                                                replace_index_files_, handle_data);
+        };
+        form_file_getter.RetrieveFilesForFormsAsIndexFilesArrive(form_list_, remote_daily_index_file_list,
+                                                                 copy_index_file, ticker_map_,
+                                                                 local_form_file_directory_, max_at_a_time_,
+                                                                 replace_form_files_);
+    }
+    else if (index_only_)
     {
         auto remote_daily_index_file_list = idxFileRet.FindRemoteIndexFileNamesForDateRange(begin_date_, end_date_);
-        auto local_daily_index_file_list = idxFileRet.ConcurrentlyHierarchicalCopyIndexFilesForDateRangeTo(
+        idxFileRet.ConcurrentlyHierarchicalCopyIndexFilesForDateRangeTo(
             remote_daily_index_file_list, local_index_file_directory_, max_at_a_time_, replace_index_files_);
+    }
+    else
+    {
+        FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
+        Do_FormFileRetriever_Setup(form_file_getter);
+
+        // a resumed run takes its plan from the run journal and skips all of
+        // this.
 
-        if (!index_only_)
+        auto make_plan = [&]()
         {
-            FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
+            auto remote_daily_index_file_list =
+                idxFileRet.FindRemoteIndexFileNamesForDateRange(begin_date_, end_date_);
+            auto local_daily_index_file_list = idxFileRet.ConcurrentlyHierarchicalCopyIndexFilesForDateRangeTo(
+                remote_daily_index_file_list, local_index_file_directory_, max_at_a_time_, replace_index_files_);
+
             decltype(auto) form_file_list =
                 form_file_getter.FindFilesForForms(form_list_, local_daily_index_file_list, ticker_map_);
 
@@ -463,19 +723,12 @@ void CollectorApp::Do_Run_DailyIndexFiles()
             {
                 // same comment here as above for single file.
 
-                for (auto &[form, files] : form_file_list)
-                {
-                    if (files.size() > max_forms_to_download_)
-                    {
-                        std::default_random_engine dre;
-                        std::shuffle(files.begin(), files.end(), dre);
-                        files.resize(max_forms_to_download_);
-                    }
-                }
+                form_file_list.LimitFilingsPerFormType(max_forms_to_download_);
             }
-            form_file_getter.ConcurrentlyRetrieveSpecifiedFiles(form_file_list, local_form_file_directory_,
-                                                                max_at_a_time_, replace_form_files_);
-        }
+            return form_file_list;
+        };
+        form_file_getter.RetrieveFilesForPlan(RunJournal::k_all_index_files, make_plan, local_form_file_directory_,
+                                              max_at_a_time_, replace_form_files_);
     }
 
 } // -----  end of method CollectorApp::Do_Run_DailyIndexFiles  -----
@@ -484,67 +737,213 @@ void CollectorApp::Do_Run_QuarterlyIndexFiles()
 {
     Do_TickerMap_Setup();
 
-    QuarterlyIndexFileRetriever idxFileRet{HTTPS_host_, HTTPS_port_, "/Archives/edgar/full-index"};
+    QuarterlyIndexFileRetriever idxFileRet{HTTPS_host_, HTTPS_port_, "/Archives/edgar/full-index",
+                                           use_form_index_ ? COL::IndexFileType::form : COL::IndexFileType::master};
+
+    Do_Storage_Setup();
+    idxFileRet.UseDownloadManifest(index_manifest_.get());
 
     if (begin_date_ == end_date_)
     {
         auto remote_quarterly_index_file_name = idxFileRet.MakeQuarterlyIndexPathName(begin_date_);
-        auto local_quarterly_index_file_name = idxFileRet.HierarchicalCopyRemoteIndexFileTo(
-            remote_quarterly_index_file_name, this->local_index_file_directory_, replace_index_files_);
 
-        if (!index_only_)
+        if (index_only_)
+        {
+            idxFileRet.HierarchicalCopyRemoteIndexFileTo(remote_quarterly_index_file_name,
+                                                         this->local_index_file_directory_, replace_index_files_);
+        }
+        else
         {
             FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
-            decltype(auto) form_file_list =
-                form_file_getter.FindFilesForForms(form_list_, local_quarterly_index_file_name, ticker_map_);
+            Do_FormFileRetriever_Setup(form_file_getter);
 
-            if (max_forms_to_download_ > -1)
+            // quarterly index files come as zip archives which can't be
+            // expanded until the download is done so this usually ends up
+            // searching the local file.
+
+            auto make_plan = [&]()
             {
-                for (auto &[form, files] : form_file_list)
+                IndexStreamFilter index_filter{form_file_getter, form_list_, ticker_map_};
+                auto local_quarterly_index_file_name = idxFileRet.HierarchicalCopyRemoteIndexFileTo(
+                    remote_quarterly_index_file_name, this->local_index_file_directory_, replace_index_files_,
+                    [&index_filter](COL::sview index_data) { index_filter.AddData(index_data); });
+                decltype(auto) form_file_list = index_filter.Finish(local_quarterly_index_file_name);
+
+                if (max_forms_to_download_ > -1)
                 {
-                    if (files.size() > max_forms_to_download_)
-                    {
-                        std::default_random_engine dre;
-                        std::shuffle(files.begin(), files.end(), dre);
-                        files.resize(max_forms_to_download_);
-                    }
+                    form_file_list.LimitFilingsPerFormType(max_forms_to_download_);
                 }
-            }
-            form_file_getter.ConcurrentlyRetrieveSpecifiedFiles(form_file_list, this->local_form_file_directory_,
-                                                                max_at_a_time_, replace_form_files_);
+                return form_file_list;
+            };
+            form_file_getter.RetrieveFilesForPlan(remote_quarterly_index_file_name.string(), make_plan,
+                                                  this->local_form_file_directory_, max_at_a_time_,
+                                                  replace_form_files_);
         }
     }
-    else
+    else if (!index_only_ && max_forms_to_download_ < 0)
+    {
+        // start on the form files for each index file as soon as we have it
+        // instead of waiting for all the index files.  (Picking a random
+        // sample of forms needs the whole list so that still does it the
+        // other way.)
+
+        // there's no listing to save here but a resumed run should still work
+        // from the same index files it started with.
+
+        auto remote_index_file_list = Do_Journal_IndexFiles(
+            [&]() { return idxFileRet.MakeIndexFileNamesForDateRange(begin_date_, end_date_); });
+
+        FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
+        Do_FormFileRetriever_Setup(form_file_getter);
+
+        auto copy_index_file = [this, &idxFileRet](const fs::path &remote_index_file_name,
+                                                   const HTTPS_Downloader::DataHandler &handle_data)
+        {
+            return idxFileRet.HierarchicalCopyRemoteIndexFileTo(remote_index_file_name, local_index_file_directory_,
+                                                                replace_index_files_, handle_data);
+        };
+        form_file_getter.RetrieveFilesForFormsAsIndexFilesArrive(form_list_, remote_index_file_list,
+                                                                 copy_index_file, ticker_map_,
+                                                                 local_form_file_directory_, max_at_a_time_,
+                                                                 replace_form_files_);
+    }
+    else if (index_only_)
     {
         auto remote_index_file_list = idxFileRet.MakeIndexFileNamesForDateRange(begin_date_, end_date_);
-        auto local_index_file_list = idxFileRet.ConcurrentlyHierarchicalCopyIndexFilesForDateRangeTo(
+        idxFileRet.ConcurrentlyHierarchicalCopyIndexFilesForDateRangeTo(
             remote_index_file_list, local_index_file_directory_, max_at_a_time_, replace_index_files_);
+    }
+    else
+    {
+        FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
+        Do_FormFileRetriever_Setup(form_file_getter);
 
-        if (!index_only_)
+        auto make_plan = [&]()
         {
-            FormFileRetriever form_file_getter{HTTPS_host_, HTTPS_port_};
+            auto remote_index_file_list = idxFileRet.MakeIndexFileNamesForDateRange(begin_date_, end_date_);
+            auto local_index_file_list = idxFileRet.ConcurrentlyHierarchicalCopyIndexFilesForDateRangeTo(
+                remote_index_file_list, local_index_file_directory_, max_at_a_time_, replace_index_files_);
+
             decltype(auto) form_file_list =
                 form_file_getter.FindFilesForForms(form_list_, local_index_file_list, ticker_map_);
 
             if (max_forms_to_download_ > -1)
             {
-                for (auto &[form, files] : form_file_list)
-                {
-                    if (files.size() > max_forms_to_download_)
-                    {
-                        std::default_random_engine dre;
-                        std::shuffle(files.begin(), files.end(), dre);
-                        files.resize(max_forms_to_download_);
-                    }
-                }
+                form_file_list.LimitFilingsPerFormType(max_forms_to_download_);
             }
-            form_file_getter.ConcurrentlyRetrieveSpecifiedFiles(form_file_list, local_form_file_directory_,
-                                                                max_at_a_time_, replace_form_files_);
-        }
+            return form_file_list;
+        };
+        form_file_getter.RetrieveFilesForPlan(RunJournal::k_all_index_files, make_plan, local_form_file_directory_,
+                                              max_at_a_time_, replace_form_files_);
     }
 
 } // -----  end of method CollectorApp::Do_Run_QuarterlyIndexFiles  -----
 
+void CollectorApp::Do_Run_CatalogQuery()
+{
+    // everything here comes from index files we have already downloaded.
+    // There is no network access at all.
+
+    Do_TickerMap_Setup();
+
+    const auto catalog_file_name =
+        catalog_file_name_.empty() ? local_index_file_directory_ / "filing_catalog.ccat" : catalog_file_name_;
+
+    const auto catalog = FilingCatalog::OpenForIndexDirectory(catalog_file_name, local_index_file_directory_);
+
+    const FormTypeMatcher form_matcher{form_list_};
+    const CIKFilter cik_filter{ticker_map_};
+
+    std::optional<std::chrono::sys_days> begin_date;
+    std::optional<std::chrono::sys_days> end_date;
+    if (!start_date_.empty())
+    {
+        begin_date = std::chrono::sys_days{begin_date_};
+    }
+    if (!stop_date_.empty())
+    {
+        end_date = std::chrono::sys_days{end_date_};
+    }
+
+    const auto query_start = std::chrono::steady_clock::now();
+
+    const auto filings = catalog.FindFilings(form_matcher, cik_filter, begin_date, end_date);
+
+    const std::chrono::duration<double> query_time = std::chrono::steady_clock::now() - query_start;
+
+    for (const auto row : filings)
+    {
+        std::cout << std::format("{}\t{}\t{:%F}\t{}\n", catalog.GetFormType(row), catalog.GetCIK(row),
+                                 catalog.GetDateFiled(row), catalog.GetFileName(row));
+    }
+
+    spdlog::info(std::format("Found {} filings in catalog of {} filings in {:.3f} seconds.", filings.size(),
+                             catalog.GetRowCount(), query_time.count()));
+
+} // -----  end of method CollectorApp::Do_Run_CatalogQuery  -----
+
+void CollectorApp::Do_Run_SegmentExport()
+{
+    // back to one file per filing.  Nothing is downloaded.
+
+    const SegmentStore segment_store{local_form_file_directory_ / ".segments", segment_form_list_};
+    segment_store.ExportTo(export_directory_, replace_form_files_, Do_FormDirectoryLayout_Setup(export_directory_));
+
+} // -----  end of method CollectorApp::Do_Run_SegmentExport  -----
+
+void CollectorApp::Do_Run_TrainDictionaries()
+{
+    const auto layout = Do_FormDirectoryLayout_Setup(local_form_file_directory_);
+    for (const auto &form_type : form_list_)
+    {
+        FormFileCompressor::TrainDictionary(local_form_file_directory_, form_type,
+                                            local_form_file_directory_ / ".dictionaries", layout);
+    }
+
+} // -----  end of method CollectorApp::Do_Run_TrainDictionaries  -----
+
+void CollectorApp::Do_Run_MigrateFormDirectoryLayout()
+{
+    const auto from_layout = ReadFormDirectoryLayout(local_form_file_directory_).value_or(FormDirectoryLayout::e_flat);
+    const auto to_layout = FormDirectoryLayoutFromString(form_dir_layout_);
+
+    MigrateFormDirectory(local_form_file_directory_, from_layout, to_layout);
+
+    // every path in the download manifest just changed.
+
+    if (use_download_manifest_)
+    {
+        DownloadManifest form_manifest{local_form_file_directory_, true};
+    }
+
+} // -----  end of method CollectorApp::Do_Run_MigrateFormDirectoryLayout  -----
+
+void CollectorApp::Do_Run_BenchmarkFileWriters()
+{
+    // same number of writers as download threads.
+
+    BenchmarkFileWriters(local_form_file_directory_, benchmark_file_count_, benchmark_file_size_, max_at_a_time_);
+
+} // -----  end of method CollectorApp::Do_Run_BenchmarkFileWriters  -----
+
+void CollectorApp::Do_Run_BenchmarkIndexScan()
+{
+    BenchmarkIndexScan(benchmark_row_count_);
+
+} // -----  end of method CollectorApp::Do_Run_BenchmarkIndexScan  -----
+
+void CollectorApp::Do_Run_BenchmarkCIKFilter()
+{
+    BenchmarkCIKFilter(benchmark_lookup_count_);
+
+} // -----  end of method CollectorApp::Do_Run_BenchmarkCIKFilter  -----
+
+void CollectorApp::Do_Run_BenchmarkSegmentStore()
+{
+    BenchmarkSegmentStore(local_form_file_directory_, benchmark_file_count_, benchmark_file_size_);
+
+} // -----  end of method CollectorApp::Do_Run_BenchmarkSegmentStore  -----
+
 void CollectorApp::Do_TickerMap_Setup()
 {
     for (const auto &ticker : ticker_list_)
@@ -554,6 +953,133 @@ void CollectorApp::Do_TickerMap_Setup()
 
 } // -----  end of method CollectorApp::Do_TickerMap_Setup  -----
 
+FormDirectoryLayout CollectorApp::Do_FormDirectoryLayout_Setup(const fs::path &local_form_directory)
+{
+    // a form directory keeps the layout it was made with.  Changing it takes
+    // 'migrate-layout' mode.
+
+    const auto current_layout = ReadFormDirectoryLayout(local_form_directory);
+    if (form_dir_layout_.empty())
+    {
+        return current_layout.value_or(FormDirectoryLayout::e_flat);
+    }
+
+    const auto layout = FormDirectoryLayoutFromString(form_dir_layout_);
+    if (current_layout && *current_layout != layout)
+    {
+        throw std::runtime_error(catenate("Form directory: ", local_form_directory.string(), " uses the '",
+                                          FormDirectoryLayoutToString(*current_layout),
+                                          "' layout. Use 'migrate-layout' mode to change it."));
+    }
+    if (!current_layout && layout != FormDirectoryLayout::e_flat)
+    {
+        fs::create_directories(local_form_directory);
+        WriteFormDirectoryLayout(local_form_directory, layout);
+    }
+    return layout;
+
+} // -----  end of method CollectorApp::Do_FormDirectoryLayout_Setup  -----
+
+void CollectorApp::Do_Storage_Setup()
+{
+    // first so a resumed run knows what it has already done.
+
+    if (!journal_file_name_.empty())
+    {
+        run_journal_ = std::make_unique<RunJournal>(journal_file_name_, !resume_journal_file_name_.empty(),
+                                                    commit_batch_size_, std::chrono::milliseconds{commit_interval_});
+        if (!run_journal_->IsResumed())
+        {
+            run_journal_->SetArguments(tokens_.empty() ? std::vector<std::string>(mArgv + 1, mArgv + mArgc) : tokens_);
+        }
+    }
+
+    if (!index_only_)
+    {
+        form_directory_layout_ = Do_FormDirectoryLayout_Setup(local_form_file_directory_);
+    }
+
+    if (file_writer_name_ != "stream" && !index_only_)
+    {
+        file_writer_ = std::make_unique<FileWriter>(FileWriterBackendFromString(file_writer_name_));
+    }
+    if (durable_writes_ && !index_only_)
+    {
+        group_commit_ =
+            std::make_unique<GroupCommit>(commit_batch_size_, std::chrono::milliseconds{commit_interval_});
+    }
+    if (use_content_store_ && !index_only_)
+    {
+        content_store_ = std::make_unique<ContentStore>(local_form_file_directory_ / ".content");
+        content_store_->SyncNewContent(durable_writes_);
+    }
+    if (compress_forms_ && !index_only_)
+    {
+        form_file_compressor_ =
+            std::make_unique<FormFileCompressor>(local_form_file_directory_ / ".dictionaries", compression_level_);
+        form_file_compressor_->UseGroupCommit(group_commit_.get());
+    }
+    if (!segment_form_list_.empty() && !index_only_)
+    {
+        segment_store_ = std::make_unique<SegmentStore>(local_form_file_directory_ / ".segments", segment_form_list_);
+    }
+
+    if (!use_download_manifest_)
+    {
+        return;
+    }
+
+    index_manifest_ = std::make_unique<DownloadManifest>(local_index_file_directory_, reconcile_manifest_);
+    if (!index_only_)
+    {
+        form_manifest_ = std::make_unique<DownloadManifest>(local_form_file_directory_, reconcile_manifest_);
+    }
+
+} // -----  end of method CollectorApp::Do_Storage_Setup  -----
+
+void CollectorApp::Do_FormFileRetriever_Setup(FormFileRetriever &form_file_getter, bool filter_on_date_filed)
+{
+    form_file_getter.UseBinaryIndexFiles(use_binary_index_);
+    form_file_getter.UseQueryResultCache(use_query_cache_);
+    form_file_getter.UseDownloadManifest(form_manifest_.get());
+    form_file_getter.UseContentStore(content_store_.get());
+    form_file_getter.UseSegmentStore(segment_store_.get());
+    form_file_getter.UseFormFileCompressor(form_file_compressor_.get());
+    form_file_getter.UseGroupCommit(group_commit_.get());
+    form_file_getter.UseFileWriter(file_writer_.get());
+    form_file_getter.UseRunJournal(run_journal_.get());
+    form_file_getter.UseFormDirectoryLayout(form_directory_layout_);
+
+    // with just a begin date, we want everything in the index files we get
+    // (for quarterly files, the whole quarter the date falls in).  Otherwise,
+    // just the filings in the given date range.
+
+    if (filter_on_date_filed && !stop_date_.empty())
+    {
+        form_file_getter.FilterOnDateFiled(begin_date_, end_date_);
+    }
+} // -----  end of method CollectorApp::Do_FormFileRetriever_Setup  -----
+
+std::vector<fs::path> CollectorApp::Do_Journal_IndexFiles(
+    const std::function<std::vector<fs::path>()> &find_index_files)
+{
+    if (!run_journal_)
+    {
+        return find_index_files();
+    }
+
+    // saves listing the index directories again.
+
+    if (auto index_files = run_journal_->GetIndexFiles(); index_files)
+    {
+        spdlog::info(catenate("Using ", index_files->size(), " index files from run journal."));
+        return std::move(*index_files);
+    }
+    auto index_files = find_index_files();
+    run_journal_->SetIndexFiles(index_files);
+    return index_files;
+} // -----  end of method CollectorApp::Do_Journal_IndexFiles  -----
+
 void CollectorApp::Shutdown()
 {
     spdlog::info(catenate("\n\n*** End run ", LocalDateTimeAsString(std::chrono::system_clock::now()), " ***\n"));
@@ -40,6 +40,7 @@
 
 #include <chrono>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <memory>
 
@@ -50,8 +51,18 @@ namespace po = boost::program_options;
 
 #include <spdlog/spdlog.h>
 
+#include "FormDirectoryLayout.h"
 #include "TickerConverter.h"
 
+class ContentStore;
+class DownloadManifest;
+class FileWriter;
+class FormFileCompressor;
+class FormFileRetriever;
+class GroupCommit;
+class RunJournal;
+class SegmentStore;
+
 class CollectorApp
 {
 public:
@@ -80,6 +91,11 @@ protected:
     void ParseProgramOptions();
     void ParseProgramOptions(const std::vector<std::string> &tokens);
 
+    // fills in the options for a resumed run from its journal.  Options given
+    // now take precedence.
+
+    void StoreResumedOptions();
+
     void ConfigureLogging();
 
     bool CheckArgs();
@@ -90,8 +106,27 @@ protected:
     void Do_Run_TickerDownload();
     void Do_Run_TickerFileLookup();
     void Do_Run_FinancialNotesDownload();
+    void Do_Run_CatalogQuery();
+    void Do_Run_SegmentExport();
+    void Do_Run_TrainDictionaries();
+    void Do_Run_MigrateFormDirectoryLayout();
+    void Do_Run_BenchmarkFileWriters();
+    void Do_Run_BenchmarkIndexScan();
+    void Do_Run_BenchmarkCIKFilter();
+    void Do_Run_BenchmarkSegmentStore();
 
     void Do_TickerMap_Setup();
+    void Do_Storage_Setup();
+
+    // hands the retriever our storage options.  Call after Do_Storage_Setup.
+
+    void Do_FormFileRetriever_Setup(FormFileRetriever &form_file_getter, bool filter_on_date_filed = true);
+
+    // the remote index files from the run journal if it has them.  Otherwise
+    // from find_index_files, saved in the journal if we have one.
+
+    std::vector<fs::path> Do_Journal_IndexFiles(const std::function<std::vector<fs::path>()> &find_index_files);
+    FormDirectoryLayout Do_FormDirectoryLayout_Setup(const fs::path &local_form_directory);
 
     // ====================  DATA MEMBERS  =======================================
 
@@ -125,12 +160,29 @@ private:
     std::string HTTPS_host_{"www.sec.gov"};
     std::string HTTPS_port_{"443"};
     std::string logging_level_{"information"};
+    std::string segment_forms_;
+    std::string form_dir_layout_;
+    std::string file_writer_name_{"stream"};
 
     std::vector<std::string> form_list_;
     std::vector<std::string> ticker_list_;
+    std::vector<std::string> segment_form_list_;
 
     TickerConverter::TickerCIKMap ticker_map_;
 
+    std::unique_ptr<DownloadManifest> index_manifest_;
+    std::unique_ptr<DownloadManifest> form_manifest_;
+
+    // after the manifests and before anything that hands it files.  The run
+    // journal is told about files as they are committed.
+
+    std::unique_ptr<RunJournal> run_journal_;
+    std::unique_ptr<GroupCommit> group_commit_;
+    std::unique_ptr<ContentStore> content_store_;
+    std::unique_ptr<SegmentStore> segment_store_;
+    std::unique_ptr<FormFileCompressor> form_file_compressor_;
+    std::unique_ptr<FileWriter> file_writer_;
+
     fs::path log_file_path_name_;
     fs::path local_index_file_directory_;
     fs::path local_form_file_directory_;
@@ -139,15 +191,36 @@ private:
     fs::path financial_notes_directory_name_;
     fs::path new_forms_log_directory_name_;
     fs::path new_forms_log_file_name_;
+    fs::path catalog_file_name_;
+    fs::path export_directory_;
+    fs::path journal_file_name_;
+    fs::path resume_journal_file_name_;
+
+    FormDirectoryLayout form_directory_layout_{FormDirectoryLayout::e_flat};
 
     int pause_{0};
     int max_forms_to_download_{-1}; // mainly for testing
     int max_at_a_time_{10};         // how many concurrent downloads allowed
+    int compression_level_{9};
+    int commit_batch_size_{500};
+    int commit_interval_{1000};     // milliseconds
+    int benchmark_file_count_{100'000};
+    int benchmark_file_size_{4096};
+    int benchmark_row_count_{1'000'000};
+    int benchmark_lookup_count_{10'000'000};
 
     bool replace_index_files_{false};
     bool replace_form_files_{false};
     bool replace_notes_files_{false};
     bool index_only_{false}; //	do no download any form files
+    bool use_form_index_{false}; //	form.idx instead of master.idx
+    bool use_binary_index_{true};
+    bool use_query_cache_{true};
+    bool use_download_manifest_{true};
+    bool reconcile_manifest_{false};
+    bool use_content_store_{false};
+    bool compress_forms_{false};
+    bool durable_writes_{false};
     bool help_requested_{false};
     bool log_new_form_files_{false};
 
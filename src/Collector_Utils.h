@@ -41,6 +41,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <boost/assert.hpp>
 
@@ -70,6 +71,21 @@ public:
 
 using sview = std::string_view;
 
+// EDGAR publishes the same index data sorted 2 ways.  'master' files are
+// sorted by CIK and use '|' delimiters.  'form' files are sorted by form type
+// and have fixed width columns.
+
+enum class IndexFileType
+{
+    master,
+    form
+};
+
+inline std::string IndexFileBaseName(IndexFileType index_file_type)
+{
+    return index_file_type == IndexFileType::form ? "form" : "master";
+}
+
 }; // namespace Collector
 
 namespace COL = Collector;
@@ -0,0 +1,417 @@
+// =====================================================================================
+//
+//       Filename:  CompressedFormFiles.cpp
+//
+//    Description:  Keeps downloaded form files zstd compressed and reads
+//                  them back whether they are compressed or not
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:27:04 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include "Collector_Utils.h"
+#include "CompressedFormFiles.h"
+#include "GroupCommit.h"
+
+namespace
+{
+constexpr const char *k_dictionary_extension = ".zdict";
+
+// zstd's suggested dictionary size and about 100 times that in samples.
+
+constexpr std::size_t k_dictionary_size = 112 * 1024;
+constexpr std::size_t k_max_sample_bytes = 100 * k_dictionary_size;
+constexpr std::size_t k_max_sample_size = 128 * 1024;
+constexpr std::size_t k_min_sample_count = 8;
+
+void WriteFile(const fs::path &file_name, const char *data, std::size_t size)
+{
+    std::ofstream output{file_name, std::ios::out | std::ios::binary | std::ios::trunc};
+    output.write(data, static_cast<std::streamsize>(size));
+    output.close();
+    if (output.fail())
+    {
+        throw std::runtime_error(catenate("Unable to write file: ", file_name.string()));
+    }
+}
+
+std::string FormNameForFile(const fs::path &file_name)
+{
+    return file_name.parent_path().filename().string();
+}
+
+} // namespace
+
+fs::path MakeCompressedFileName(const fs::path &file_name)
+{
+    auto compressed_file_name = file_name;
+    compressed_file_name += ".zst";
+    return compressed_file_name;
+}
+
+//--------------------------------------------------------------------------------------
+//       Class:  FormFileCompressor
+//      Method:  FormFileCompressor
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+FormFileCompressor::FormFileCompressor(const fs::path &dictionary_directory, int compression_level, int max_threads)
+    : max_threads_{static_cast<std::size_t>(
+          max_threads > 0 ? max_threads : std::max(1U, std::thread::hardware_concurrency()))},
+      compression_level_{compression_level}
+{
+    if (!fs::exists(dictionary_directory))
+    {
+        return;
+    }
+    for (const auto &dir_entry : fs::directory_iterator(dictionary_directory))
+    {
+        // <form name>.<dictionary ID>.zdict are replaced dictionaries.
+
+        if (!dir_entry.is_regular_file() || dir_entry.path().extension() != k_dictionary_extension ||
+            dir_entry.path().stem().has_extension())
+        {
+            continue;
+        }
+        const auto dictionary = LoadDataFileForUse(dir_entry.path());
+        CDictPtr cdict{ZSTD_createCDict(dictionary.data(), dictionary.size(), compression_level_),
+                       [](ZSTD_CDict_s *cdict) { ZSTD_freeCDict(cdict); }};
+        if (!cdict)
+        {
+            spdlog::error(catenate("Z: Unable to use compression dictionary: ", dir_entry.path().string()));
+            continue;
+        }
+        dictionaries_.emplace(dir_entry.path().stem().string(), std::move(cdict));
+    }
+    spdlog::info(catenate("Z: Loaded ", dictionaries_.size(), " compression dictionaries from: ",
+                          dictionary_directory.string()));
+} // -----  end of method FormFileCompressor::FormFileCompressor  (constructor)  -----
+
+FormFileCompressor::~FormFileCompressor()
+{
+    WaitForAllTasks();
+} // -----  end of method FormFileCompressor::~FormFileCompressor  (destructor)  -----
+
+FormFileCompressor::Statistics FormFileCompressor::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock{statistics_mutex_};
+    return statistics_;
+} // -----  end of method FormFileCompressor::GetStatistics  -----
+
+void FormFileCompressor::LogStatistics() const
+{
+    const auto statistics = GetStatistics();
+    const double compression_ratio =
+        statistics.bytes_out > 0 ? static_cast<double>(statistics.bytes_in) / static_cast<double>(statistics.bytes_out)
+                                 : 1.0;
+
+    spdlog::info(std::format("Z: Compressed {} form files ({} with a dictionary). {} bytes to {} bytes. "
+                             "Compression ratio: {:.2f}. Errors: {}.",
+                             statistics.files_compressed, statistics.files_using_dictionary, statistics.bytes_in,
+                             statistics.bytes_out, compression_ratio, statistics.errors));
+} // -----  end of method FormFileCompressor::LogStatistics  -----
+
+void FormFileCompressor::CompressFile(const fs::path &file_name, FileDoneHandler file_done)
+{
+    if (tasks_.size() >= max_threads_)
+    {
+        FinishOldestTask();
+    }
+    tasks_.emplace_back(std::async(std::launch::async, [this, file_name, file_done = std::move(file_done)]() mutable
+                                   { Compress(file_name, std::move(file_done)); }));
+} // -----  end of method FormFileCompressor::CompressFile  -----
+
+void FormFileCompressor::WaitForAllTasks()
+{
+    while (!tasks_.empty())
+    {
+        FinishOldestTask();
+    }
+} // -----  end of method FormFileCompressor::WaitForAllTasks  -----
+
+void FormFileCompressor::FinishOldestTask()
+{
+    // a file we can't compress is left as it is.
+
+    auto task = std::move(tasks_.front());
+    tasks_.pop_front();
+    try
+    {
+        task.get();
+    }
+    catch (std::exception &e)
+    {
+        spdlog::error(catenate("Z: Unable to compress form file: ", e.what()));
+
+        std::lock_guard<std::mutex> lock{statistics_mutex_};
+        ++statistics_.errors;
+    }
+} // -----  end of method FormFileCompressor::FinishOldestTask  -----
+
+const ZSTD_CDict_s *FormFileCompressor::FindDictionary(const fs::path &file_name) const
+{
+    const auto found = dictionaries_.find(FormNameForFile(file_name));
+    return found != dictionaries_.end() ? found->second.get() : nullptr;
+} // -----  end of method FormFileCompressor::FindDictionary  -----
+
+void FormFileCompressor::Compress(const fs::path &file_name, FileDoneHandler file_done)
+{
+    const auto contents = LoadDataFileForUse(file_name);
+
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx{ZSTD_createCCtx(), &ZSTD_freeCCtx};
+    std::vector<char> compressed(ZSTD_compressBound(contents.size()));
+
+    const auto *dictionary = FindDictionary(file_name);
+    const auto compressed_size =
+        dictionary != nullptr
+            ? ZSTD_compress_usingCDict(cctx.get(), compressed.data(), compressed.size(), contents.data(),
+                                       contents.size(), dictionary)
+            : ZSTD_compressCCtx(cctx.get(), compressed.data(), compressed.size(), contents.data(), contents.size(),
+                                compression_level_);
+    if (ZSTD_isError(compressed_size))
+    {
+        throw std::runtime_error(catenate(file_name.string(), ": ", ZSTD_getErrorName(compressed_size)));
+    }
+
+    // the compressed file only gets its real name when it is all there.  A
+    // download still under its temp name is compressed to the name it would
+    // have had.
+
+    auto plain_file_name = file_name;
+    if (plain_file_name.extension() == ".tmp")
+    {
+        plain_file_name.replace_extension();
+    }
+    const auto compressed_file_name = MakeCompressedFileName(plain_file_name);
+    auto temp_file_name = compressed_file_name;
+    temp_file_name += ".tmp";
+    WriteFile(temp_file_name, compressed.data(), compressed_size);
+
+    {
+        std::lock_guard<std::mutex> lock{statistics_mutex_};
+        ++statistics_.files_compressed;
+        if (dictionary != nullptr)
+        {
+            ++statistics_.files_using_dictionary;
+        }
+        statistics_.bytes_in += contents.size();
+        statistics_.bytes_out += compressed_size;
+    }
+
+    auto finish = [file_name, compressed_file_name, file_done = std::move(file_done)]()
+    {
+        fs::remove(file_name);
+        if (file_done)
+        {
+            file_done(compressed_file_name);
+        }
+    };
+    if (group_commit_ != nullptr)
+    {
+        group_commit_->Commit(temp_file_name, compressed_file_name, std::move(finish));
+        return;
+    }
+    fs::rename(temp_file_name, compressed_file_name);
+    finish();
+} // -----  end of method FormFileCompressor::Compress  -----
+
+void FormFileCompressor::TrainDictionary(const fs::path &local_form_directory,
+                                         const std::string &form_type,
+                                         const fs::path &dictionary_directory,
+                                         FormDirectoryLayout layout)
+{
+    std::string form_name{form_type};
+    std::replace(form_name.begin(), form_name.end(), '/', '_');
+
+    // samples come from the <CIK>/<form name> directories.  Compressed files
+    // are fine as long as we can read them.
+
+    const FormFileReader reader{dictionary_directory};
+
+    std::string samples;
+    std::vector<std::size_t> sample_sizes;
+
+    ForEachCIKDirectory(local_form_directory, layout,
+                        [&](const fs::path &CIK_directory)
+                        {
+                            const auto form_directory = CIK_directory / form_name;
+                            if (samples.size() >= k_max_sample_bytes || !fs::is_directory(form_directory))
+                            {
+                                return;
+                            }
+                            for (const auto &file_entry : fs::directory_iterator(form_directory))
+                            {
+                                auto file_name = file_entry.path();
+                                if (file_name.extension() == ".tmp")
+                                {
+                                    continue;
+                                }
+                                if (file_name.extension() == ".zst")
+                                {
+                                    file_name.replace_extension();
+                                }
+
+                                // the start of a big file is as good a sample as any.
+
+                                auto sample = reader.ReadFile(file_name);
+                                sample.resize(std::min(sample.size(), k_max_sample_size));
+                                samples += sample;
+                                sample_sizes.push_back(sample.size());
+
+                                if (samples.size() >= k_max_sample_bytes)
+                                {
+                                    break;
+                                }
+                            }
+                        });
+
+    if (sample_sizes.size() < k_min_sample_count)
+    {
+        throw std::runtime_error(catenate("Only found ", sample_sizes.size(), " files for form type: ", form_type,
+                                          " in: ", local_form_directory.string(), ". Need at least ",
+                                          k_min_sample_count, " to make a dictionary."));
+    }
+
+    std::vector<char> dictionary(k_dictionary_size);
+    const auto dictionary_size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(),
+                                                       sample_sizes.data(), static_cast<unsigned>(sample_sizes.size()));
+    if (ZDICT_isError(dictionary_size))
+    {
+        throw std::runtime_error(catenate("Unable to make dictionary for form type: ", form_type, ". ",
+                                          ZDICT_getErrorName(dictionary_size)));
+    }
+
+    fs::create_directories(dictionary_directory);
+    auto dictionary_file_name = dictionary_directory / form_name;
+    dictionary_file_name += k_dictionary_extension;
+
+    // files compressed with the dictionary we are replacing still need it so
+    // it is kept as <form name>.<dictionary ID>.zdict.  The reader loads it
+    // but the compressor doesn't use it.
+
+    if (fs::exists(dictionary_file_name))
+    {
+        const auto old_dictionary = LoadDataFileForUse(dictionary_file_name);
+        auto old_dictionary_file_name = dictionary_directory / form_name;
+        old_dictionary_file_name +=
+            std::format(".{}{}", ZSTD_getDictID_fromDict(old_dictionary.data(), old_dictionary.size()),
+                        k_dictionary_extension);
+        fs::rename(dictionary_file_name, old_dictionary_file_name);
+    }
+    WriteFile(dictionary_file_name, dictionary.data(), dictionary_size);
+
+    spdlog::info(catenate("Z: Made dictionary: ", dictionary_file_name.string(), " (", dictionary_size,
+                          " bytes) from ", sample_sizes.size(), " files (", samples.size(), " bytes)."));
+} // -----  end of method FormFileCompressor::TrainDictionary  -----
+
+//--------------------------------------------------------------------------------------
+//       Class:  FormFileReader
+//      Method:  FormFileReader
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+FormFileReader::FormFileReader(const fs::path &dictionary_directory)
+{
+    if (!fs::exists(dictionary_directory))
+    {
+        return;
+    }
+    for (const auto &dir_entry : fs::directory_iterator(dictionary_directory))
+    {
+        if (!dir_entry.is_regular_file() || dir_entry.path().extension() != k_dictionary_extension)
+        {
+            continue;
+        }
+        const auto dictionary = LoadDataFileForUse(dir_entry.path());
+        DDictPtr ddict{ZSTD_createDDict(dictionary.data(), dictionary.size()),
+                       [](ZSTD_DDict_s *ddict) { ZSTD_freeDDict(ddict); }};
+        if (!ddict)
+        {
+            spdlog::error(catenate("Z: Unable to use compression dictionary: ", dir_entry.path().string()));
+            continue;
+        }
+        const auto dictionary_ID = ZSTD_getDictID_fromDDict(ddict.get());
+        dictionaries_.emplace(dictionary_ID, std::move(ddict));
+    }
+} // -----  end of method FormFileReader::FormFileReader  (constructor)  -----
+
+std::string FormFileReader::ReadFile(const fs::path &file_name) const
+{
+    if (fs::exists(file_name))
+    {
+        return LoadDataFileForUse(file_name);
+    }
+
+    const auto compressed_file_name = MakeCompressedFileName(file_name);
+    if (!fs::exists(compressed_file_name))
+    {
+        throw std::runtime_error(catenate("Can't find form file: ", file_name.string()));
+    }
+    const auto compressed = LoadDataFileForUse(compressed_file_name);
+
+    const auto expanded_size = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+    if (expanded_size == ZSTD_CONTENTSIZE_ERROR || expanded_size == ZSTD_CONTENTSIZE_UNKNOWN)
+    {
+        throw std::runtime_error(catenate("Not a form file we compressed: ", compressed_file_name.string()));
+    }
+
+    const ZSTD_DDict *dictionary = nullptr;
+    if (const auto dictionary_ID = ZSTD_getDictID_fromFrame(compressed.data(), compressed.size());
+        dictionary_ID != 0)
+    {
+        const auto found = dictionaries_.find(dictionary_ID);
+        if (found == dictionaries_.end())
+        {
+            throw std::runtime_error(catenate("Don't have dictionary: ", dictionary_ID,
+                                              " needed for: ", compressed_file_name.string()));
+        }
+        dictionary = found->second.get();
+    }
+
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx{ZSTD_createDCtx(), &ZSTD_freeDCtx};
+    std::string contents(expanded_size, '\0');
+    const auto result =
+        dictionary != nullptr
+            ? ZSTD_decompress_usingDDict(dctx.get(), contents.data(), contents.size(), compressed.data(),
+                                         compressed.size(), dictionary)
+            : ZSTD_decompressDCtx(dctx.get(), contents.data(), contents.size(), compressed.data(), compressed.size());
+    if (ZSTD_isError(result))
+    {
+        throw std::runtime_error(catenate(compressed_file_name.string(), ": ", ZSTD_getErrorName(result)));
+    }
+    return contents;
+} // -----  end of method FormFileReader::ReadFile  -----
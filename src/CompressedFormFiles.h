@@ -0,0 +1,220 @@
+// =====================================================================================
+//
+//       Filename:  CompressedFormFiles.h
+//
+//    Description:  Keeps downloaded form files zstd compressed and reads
+//                  them back whether they are compressed or not
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:27:04 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef COMPRESSEDFORMFILES_H_
+#define COMPRESSEDFORMFILES_H_
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "FormDirectoryLayout.h"
+
+namespace fs = std::filesystem;
+
+class GroupCommit;
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+// x.txt is kept as x.txt.zst
+
+fs::path MakeCompressedFileName(const fs::path &file_name);
+
+// =====================================================================================
+//        Class:  FormFileCompressor
+//  Description:  form files are plain text and compress very well.  With
+//                this, each form file is zstd compressed after it has been
+//                downloaded and the uncompressed file removed.
+//
+//                Compression is done on a few threads of our own so the
+//                download threads are never held up by it.
+//
+//                Small forms (3, 4, 5, 8-K, ...) don't have much in them for
+//                zstd to work with by themselves but they all look alike.
+//                TrainDictionary makes a dictionary for a form type from
+//                files we already have.  Files of a form type with a
+//                dictionary are compressed with it.  Dictionaries are kept
+//                in their own directory as <form name>.zdict.
+// =====================================================================================
+class FormFileCompressor
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t files_compressed = 0;
+        std::uint64_t files_using_dictionary = 0;
+        std::uint64_t bytes_in = 0;
+        std::uint64_t bytes_out = 0;
+        std::uint64_t errors = 0;
+    };
+
+    // told the name of each compressed file when it is done.  Called from
+    // one of our threads or, with group commit, once the file is committed.
+
+    using FileDoneHandler = std::function<void(const fs::path &)>;
+
+    // ====================  LIFECYCLE     =======================================
+
+    FormFileCompressor() = delete;
+
+    // max_threads <= 0 means use one thread per available core.
+
+    FormFileCompressor(const fs::path &dictionary_directory, int compression_level, int max_threads = 0);
+
+    FormFileCompressor(const FormFileCompressor &rhs) = delete;
+    FormFileCompressor(FormFileCompressor &&rhs) = delete;
+
+    // waits for any compressions still going.
+
+    ~FormFileCompressor();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    void LogStatistics() const;
+
+    // makes a dictionary for form_type from the files for it in
+    // local_form_directory and saves it in dictionary_directory.
+
+    static void TrainDictionary(const fs::path &local_form_directory,
+                                const std::string &form_type,
+                                const fs::path &dictionary_directory,
+                                FormDirectoryLayout layout = FormDirectoryLayout::e_flat);
+
+    // ====================  MUTATORS      =======================================
+
+    FormFileCompressor &operator=(const FormFileCompressor &rhs) = delete;
+    FormFileCompressor &operator=(FormFileCompressor &&rhs) = delete;
+
+    // queues up the file to be compressed and returns.  If there is already
+    // a compression going on each of our threads, waits for the oldest one
+    // first.  Call from one thread only.
+
+    void CompressFile(const fs::path &file_name, FileDoneHandler file_done = {});
+
+    void WaitForAllTasks();
+
+    // compressed files are handed to group_commit to be given their real
+    // names once they are safely on disk.
+
+    void UseGroupCommit(GroupCommit *group_commit)
+    {
+        group_commit_ = group_commit;
+    }
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // the form name is the name of the directory the file is in.
+
+    [[nodiscard]] const ZSTD_CDict_s *FindDictionary(const fs::path &file_name) const;
+
+    void Compress(const fs::path &file_name, FileDoneHandler file_done);
+    void FinishOldestTask();
+
+    // ====================  DATA MEMBERS  =======================================
+
+    using CDictPtr = std::unique_ptr<ZSTD_CDict_s, void (*)(ZSTD_CDict_s *)>;
+
+    std::map<std::string, CDictPtr, std::less<>> dictionaries_;
+
+    std::deque<std::future<void>> tasks_;
+    std::size_t max_threads_;
+    int compression_level_;
+
+    GroupCommit *group_commit_ = nullptr;
+
+    Statistics statistics_;
+    mutable std::mutex statistics_mutex_;
+
+}; // -----  end of class FormFileCompressor  -----
+
+// =====================================================================================
+//        Class:  FormFileReader
+//  Description:  reads a form file whether it is compressed or not.  A
+//                compressed file says which dictionary (if any) it was made
+//                with so all the dictionaries are loaded up front.
+// =====================================================================================
+class FormFileReader
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    FormFileReader() = delete;
+    explicit FormFileReader(const fs::path &dictionary_directory);
+
+    FormFileReader(const FormFileReader &rhs) = delete;
+    FormFileReader(FormFileReader &&rhs) = delete;
+
+    ~FormFileReader() = default;
+
+    // ====================  ACCESSORS     =======================================
+
+    // file_name is the uncompressed name.  If that isn't there, the
+    // compressed file is read and expanded.  Safe to call from any thread.
+
+    [[nodiscard]] std::string ReadFile(const fs::path &file_name) const;
+
+    // ====================  MUTATORS      =======================================
+
+    FormFileReader &operator=(const FormFileReader &rhs) = delete;
+    FormFileReader &operator=(FormFileReader &&rhs) = delete;
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // ====================  DATA MEMBERS  =======================================
+
+    using DDictPtr = std::unique_ptr<ZSTD_DDict_s, void (*)(ZSTD_DDict_s *)>;
+
+    // by dictionary ID.
+
+    std::map<unsigned, DDictPtr> dictionaries_;
+
+}; // -----  end of class FormFileReader  -----
+
+#endif /* COMPRESSEDFORMFILES_H_ */
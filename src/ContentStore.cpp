@@ -0,0 +1,179 @@
+// =====================================================================================
+//
+//       Filename:  ContentStore.cpp
+//
+//    Description:  Keeps one copy of each distinct downloaded file, named by
+//                  its content hash
+//
+//        Version:  1.0
+//        Created:  10/19/2026 10:03:51 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <cerrno>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "Collector_Utils.h"
+#include "ContentStore.h"
+
+namespace
+{
+void SyncFile(const fs::path &file_name)
+{
+    const int fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1 || ::fdatasync(fd) != 0)
+    {
+        std::error_code ec{errno, std::system_category()};
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+        throw std::system_error{ec, catenate("Unable to sync new content: ", file_name.string())};
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  ContentStore
+//      Method:  ContentStore
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+ContentStore::ContentStore(const fs::path &store_directory) : store_directory_{store_directory}
+{
+    fs::create_directories(store_directory_);
+} // -----  end of method ContentStore::ContentStore  (constructor)  -----
+
+ContentStore::Statistics ContentStore::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    return statistics_;
+} // -----  end of method ContentStore::GetStatistics  -----
+
+fs::path ContentStore::MakeContentFileName(const std::string &content_hash) const
+{
+    BOOST_ASSERT_MSG(content_hash.size() > 2, catenate("Content hash is too short: ", content_hash).c_str());
+
+    auto content_file_name = store_directory_;
+    content_file_name /= content_hash.substr(0, 2);
+    content_file_name /= content_hash;
+    return content_file_name;
+} // -----  end of method ContentStore::MakeContentFileName  -----
+
+fs::path ContentStore::MakeDownloadFileName(const fs::path &file_name)
+{
+    auto download_file_name = file_name;
+    download_file_name += ".tmp";
+    return download_file_name;
+} // -----  end of method ContentStore::MakeDownloadFileName  -----
+
+void ContentStore::LogStatistics() const
+{
+    const auto statistics = GetStatistics();
+
+    // the dedup ratio is what the files would take without the store over
+    // what they do take.
+
+    const auto all_bytes = statistics.bytes_stored + statistics.bytes_linked;
+    const double dedup_ratio =
+        statistics.bytes_stored > 0 ? static_cast<double>(all_bytes) / static_cast<double>(statistics.bytes_stored)
+                                    : 1.0;
+
+    spdlog::info(std::format("S: Content store: {}. New files: {} ({} bytes). Already stored: {} ({} bytes). "
+                             "Copied instead of linked: {}. Dedup ratio: {:.2f}.",
+                             store_directory_.string(), statistics.files_stored, statistics.bytes_stored,
+                             statistics.files_linked, statistics.bytes_linked, statistics.files_copied, dedup_ratio));
+} // -----  end of method ContentStore::LogStatistics  -----
+
+void ContentStore::AddFile(const fs::path &downloaded_file_name,
+                           const std::string &content_hash,
+                           const fs::path &file_name)
+{
+    const auto content_file_name = MakeContentFileName(content_hash);
+    const auto file_size = fs::file_size(downloaded_file_name);
+
+    // done before taking the lock.  At worst, content someone else is
+    // storing right now gets flushed for nothing.
+
+    if (sync_new_content_ && !fs::exists(content_file_name))
+    {
+        SyncFile(downloaded_file_name);
+    }
+
+    bool already_stored = false;
+    {
+        // two downloads of the same content can finish at the same time so
+        // deciding which one is stored has to be done one at a time.
+
+        std::lock_guard<std::mutex> lock{store_mutex_};
+
+        already_stored = fs::exists(content_file_name);
+        if (already_stored)
+        {
+            fs::remove(downloaded_file_name);
+            ++statistics_.files_linked;
+            statistics_.bytes_linked += file_size;
+        }
+        else
+        {
+            if (made_directories_.insert(content_file_name.parent_path().string()).second)
+            {
+                fs::create_directories(content_file_name.parent_path());
+            }
+            fs::rename(downloaded_file_name, content_file_name);
+            ++statistics_.files_stored;
+            statistics_.bytes_stored += file_size;
+        }
+    }
+
+    // the downloaded file's name is free now so use it to make the link then
+    // rename it into place.  That replaces any old file in one step.
+
+    std::error_code ec;
+    fs::create_hard_link(content_file_name, downloaded_file_name, ec);
+    if (ec)
+    {
+        // too many links or some other file system.  Fall back to a copy.
+
+        spdlog::debug(catenate("S: Can't link: ", file_name.string(), " to: ", content_file_name.string(), ". ",
+                               ec.message(), " Copying instead."));
+        fs::copy_file(content_file_name, downloaded_file_name, fs::copy_options::overwrite_existing);
+
+        std::lock_guard<std::mutex> lock{store_mutex_};
+        ++statistics_.files_copied;
+    }
+    fs::rename(downloaded_file_name, file_name);
+
+    spdlog::debug(catenate("S: ", already_stored ? "Linked existing content: " : "Stored new content: ",
+                           content_hash, " for: ", file_name.string()));
+} // -----  end of method ContentStore::AddFile  -----
@@ -0,0 +1,138 @@
+// =====================================================================================
+//
+//       Filename:  ContentStore.h
+//
+//    Description:  Keeps one copy of each distinct downloaded file, named by
+//                  its content hash
+//
+//        Version:  1.0
+//        Created:  10/19/2026 10:03:51 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef CONTENTSTORE_H_
+#define CONTENTSTORE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  ContentStore
+//  Description:  the same filing can be downloaded for more than one form
+//                directory (10-K and 10-K/A runs, overlapping daily and
+//                quarterly runs) and used to be saved again each time.
+//
+//                With a content store, each downloaded file is hashed as it
+//                arrives and kept once, under its hash, in the store
+//                directory.  The usual <CIK>/<form type>/<file> name is a
+//                hard link to that copy.  The store directory must be on the
+//                same file system as the form directories.
+// =====================================================================================
+class ContentStore
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t files_stored = 0;  // new content
+        std::uint64_t bytes_stored = 0;
+        std::uint64_t files_linked = 0;  // content we already had
+        std::uint64_t bytes_linked = 0;
+        std::uint64_t files_copied = 0;  // couldn't link so made a copy
+    };
+
+    // ====================  LIFECYCLE     =======================================
+
+    ContentStore() = delete;
+    explicit ContentStore(const fs::path &store_directory);
+
+    ContentStore(const ContentStore &rhs) = delete;
+    ContentStore(ContentStore &&rhs) = delete;
+
+    ~ContentStore() = default;
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] const fs::path &GetStoreDirectory() const
+    {
+        return store_directory_;
+    }
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    // <store directory>/<first 2 hex digits>/<hash>
+
+    [[nodiscard]] fs::path MakeContentFileName(const std::string &content_hash) const;
+
+    // download to this name then call AddFile.  Ends in '.tmp' so it is
+    // ignored if we don't get that far.
+
+    [[nodiscard]] static fs::path MakeDownloadFileName(const fs::path &file_name);
+
+    // logs what this run added to the store.
+
+    void LogStatistics() const;
+
+    // ====================  MUTATORS      =======================================
+
+    ContentStore &operator=(const ContentStore &rhs) = delete;
+    ContentStore &operator=(ContentStore &&rhs) = delete;
+
+    // moves the downloaded file into the store (or drops it if we already
+    // have its content) and puts a link to the stored copy at file_name,
+    // replacing anything there.  Safe to call from any thread.
+
+    void AddFile(const fs::path &downloaded_file_name, const std::string &content_hash, const fs::path &file_name);
+
+    // every name in the form directories can point at a stored file so new
+    // content is flushed to disk before it goes into the store.
+
+    void SyncNewContent(bool sync_new_content)
+    {
+        sync_new_content_ = sync_new_content;
+    }
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // ====================  DATA MEMBERS  =======================================
+
+    fs::path store_directory_;
+
+    std::set<std::string> made_directories_;
+    Statistics statistics_;
+
+    bool sync_new_content_ = false;
+
+    mutable std::mutex store_mutex_;
+
+}; // -----  end of class ContentStore  -----
+
+#endif /* CONTENTSTORE_H_ */
@@ -40,6 +40,7 @@
 
 #include "Collector_Utils.h"
 #include "DailyIndexFileRetriever.h"
+#include "DownloadManifest.h"
 #include "HTTPS_Downloader.h"
 #include "PathNameGenerator.h"
 
@@ -51,8 +52,10 @@
 
 DailyIndexFileRetriever::DailyIndexFileRetriever(const std::string &host,
                                                  const std::string &port,
-                                                 const fs::path &prefix)
-    : host_{host}, port_{port}, remote_directory_prefix_{prefix}
+                                                 const fs::path &prefix,
+                                                 COL::IndexFileType index_file_type)
+    : host_{host}, port_{port}, remote_directory_prefix_{prefix},
+      index_file_base_name_{COL::IndexFileBaseName(index_file_type)}
 {
 
 } // -----  end of method DailyIndexFileRetriever::DailyIndexFileRetriever
@@ -72,6 +75,19 @@ std::chrono::year_month_day DailyIndexFileRetriever::CheckDate(std::chrono::year
     return aDate;
 } // -----  end of method DailyIndexFileRetriever::CheckDate  -----
 
+bool DailyIndexFileRetriever::HaveLocalFile(const fs::path &local_file_name) const
+{
+    return download_manifest_ != nullptr ? download_manifest_->HasFile(local_file_name) : fs::exists(local_file_name);
+} // -----  end of method DailyIndexFileRetriever::HaveLocalFile  -----
+
+void DailyIndexFileRetriever::RecordLocalFile(const fs::path &local_file_name)
+{
+    if (download_manifest_ != nullptr)
+    {
+        download_manifest_->RecordFile(local_file_name);
+    }
+} // -----  end of method DailyIndexFileRetriever::RecordLocalFile  -----
+
 fs::path DailyIndexFileRetriever::MakeDailyIndexPathName(std::chrono::year_month_day day_in_quarter)
 {
     input_date_ = CheckDate(day_in_quarter);
@@ -92,7 +108,7 @@ fs::path DailyIndexFileRetriever::FindRemoteIndexFileNameNearestDate(std::chrono
     auto remote_diretory_name = MakeDailyIndexPathName(aDate);
     decltype(auto) directory_list = this->GetRemoteIndexList(remote_diretory_name);
 
-    std::string looking_for = catenate("master.", std::format("{:%Y%m%d}", input_date_), ".idx");
+    std::string looking_for = catenate(index_file_base_name_, ".", std::format("{:%Y%m%d}", input_date_), ".idx");
 
     // index files may or may not be gzipped, so we need to exclude possible file
     // name suffix from comparisons
@@ -103,7 +119,7 @@ fs::path DailyIndexFileRetriever::FindRemoteIndexFileNameNearestDate(std::chrono
     BOOST_ASSERT_MSG(pos != directory_list.rend(),
                      catenate("Can't find daily index file for date: ", std::format("{:%F}", input_date_)).c_str());
 
-    actual_file_date_ = StringToDateYMD("%Y%m%d", (*pos).substr(7, 8));
+    actual_file_date_ = StringToDateYMD("%Y%m%d", (*pos).substr(index_file_base_name_.size() + 1, 8));
 
     spdlog::debug(catenate("D: Found Daily Index File for date: ", std::format("{:%F}", actual_file_date_)));
 
@@ -121,8 +137,8 @@ std::vector<fs::path> DailyIndexFileRetriever::FindRemoteIndexFileNamesForDateRa
     spdlog::debug(catenate("D: Looking for Daily Index Files in date range from: ", std::format("{:%F}", start_date_),
                            " to: ", std::format("{:%F}", end_date_)));
 
-    auto looking_for_start = std::string{"master."} + std::format("{:%Y%m%d}", start_date_) + ".idx";
-    auto looking_for_end = std::string{"master."} + std::format("{:%Y%m%d}", end_date_) + ".idx";
+    auto looking_for_start = index_file_base_name_ + "." + std::format("{:%Y%m%d}", start_date_) + ".idx";
+    auto looking_for_end = index_file_base_name_ + "." + std::format("{:%Y%m%d}", end_date_) + ".idx";
 
     auto remote_directory_list = MakeIndexFileNamesForDateRange(begin_date, end_date);
 
@@ -157,10 +173,13 @@ std::vector<fs::path> DailyIndexFileRetriever::FindRemoteIndexFileNamesForDateRa
                               std::format("{:%F}", end_date_))
                          .c_str());
 
-    actual_start_date_ =
-        StringToDateYMD("%Y%m%d", remote_daily_index_file_name_list.back().filename().string().substr(7, 8));
-    actual_end_date_ =
-        StringToDateYMD("%Y%m%d", remote_daily_index_file_name_list.front().filename().string().substr(7, 8));
+    // file names look like: <base name>.YYYYMMDD.idx[.gz]
+
+    const auto date_offset = index_file_base_name_.size() + 1;
+    actual_start_date_ = StringToDateYMD(
+        "%Y%m%d", remote_daily_index_file_name_list.back().filename().string().substr(date_offset, 8));
+    actual_end_date_ = StringToDateYMD(
+        "%Y%m%d", remote_daily_index_file_name_list.front().filename().string().substr(date_offset, 8));
 
     spdlog::debug(catenate("D: Found ", remote_daily_index_file_name_list.size(), " files for date range."));
 
@@ -194,7 +213,7 @@ std::vector<std::string> DailyIndexFileRetriever::GetRemoteIndexList(const fs::p
     // searches.
 
     auto not_form = std::partition(directory_list.begin(), directory_list.end(),
-                                   [](std::string &x) { return x.starts_with("master"); });
+                                   [this](std::string &x) { return x.starts_with(index_file_base_name_ + "."); });
     directory_list.erase(not_form, directory_list.end());
 
     std::sort(directory_list.begin(), directory_list.end());
@@ -213,7 +232,7 @@ fs::path DailyIndexFileRetriever::CopyRemoteIndexFileTo(const fs::path &remote_d
         local_daily_index_file_name.replace_extension("");
     }
 
-    if (!replace_files && fs::exists(local_daily_index_file_name))
+    if (!replace_files && HaveLocalFile(local_daily_index_file_name))
     {
         spdlog::info(catenate("D: File exists and 'replace' is false: skipping download: ",
                               local_daily_index_file_name.filename().string()));
@@ -224,6 +243,7 @@ fs::path DailyIndexFileRetriever::CopyRemoteIndexFileTo(const fs::path &remote_d
 
     HTTPS_Downloader the_server(host_, port_);
     the_server.DownloadFile(remote_daily_index_file_name, local_daily_index_file_name);
+    RecordLocalFile(local_daily_index_file_name);
 
     spdlog::info(catenate("D: Retrieved remote daily index file: ", remote_daily_index_file_name.string(),
                           " to: ", local_daily_index_file_name.string()));
@@ -234,7 +254,8 @@ fs::path DailyIndexFileRetriever::CopyRemoteIndexFileTo(const fs::path &remote_d
 
 fs::path DailyIndexFileRetriever::HierarchicalCopyRemoteIndexFileTo(const fs::path &remote_daily_index_file_name,
                                                                     const fs::path &local_directory_prefix,
-                                                                    bool replace_files)
+                                                                    bool replace_files,
+                                                                    const HTTPS_Downloader::DataHandler &handle_data)
 {
     auto local_daily_index_file_name = MakeLocalIndexFilePath(local_directory_prefix, remote_daily_index_file_name);
 
@@ -243,7 +264,7 @@ fs::path DailyIndexFileRetriever::HierarchicalCopyRemoteIndexFileTo(const fs::pa
         local_daily_index_file_name.replace_extension("");
     }
 
-    if (!replace_files && fs::exists(local_daily_index_file_name))
+    if (!replace_files && HaveLocalFile(local_daily_index_file_name))
     {
         spdlog::info(catenate("D: File exists and 'replace' is false: skipping download: ",
                               local_daily_index_file_name.filename().string()));
@@ -254,7 +275,15 @@ fs::path DailyIndexFileRetriever::HierarchicalCopyRemoteIndexFileTo(const fs::pa
     fs::create_directories(local_daily_index_file_directory);
 
     HTTPS_Downloader the_server(host_, port_);
-    the_server.DownloadFile(remote_daily_index_file_name, local_daily_index_file_name);
+    if (handle_data)
+    {
+        the_server.DownloadAndProcessFile(remote_daily_index_file_name, local_daily_index_file_name, handle_data);
+    }
+    else
+    {
+        the_server.DownloadFile(remote_daily_index_file_name, local_daily_index_file_name);
+    }
+    RecordLocalFile(local_daily_index_file_name);
 
     spdlog::info(catenate("D: Retrieved remote daily index file: ", remote_daily_index_file_name.string(),
                           " to: ", local_daily_index_file_name.string()));
@@ -282,7 +311,7 @@ auto DailyIndexFileRetriever::AddToCopyList(const fs::path &local_directory_name
     //	construct our lambda function here so it doesn't clutter up our code
     // below.
 
-    return [local_directory_name, replace_files](const auto &remote_file_name) {
+    return [this, local_directory_name, replace_files](const auto &remote_file_name) {
         auto local_daily_index_file_name = local_directory_name;
         local_daily_index_file_name /= remote_file_name.filename();
 
@@ -291,7 +320,7 @@ auto DailyIndexFileRetriever::AddToCopyList(const fs::path &local_directory_name
             local_daily_index_file_name.replace_extension("");
         }
 
-        if (!replace_files && fs::exists(local_daily_index_file_name))
+        if (!replace_files && HaveLocalFile(local_daily_index_file_name))
         {
             // we use an empty remote file name to indicate no copy needed as the
             // local file already exists.
@@ -325,7 +354,9 @@ std::vector<fs::path> DailyIndexFileRetriever::ConcurrentlyCopyIndexFilesForDate
     // now, we expect some magic to happen here...
 
     HTTPS_Downloader the_server(host_, port_);
-    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(concurrent_copy_list, max_at_a_time);
+    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(
+        concurrent_copy_list, max_at_a_time,
+        [this](const fs::path &local_file_name, const std::string &) { RecordLocalFile(local_file_name); });
 
     int skipped_files_counter = std::count_if(std::begin(concurrent_copy_list), std::end(concurrent_copy_list),
                                               [](const auto &e) { return !e.first; });
@@ -382,7 +413,7 @@ auto DailyIndexFileRetriever::AddToConcurrentCopyList(const fs::path &local_dire
             local_daily_index_file_name.replace_extension("");
         }
 
-        if (!replace_files && fs::exists(local_daily_index_file_name))
+        if (!replace_files && HaveLocalFile(local_daily_index_file_name))
         {
             // we use an empty remote file name to indicate no copy needed as the
             // local file already exists.
@@ -421,7 +452,9 @@ std::vector<fs::path> DailyIndexFileRetriever::ConcurrentlyHierarchicalCopyIndex
     // now, we expect some magic to happen here...
 
     HTTPS_Downloader the_server(host_, port_);
-    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(concurrent_copy_list, max_at_a_time);
+    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(
+        concurrent_copy_list, max_at_a_time,
+        [this](const fs::path &local_file_name, const std::string &) { RecordLocalFile(local_file_name); });
 
     // if the first file name in the pair is empty, there was no download done.
 
@@ -39,8 +39,13 @@
 #include <string>
 #include <vector>
 
+#include "Collector_Utils.h"
+#include "HTTPS_Downloader.h"
+
 namespace fs = std::filesystem;
 
+class DownloadManifest;
+
 // =====================================================================================
 //        Class:  DailyIndexFileRetriever
 //  Description:
@@ -51,7 +56,8 @@ class DailyIndexFileRetriever
 public:
     // ====================  LIFECYCLE     =======================================
     DailyIndexFileRetriever() = delete;
-    DailyIndexFileRetriever(const std::string &host, const std::string &port, const fs::path &prefix);
+    DailyIndexFileRetriever(const std::string &host, const std::string &port, const fs::path &prefix,
+                            COL::IndexFileType index_file_type = COL::IndexFileType::master);
     DailyIndexFileRetriever(const DailyIndexFileRetriever &rhs) = delete;
     DailyIndexFileRetriever(DailyIndexFileRetriever &&rhs) = delete;
 
@@ -76,6 +82,14 @@ public:
     DailyIndexFileRetriever &operator=(const DailyIndexFileRetriever &rhs) = delete;
     DailyIndexFileRetriever &operator=(DailyIndexFileRetriever &&rhs) = delete;
 
+    // decide which index files we already have from the manifest instead of
+    // looking in the file system.  Downloads are recorded in it.
+
+    void UseDownloadManifest(DownloadManifest *download_manifest)
+    {
+        download_manifest_ = download_manifest;
+    }
+
     fs::path FindRemoteIndexFileNameNearestDate(std::chrono::year_month_day aDate);
 
     //	returns the local path name of the downloaded file.
@@ -83,8 +97,13 @@ public:
     fs::path CopyRemoteIndexFileTo(const fs::path &remote_daily_index_file_name,
                                    const fs::path &local_directory_name,
                                    bool replace_files = false);
+
+    // if handle_data is given, the index data is also passed to it as it
+    // downloads.  See HTTPS_Downloader::DownloadAndProcessFile.
+
     fs::path HierarchicalCopyRemoteIndexFileTo(const fs::path &remote_daily_index_file_name,
-                                               const fs::path &local_directory_prefix, bool replace_files = false);
+                                               const fs::path &local_directory_prefix, bool replace_files = false,
+                                               const HTTPS_Downloader::DataHandler &handle_data = {});
 
     //	This method treats the date range as a closed interval.
 
@@ -124,6 +143,9 @@ protected:
     // ====================  DATA MEMBERS  =======================================
 
 private:
+    [[nodiscard]] bool HaveLocalFile(const fs::path &local_file_name) const;
+    void RecordLocalFile(const fs::path &local_file_name);
+
     auto AddToCopyList(const fs::path &local_directory_name, bool replace_files);
     auto AddToConcurrentCopyList(const fs::path &local_directory_prefix, bool replace_files);
 
@@ -140,6 +162,10 @@ private:
     std::string host_;
     std::string port_;
 
+    std::string index_file_base_name_; // 'master' or 'form'
+
+    DownloadManifest *download_manifest_ = nullptr;
+
 }; // -----  end of class DailyIndexFileRetriever  -----
 
 #endif /* DAILYINDEXFILERETRIEVER_H_ */
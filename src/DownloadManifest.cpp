@@ -0,0 +1,328 @@
+// =====================================================================================
+//
+//       Filename:  DownloadManifest.cpp
+//
+//    Description:  Keeps a list of the files we have downloaded so we don't
+//                  have to ask the file system about each one
+//
+//        Version:  1.0
+//        Created:  10/19/2026 09:12:37 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryFileUtils.h"
+#include "Collector_Utils.h"
+#include "DownloadManifest.h"
+
+// the manifest file looks like this:
+//
+//  # Collector download manifest 1 <time of last reconcile, seconds since 1970>
+//  <size>\t<modification time>\t<path relative to the directory>
+//  ...
+//
+// When the same path shows up more than once, the last line wins.
+
+namespace
+{
+constexpr const char *k_manifest_file_name = ".collector_manifest";
+constexpr COL::sview k_header{"# Collector download manifest 1 "};
+
+// how often we look at the file system to catch changes made without us.
+
+constexpr std::chrono::days k_reconcile_interval{30};
+
+std::int64_t SecondsSinceEpoch()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+template <typename T>
+bool ParseNumber(COL::sview text, T &result)
+{
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), result);
+    return ec == std::errc{} && ptr == text.data() + text.size();
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  DownloadManifest
+//      Method:  DownloadManifest
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+DownloadManifest::DownloadManifest(const fs::path &root_directory, bool reconcile)
+    : root_directory_{root_directory}, manifest_file_name_{root_directory / k_manifest_file_name}
+{
+    fs::create_directories(root_directory_);
+
+    if (reconcile || !Load() ||
+        SecondsSinceEpoch() - reconcile_time_ >
+            std::chrono::duration_cast<std::chrono::seconds>(k_reconcile_interval).count())
+    {
+        Reconcile();
+    }
+    else
+    {
+        OpenJournal();
+    }
+} // -----  end of method DownloadManifest::DownloadManifest  (constructor)  -----
+
+DownloadManifest::~DownloadManifest()
+{
+    if (journal_fd_ != -1)
+    {
+        ::close(journal_fd_);
+    }
+} // -----  end of method DownloadManifest::~DownloadManifest  (destructor)  -----
+
+std::size_t DownloadManifest::GetFileCount() const
+{
+    std::lock_guard<std::mutex> lock{manifest_mutex_};
+    return entries_.size();
+} // -----  end of method DownloadManifest::GetFileCount  -----
+
+bool DownloadManifest::HasFile(const fs::path &file_name) const
+{
+    const auto key = MakeKey(file_name);
+    if (!key)
+    {
+        return fs::exists(file_name);
+    }
+
+    std::lock_guard<std::mutex> lock{manifest_mutex_};
+    return entries_.contains(*key);
+} // -----  end of method DownloadManifest::HasFile  -----
+
+void DownloadManifest::RecordFile(const fs::path &file_name)
+{
+    const auto key = MakeKey(file_name);
+    if (!key)
+    {
+        return;
+    }
+
+    // we just wrote the file so this is the only time we look at it.
+
+    std::error_code ec;
+    const auto file_size = fs::file_size(file_name, ec);
+    if (ec)
+    {
+        spdlog::error(catenate("M: Can't record downloaded file: ", file_name.string(), ". ", ec.message()));
+        return;
+    }
+    const Entry entry{file_size, FileModificationTime(file_name)};
+
+    std::lock_guard<std::mutex> lock{manifest_mutex_};
+    entries_[*key] = entry;
+    AppendLine(std::format("{}\t{}\t{}\n", entry.size, entry.modification_time, *key));
+} // -----  end of method DownloadManifest::RecordFile  -----
+
+void DownloadManifest::Reconcile()
+{
+    const auto reconcile_start = std::chrono::steady_clock::now();
+
+    std::unordered_map<std::string, Entry> entries;
+
+    // hidden directories (like the content store) are not ours.
+
+    for (auto dir_entry = fs::recursive_directory_iterator(root_directory_,
+                                                           fs::directory_options::skip_permission_denied);
+         dir_entry != fs::recursive_directory_iterator(); ++dir_entry)
+    {
+        if (dir_entry->is_directory() && dir_entry->path().filename().string().starts_with('.'))
+        {
+            dir_entry.disable_recursion_pending();
+            continue;
+        }
+        if (!dir_entry->is_regular_file() || dir_entry->path().filename() == k_manifest_file_name ||
+            dir_entry->path().extension() == ".tmp")
+        {
+            continue;
+        }
+        if (auto key = MakeKey(dir_entry->path()); key)
+        {
+            entries.emplace(std::move(*key),
+                            Entry{dir_entry->file_size(), static_cast<std::int64_t>(
+                                                              dir_entry->last_write_time().time_since_epoch().count())});
+        }
+    }
+
+    std::lock_guard<std::mutex> lock{manifest_mutex_};
+
+    const auto missing_count = std::ranges::count_if(
+        entries_, [&entries](const auto &old_entry) { return !entries.contains(old_entry.first); });
+    const auto new_count = std::ranges::count_if(
+        entries, [this](const auto &found_entry) { return !entries_.contains(found_entry.first); });
+
+    entries_ = std::move(entries);
+    reconcile_time_ = SecondsSinceEpoch();
+
+    // a whole new manifest is written under a temporary name and renamed
+    // into place.
+
+    const auto temp_file_name = MakeTempFileName(manifest_file_name_);
+    {
+        std::ofstream output{temp_file_name, std::ios::out | std::ios::trunc};
+        if (!output.is_open())
+        {
+            throw std::runtime_error(catenate("Unable to open download manifest: ", temp_file_name.string()));
+        }
+
+        output << k_header << reconcile_time_ << '\n';
+        for (const auto &[key, entry] : entries_)
+        {
+            output << entry.size << '\t' << entry.modification_time << '\t' << key << '\n';
+        }
+
+        output.close();
+        if (output.fail())
+        {
+            fs::remove(temp_file_name);
+            throw std::runtime_error(catenate("Unable to write download manifest: ", temp_file_name.string()));
+        }
+    }
+    fs::rename(temp_file_name, manifest_file_name_);
+    cut_off_line_ = false;
+
+    if (journal_fd_ != -1)
+    {
+        ::close(journal_fd_);
+        journal_fd_ = -1;
+    }
+    OpenJournal();
+
+    const std::chrono::duration<double> reconcile_time = std::chrono::steady_clock::now() - reconcile_start;
+    spdlog::info(std::format("M: Reconciled download manifest: {} with file system in {:.3f} seconds. Files: {}. "
+                             "Not in manifest: {}. No longer there: {}.",
+                             manifest_file_name_.string(), reconcile_time.count(), entries_.size(), new_count,
+                             missing_count));
+} // -----  end of method DownloadManifest::Reconcile  -----
+
+std::optional<std::string> DownloadManifest::MakeKey(const fs::path &file_name) const
+{
+    auto relative_name = file_name.lexically_relative(root_directory_);
+    if (relative_name.empty() || *relative_name.begin() == "..")
+    {
+        return {};
+    }
+    return relative_name.generic_string();
+} // -----  end of method DownloadManifest::MakeKey  -----
+
+bool DownloadManifest::Load()
+{
+    std::ifstream input{manifest_file_name_};
+    if (!input.is_open())
+    {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(input, line) || !line.starts_with(k_header) ||
+        !ParseNumber(COL::sview{line}.substr(k_header.size()), reconcile_time_))
+    {
+        spdlog::info(
+            catenate("M: Download manifest: ", manifest_file_name_.string(), " is not usable. Rebuilding it."));
+        return false;
+    }
+
+    int bad_lines{0};
+    while (std::getline(input, line))
+    {
+        // a line without a newline was cut off part way through.
+
+        if (input.eof())
+        {
+            ++bad_lines;
+            cut_off_line_ = true;
+            break;
+        }
+
+        const COL::sview record{line};
+        const auto first_tab = record.find('\t');
+        const auto second_tab = record.find('\t', first_tab + 1);
+
+        Entry entry;
+        if (first_tab == COL::sview::npos || second_tab == COL::sview::npos ||
+            !ParseNumber(record.substr(0, first_tab), entry.size) ||
+            !ParseNumber(record.substr(first_tab + 1, second_tab - first_tab - 1), entry.modification_time))
+        {
+            ++bad_lines;
+            continue;
+        }
+        entries_.insert_or_assign(std::string{record.substr(second_tab + 1)}, entry);
+    }
+
+    spdlog::info(catenate("M: Loaded download manifest: ", manifest_file_name_.string(), " with ", entries_.size(),
+                          " files."));
+    if (bad_lines > 0)
+    {
+        spdlog::info(catenate("M: Ignored ", bad_lines, " damaged lines in download manifest."));
+    }
+    return true;
+} // -----  end of method DownloadManifest::Load  -----
+
+void DownloadManifest::OpenJournal()
+{
+    journal_fd_ = ::open(manifest_file_name_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (journal_fd_ == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't open download manifest: ", manifest_file_name_.string())};
+    }
+
+    // finish off a partial line so it doesn't run into the next one.
+
+    if (cut_off_line_)
+    {
+        AppendLine("\n");
+        cut_off_line_ = false;
+    }
+} // -----  end of method DownloadManifest::OpenJournal  -----
+
+void DownloadManifest::AppendLine(const std::string &line)
+{
+    // one write per line so a line is all there or (after a crash) cut short.
+
+    const auto written = ::write(journal_fd_, line.data(), line.size());
+    if (written != static_cast<ssize_t>(line.size()))
+    {
+        throw std::system_error{std::error_code{written == -1 ? errno : EIO, std::system_category()},
+                                catenate("Can't add to download manifest: ", manifest_file_name_.string())};
+    }
+} // -----  end of method DownloadManifest::AppendLine  -----
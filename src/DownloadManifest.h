@@ -0,0 +1,150 @@
+// =====================================================================================
+//
+//       Filename:  DownloadManifest.h
+//
+//    Description:  Keeps a list of the files we have downloaded so we don't
+//                  have to ask the file system about each one
+//
+//        Version:  1.0
+//        Created:  10/19/2026 09:12:37 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef DOWNLOADMANIFEST_H_
+#define DOWNLOADMANIFEST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  DownloadManifest
+//  Description:  deciding whether to skip a download used to mean an
+//                fs::exists for every candidate file.  With millions of files
+//                on a network file system, that is minutes of metadata I/O
+//                before the first download starts.
+//
+//                The manifest is a text file in the top of a download
+//                directory with a line for each file we have: size,
+//                modification time and path relative to that directory.  A
+//                line is appended as each download finishes.  Each append is
+//                a single write so a crash can at most leave a partial last
+//                line, which is ignored.
+//
+//                Whether to skip a download goes by whether the file is in
+//                the manifest.  The size and modification time are kept for
+//                the record and aren't checked.  Files can be removed,
+//                added or changed behind our back so now and then the
+//                manifest is rebuilt from the file system.
+// =====================================================================================
+class DownloadManifest
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    DownloadManifest() = delete;
+
+    // loads the manifest for the files under root_directory.  If there isn't
+    // one yet, it is too old or reconcile is set, it is rebuilt from the file
+    // system first.
+
+    explicit DownloadManifest(const fs::path &root_directory, bool reconcile = false);
+
+    DownloadManifest(const DownloadManifest &rhs) = delete;
+    DownloadManifest(DownloadManifest &&rhs) = delete;
+
+    ~DownloadManifest();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] const fs::path &GetRootDirectory() const
+    {
+        return root_directory_;
+    }
+    [[nodiscard]] const fs::path &GetManifestFileName() const
+    {
+        return manifest_file_name_;
+    }
+    [[nodiscard]] std::size_t GetFileCount() const;
+
+    // files outside our directory are looked up in the file system.
+
+    [[nodiscard]] bool HasFile(const fs::path &file_name) const;
+
+    // ====================  MUTATORS      =======================================
+
+    DownloadManifest &operator=(const DownloadManifest &rhs) = delete;
+    DownloadManifest &operator=(DownloadManifest &&rhs) = delete;
+
+    // call when a download has finished.  Safe to call from any thread.
+
+    void RecordFile(const fs::path &file_name);
+
+    // make the manifest match what is actually in our directory.
+
+    void Reconcile();
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    struct Entry
+    {
+        std::uint64_t size;
+        std::int64_t modification_time;
+    };
+
+    // nothing if the file is not under our directory.
+
+    [[nodiscard]] std::optional<std::string> MakeKey(const fs::path &file_name) const;
+
+    // returns false if there is no usable manifest file.
+
+    bool Load();
+    void OpenJournal();
+    void AppendLine(const std::string &line);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    fs::path root_directory_;
+    fs::path manifest_file_name_;
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::int64_t reconcile_time_ = 0;
+    bool cut_off_line_ = false;
+
+    mutable std::mutex manifest_mutex_;
+    int journal_fd_ = -1;
+
+}; // -----  end of class DownloadManifest  -----
+
+#endif /* DOWNLOADMANIFEST_H_ */
@@ -0,0 +1,616 @@
+// =====================================================================================
+//
+//       Filename:  FileWriter.cpp
+//
+//    Description:  Writes downloaded files for the download threads so they
+//                  can get back to downloading
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:58 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <cerrno>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "FileWriter.h"
+
+#ifdef COLLECTOR_USE_IO_URING
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+#include <fcntl.h>
+#include <liburing.h>
+#include <sys/uio.h>
+#endif
+
+namespace
+{
+constexpr const char *k_benchmark_directory_name = ".write_benchmark";
+
+// like a busy form directory.
+
+constexpr std::size_t k_benchmark_files_per_directory = 1000;
+
+#ifdef COLLECTOR_USE_IO_URING
+
+// each file being written has a fixed file slot and, if it fits, a
+// registered buffer of its own.
+
+constexpr unsigned k_slot_count = 64;
+constexpr std::size_t k_buffer_size = 64 * 1024;
+
+// files waiting for a slot.  Past this, WriteFile waits too so a slow disk
+// can't have us holding every download in memory.
+
+constexpr std::size_t k_queue_limit = 4096;
+
+// the open, write and close for a file are linked so they run in order.
+// user_data is <slot> * 4 + <step>.
+
+constexpr std::uint64_t k_open_step = 0;
+constexpr std::uint64_t k_write_step = 1;
+constexpr std::uint64_t k_close_step = 2;
+constexpr unsigned k_steps_per_file = 3;
+
+const char *StepName(std::uint64_t step)
+{
+    return step == k_open_step ? "open" : step == k_write_step ? "write" : "close";
+}
+
+#endif
+
+} // namespace
+
+#ifdef COLLECTOR_USE_IO_URING
+
+// =====================================================================================
+//        Class:  FileWriter::IOUringWriter
+//  Description:  our io_uring thread.  Takes queued files as slots come free,
+//                submits them all at once and waits for at least one
+//                completion, over and over.
+// =====================================================================================
+struct FileWriter::IOUringWriter
+{
+    struct Request
+    {
+        fs::path file_name;
+        std::vector<char> data;
+        std::size_t size = 0;
+        std::promise<void> written;
+        int buffer_index = -1;
+        unsigned results_pending = k_steps_per_file;
+        int error = 0;
+        const char *failed_step = nullptr;
+    };
+
+    explicit IOUringWriter(FileWriter &file_writer);
+    ~IOUringWriter();
+
+    IOUringWriter(const IOUringWriter &rhs) = delete;
+    IOUringWriter &operator=(const IOUringWriter &rhs) = delete;
+
+    std::future<void> WriteFile(const fs::path &file_name, std::vector<char> data);
+
+    void Run();
+    void Prepare(std::unique_ptr<Request> request, unsigned slot);
+    void Complete(const io_uring_cqe &cqe);
+
+    FileWriter &file_writer_;
+
+    io_uring ring_{};
+
+    std::vector<char> buffers_;
+    std::vector<int> free_buffers_;
+
+    // only used from our thread.
+
+    std::vector<unsigned> free_slots_;
+    std::vector<std::unique_ptr<Request>> in_flight_;
+    std::size_t in_flight_count_ = 0;
+
+    std::deque<std::unique_ptr<Request>> queued_;
+    bool stopping_ = false;
+
+    std::mutex queue_mutex_;
+    std::condition_variable work_condition_;
+    std::condition_variable space_condition_;
+
+    std::thread thread_;
+
+}; // -----  end of class FileWriter::IOUringWriter  -----
+
+FileWriter::IOUringWriter::IOUringWriter(FileWriter &file_writer) : file_writer_{file_writer}
+{
+    if (const int rc = io_uring_queue_init(k_slot_count * k_steps_per_file, &ring_, 0); rc < 0)
+    {
+        throw std::system_error{-rc, std::system_category(), "io_uring_queue_init"};
+    }
+
+    // kernels too old for what we do can be told by what they don't have.
+
+    auto *probe = io_uring_get_probe_ring(&ring_);
+    const bool have_operations = probe != nullptr && io_uring_opcode_supported(probe, IORING_OP_OPENAT) &&
+                                 io_uring_opcode_supported(probe, IORING_OP_WRITE) &&
+                                 io_uring_opcode_supported(probe, IORING_OP_WRITE_FIXED) &&
+                                 io_uring_opcode_supported(probe, IORING_OP_CLOSE);
+    if (probe != nullptr)
+    {
+        io_uring_free_probe(probe);
+    }
+    if (!have_operations)
+    {
+        io_uring_queue_exit(&ring_);
+        throw std::system_error{ENOSYS, std::system_category(), "io_uring open, write and close"};
+    }
+    if (const int rc = io_uring_register_files_sparse(&ring_, k_slot_count); rc < 0)
+    {
+        io_uring_queue_exit(&ring_);
+        throw std::system_error{-rc, std::system_category(), "io_uring_register_files_sparse"};
+    }
+
+    // registered buffers count against locked memory.  Do without them if
+    // we aren't allowed that much.
+
+    buffers_.resize(k_slot_count * k_buffer_size);
+    std::vector<iovec> buffer_list(k_slot_count);
+    for (unsigned i = 0; i < k_slot_count; ++i)
+    {
+        buffer_list[i].iov_base = buffers_.data() + i * k_buffer_size;
+        buffer_list[i].iov_len = k_buffer_size;
+    }
+    if (const int rc = io_uring_register_buffers(&ring_, buffer_list.data(), k_slot_count); rc < 0)
+    {
+        spdlog::info(catenate("I: Can't register io_uring write buffers: ",
+                              std::error_code{-rc, std::system_category()}.message(),
+                              ". Writing from download buffers."));
+        buffers_.clear();
+        buffers_.shrink_to_fit();
+    }
+    else
+    {
+        for (int i = k_slot_count - 1; i >= 0; --i)
+        {
+            free_buffers_.push_back(i);
+        }
+    }
+
+    for (unsigned i = 0; i < k_slot_count; ++i)
+    {
+        free_slots_.push_back(k_slot_count - 1 - i);
+    }
+    in_flight_.resize(k_slot_count);
+
+    thread_ = std::thread{&IOUringWriter::Run, this};
+} // -----  end of method FileWriter::IOUringWriter::IOUringWriter  (constructor)  -----
+
+FileWriter::IOUringWriter::~IOUringWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock{queue_mutex_};
+        stopping_ = true;
+    }
+    work_condition_.notify_one();
+    thread_.join();
+    io_uring_queue_exit(&ring_);
+} // -----  end of method FileWriter::IOUringWriter::~IOUringWriter  (destructor)  -----
+
+std::future<void> FileWriter::IOUringWriter::WriteFile(const fs::path &file_name, std::vector<char> data)
+{
+    auto request = std::make_unique<Request>();
+    request->file_name = file_name;
+    request->size = data.size();
+    request->data = std::move(data);
+    auto written = request->written.get_future();
+    {
+        std::unique_lock<std::mutex> lock{queue_mutex_};
+        space_condition_.wait(lock, [this] { return queued_.size() < k_queue_limit; });
+        queued_.push_back(std::move(request));
+    }
+    work_condition_.notify_one();
+    return written;
+} // -----  end of method FileWriter::IOUringWriter::WriteFile  -----
+
+void FileWriter::IOUringWriter::Run()
+{
+    std::vector<std::unique_ptr<Request>> ready;
+    ready.reserve(k_slot_count);
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock{queue_mutex_};
+            work_condition_.wait(lock, [this] { return stopping_ || !queued_.empty() || in_flight_count_ > 0; });
+            if (stopping_ && queued_.empty() && in_flight_count_ == 0)
+            {
+                break;
+            }
+            while (!queued_.empty() && ready.size() < free_slots_.size())
+            {
+                ready.push_back(std::move(queued_.front()));
+                queued_.pop_front();
+            }
+        }
+        if (!ready.empty())
+        {
+            space_condition_.notify_all();
+            for (auto &request : ready)
+            {
+                const auto slot = free_slots_.back();
+                free_slots_.pop_back();
+                Prepare(std::move(request), slot);
+            }
+            ready.clear();
+        }
+
+        if (const int rc = io_uring_submit_and_wait(&ring_, 1); rc < 0 && rc != -EINTR)
+        {
+            // nothing we can do about the files in flight but our caller
+            // needs to know.
+
+            spdlog::error(catenate("I: io_uring_submit_and_wait failed: ",
+                                   std::error_code{-rc, std::system_category()}.message()));
+        }
+
+        unsigned head = 0;
+        unsigned seen = 0;
+        io_uring_cqe *cqe = nullptr;
+        io_uring_for_each_cqe(&ring_, head, cqe)
+        {
+            Complete(*cqe);
+            ++seen;
+        }
+        io_uring_cq_advance(&ring_, seen);
+    }
+} // -----  end of method FileWriter::IOUringWriter::Run  -----
+
+void FileWriter::IOUringWriter::Prepare(std::unique_ptr<Request> request, unsigned slot)
+{
+    // the ring has room for every step of every slot so these can't fail.
+
+    auto *open_entry = io_uring_get_sqe(&ring_);
+    io_uring_prep_openat_direct(open_entry, AT_FDCWD, request->file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666,
+                                slot);
+    io_uring_sqe_set_data64(open_entry, slot * 4 + k_open_step);
+    io_uring_sqe_set_flags(open_entry, IOSQE_IO_LINK);
+
+    // a small file goes in a registered buffer and we are done with its
+    // download buffer.
+
+    auto *write_entry = io_uring_get_sqe(&ring_);
+    if (request->size <= k_buffer_size && !free_buffers_.empty())
+    {
+        request->buffer_index = free_buffers_.back();
+        free_buffers_.pop_back();
+        char *buffer = buffers_.data() + request->buffer_index * k_buffer_size;
+        std::memcpy(buffer, request->data.data(), request->size);
+        std::vector<char>{}.swap(request->data);
+        io_uring_prep_write_fixed(write_entry, static_cast<int>(slot), buffer, request->size, 0,
+                                  request->buffer_index);
+    }
+    else
+    {
+        io_uring_prep_write(write_entry, static_cast<int>(slot), request->data.data(), request->size, 0);
+    }
+    io_uring_sqe_set_data64(write_entry, slot * 4 + k_write_step);
+
+    // the close happens even when the write fails.
+
+    io_uring_sqe_set_flags(write_entry, IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+
+    auto *close_entry = io_uring_get_sqe(&ring_);
+    io_uring_prep_close_direct(close_entry, slot);
+    io_uring_sqe_set_data64(close_entry, slot * 4 + k_close_step);
+
+    in_flight_[slot] = std::move(request);
+    ++in_flight_count_;
+} // -----  end of method FileWriter::IOUringWriter::Prepare  -----
+
+void FileWriter::IOUringWriter::Complete(const io_uring_cqe &cqe)
+{
+    const auto slot = static_cast<unsigned>(cqe.user_data / 4);
+    const auto step = cqe.user_data % 4;
+    auto &request = *in_flight_[slot];
+
+    // steps after one that failed are cancelled.  Keep the real reason.
+
+    if (cqe.res < 0 && (request.error == 0 || request.error == ECANCELED))
+    {
+        request.error = -cqe.res;
+        request.failed_step = StepName(step);
+    }
+    else if (step == k_write_step && cqe.res >= 0 && static_cast<std::size_t>(cqe.res) != request.size &&
+             request.error == 0)
+    {
+        request.error = EIO;
+        request.failed_step = "completely write";
+    }
+    if (--request.results_pending > 0)
+    {
+        return;
+    }
+
+    auto finished = std::move(in_flight_[slot]);
+    if (finished->buffer_index >= 0)
+    {
+        free_buffers_.push_back(finished->buffer_index);
+    }
+    free_slots_.push_back(slot);
+    --in_flight_count_;
+
+    {
+        std::lock_guard<std::mutex> lock{file_writer_.statistics_mutex_};
+        if (finished->error == 0)
+        {
+            ++file_writer_.statistics_.files_written;
+            file_writer_.statistics_.bytes_written += finished->size;
+        }
+        else
+        {
+            ++file_writer_.statistics_.errors;
+        }
+    }
+
+    if (finished->error == 0)
+    {
+        finished->written.set_value();
+        return;
+    }
+
+    // don't leave part of a file behind.  It would look like a good file
+    // next time.
+
+    std::error_code remove_error;
+    fs::remove(finished->file_name, remove_error);
+    finished->written.set_exception(std::make_exception_ptr(
+        std::system_error{finished->error, std::system_category(),
+                          catenate("Unable to ", finished->failed_step, " file: ", finished->file_name.string())}));
+} // -----  end of method FileWriter::IOUringWriter::Complete  -----
+
+#else
+
+// never made without liburing.
+
+struct FileWriter::IOUringWriter
+{
+    std::future<void> WriteFile(const fs::path & /* file_name */, std::vector<char> /* data */)
+    {
+        throw std::logic_error("Built without io_uring.");
+    }
+};
+
+#endif
+
+FileWriter::Backend FileWriterBackendFromString(COL::sview backend_name)
+{
+    if (backend_name == "stream")
+    {
+        return FileWriter::Backend::e_stream;
+    }
+    if (backend_name == "io_uring")
+    {
+        return FileWriter::Backend::e_io_uring;
+    }
+    throw std::invalid_argument(catenate("File writer must be 'stream' or 'io_uring' ==> ", backend_name));
+}
+
+std::string FileWriterBackendToString(FileWriter::Backend backend)
+{
+    return backend == FileWriter::Backend::e_io_uring ? "io_uring" : "stream";
+}
+
+//--------------------------------------------------------------------------------------
+//       Class:  FileWriter
+//      Method:  FileWriter
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+FileWriter::FileWriter(Backend backend)
+{
+    if (backend != Backend::e_io_uring)
+    {
+        return;
+    }
+#ifdef COLLECTOR_USE_IO_URING
+    try
+    {
+        io_uring_writer_ = std::make_unique<IOUringWriter>(*this);
+    }
+    catch (const std::system_error &e)
+    {
+        spdlog::info(catenate("I: Can't use io_uring: ", e.what(), ". Using the 'stream' file writer instead."));
+    }
+#else
+    spdlog::info("I: Built without io_uring. Using the 'stream' file writer instead.");
+#endif
+} // -----  end of method FileWriter::FileWriter  (constructor)  -----
+
+FileWriter::~FileWriter() = default;
+
+FileWriter::Backend FileWriter::GetBackend() const
+{
+    return io_uring_writer_ ? Backend::e_io_uring : Backend::e_stream;
+} // -----  end of method FileWriter::GetBackend  -----
+
+FileWriter::Statistics FileWriter::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock{statistics_mutex_};
+    return statistics_;
+} // -----  end of method FileWriter::GetStatistics  -----
+
+void FileWriter::LogStatistics() const
+{
+    const auto statistics = GetStatistics();
+    const std::chrono::duration<double, std::micro> caller_time = statistics.caller_time;
+    const auto file_count = statistics.files_written + statistics.errors;
+
+    spdlog::info(std::format("I: '{}' file writer wrote {} files, {} bytes. Callers waited {:.1f} us per file. "
+                             "Errors: {}.",
+                             FileWriterBackendToString(GetBackend()), statistics.files_written,
+                             statistics.bytes_written,
+                             file_count > 0 ? caller_time.count() / static_cast<double>(file_count) : 0.0,
+                             statistics.errors));
+} // -----  end of method FileWriter::LogStatistics  -----
+
+std::future<void> FileWriter::WriteFile(const fs::path &file_name, std::vector<char> data)
+{
+    const auto call_start = std::chrono::steady_clock::now();
+
+    std::future<void> written;
+    if (io_uring_writer_)
+    {
+        written = io_uring_writer_->WriteFile(file_name, std::move(data));
+    }
+    else
+    {
+        std::promise<void> done;
+        try
+        {
+            WriteFileWithStream(file_name, data);
+            done.set_value();
+        }
+        catch (...)
+        {
+            done.set_exception(std::current_exception());
+        }
+        written = done.get_future();
+    }
+
+    std::lock_guard<std::mutex> lock{statistics_mutex_};
+    statistics_.caller_time += std::chrono::steady_clock::now() - call_start;
+    return written;
+} // -----  end of method FileWriter::WriteFile  -----
+
+void FileWriter::WriteFileWithStream(const fs::path &file_name, const std::vector<char> &data)
+{
+    errno = 0;
+    std::ofstream file{file_name, std::ios::out | std::ios::binary};
+    const bool written = file && !file.write(data.data(), static_cast<std::streamsize>(data.size())).fail();
+    file.close();
+    if (!written || file.fail())
+    {
+        std::error_code err{errno, std::system_category()};
+        {
+            std::lock_guard<std::mutex> lock{statistics_mutex_};
+            ++statistics_.errors;
+        }
+        std::error_code remove_error;
+        fs::remove(file_name, remove_error);
+        throw std::system_error{err, catenate("Unable to write file: ", file_name.string())};
+    }
+
+    std::lock_guard<std::mutex> lock{statistics_mutex_};
+    ++statistics_.files_written;
+    statistics_.bytes_written += data.size();
+} // -----  end of method FileWriter::WriteFileWithStream  -----
+
+void BenchmarkFileWriters(const fs::path &directory, std::size_t file_count, std::size_t file_size, int writer_count)
+{
+    BOOST_ASSERT_MSG(file_count > 0 && writer_count > 0, "Need files to write and threads to write them.");
+
+    const auto benchmark_directory = directory / k_benchmark_directory_name;
+
+    // something that looks like a small form file.
+
+    std::vector<char> contents(file_size);
+    for (std::size_t i = 0; i < contents.size(); ++i)
+    {
+        contents[i] = (i % 80 == 79) ? '\n' : static_cast<char>('a' + i % 26);
+    }
+
+    for (const auto backend : {FileWriter::Backend::e_stream, FileWriter::Backend::e_io_uring})
+    {
+        fs::remove_all(benchmark_directory);
+        for (std::size_t i = 0; i < file_count; i += k_benchmark_files_per_directory)
+        {
+            fs::create_directories(benchmark_directory / std::format("{:04}", i / k_benchmark_files_per_directory));
+        }
+
+        FileWriter file_writer{backend};
+        if (file_writer.GetBackend() != backend)
+        {
+            continue;
+        }
+
+        // the threads stand in for download threads.  Each hands off all
+        // its files then waits for them.
+
+        const auto write_start = std::chrono::steady_clock::now();
+        std::vector<std::future<std::size_t>> writers;
+        for (int writer = 0; writer < writer_count; ++writer)
+        {
+            writers.emplace_back(std::async(
+                std::launch::async,
+                [&, writer]()
+                {
+                    std::vector<std::future<void>> written;
+                    for (auto i = static_cast<std::size_t>(writer); i < file_count; i += writer_count)
+                    {
+                        written.push_back(file_writer.WriteFile(
+                            benchmark_directory /
+                                std::format("{:04}/{:06}.txt", i / k_benchmark_files_per_directory, i),
+                            contents));
+                    }
+                    std::size_t errors = 0;
+                    for (auto &file_written : written)
+                    {
+                        try
+                        {
+                            file_written.get();
+                        }
+                        catch (const std::exception &e)
+                        {
+                            spdlog::error(catenate("I: ", e.what()));
+                            ++errors;
+                        }
+                    }
+                    return errors;
+                }));
+        }
+        std::size_t errors = 0;
+        for (auto &writer : writers)
+        {
+            errors += writer.get();
+        }
+        const std::chrono::duration<double> write_time = std::chrono::steady_clock::now() - write_start;
+
+        const auto statistics = file_writer.GetStatistics();
+        const std::chrono::duration<double, std::micro> caller_time = statistics.caller_time;
+        spdlog::info(std::format("I: '{}' file writer: {} files of {} bytes from {} threads in {:.3f} seconds. "
+                                 "{:.0f} files per second. Writing threads were held {:.1f} us per file. Errors: {}.",
+                                 FileWriterBackendToString(backend), file_count, file_size, writer_count,
+                                 write_time.count(), static_cast<double>(file_count) / write_time.count(),
+                                 caller_time.count() / static_cast<double>(file_count), errors));
+    }
+    fs::remove_all(benchmark_directory);
+}
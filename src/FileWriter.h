@@ -0,0 +1,153 @@
+// =====================================================================================
+//
+//       Filename:  FileWriter.h
+//
+//    Description:  Writes downloaded files for the download threads so they
+//                  can get back to downloading
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:58 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef FILEWRITER_H_
+#define FILEWRITER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Collector_Utils.h"
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  FileWriter
+//  Description:  writes whole files handed to it.
+//
+//                The 'stream' backend writes the file with an ofstream right
+//                away on the calling thread, the way downloads always have
+//                been.
+//
+//                The 'io_uring' backend queues the file and returns.  One
+//                thread of ours submits the open, write and close for many
+//                files at a time to an io_uring and collects the results.
+//                Files small enough are copied to buffers registered with
+//                the kernel up front.  Needs liburing at build time (make
+//                IO_URING=1) and a 5.15 or later kernel.  Without either,
+//                asking for it gets the 'stream' backend.
+// =====================================================================================
+class FileWriter
+{
+public:
+    enum class Backend
+    {
+        e_stream,
+        e_io_uring
+    };
+
+    struct Statistics
+    {
+        std::uint64_t files_written = 0;
+        std::uint64_t bytes_written = 0;
+        std::uint64_t errors = 0;
+
+        // how long callers of WriteFile were kept waiting.
+
+        std::chrono::steady_clock::duration caller_time{};
+    };
+
+    // ====================  LIFECYCLE     =======================================
+
+    FileWriter() = delete;
+    explicit FileWriter(Backend backend);
+
+    FileWriter(const FileWriter &rhs) = delete;
+    FileWriter(FileWriter &&rhs) = delete;
+
+    // waits for anything still being written.
+
+    ~FileWriter();
+
+    // ====================  ACCESSORS     =======================================
+
+    // what we ended up with.  Not always what was asked for.
+
+    [[nodiscard]] Backend GetBackend() const;
+
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    void LogStatistics() const;
+
+    // ====================  MUTATORS      =======================================
+
+    FileWriter &operator=(const FileWriter &rhs) = delete;
+    FileWriter &operator=(FileWriter &&rhs) = delete;
+
+    // creates or replaces file_name with data.  The file is there once the
+    // returned future is ready.  The future throws if it couldn't be written.
+    // Safe to call from any thread.
+
+    [[nodiscard]] std::future<void> WriteFile(const fs::path &file_name, std::vector<char> data);
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    struct IOUringWriter;
+
+    void WriteFileWithStream(const fs::path &file_name, const std::vector<char> &data);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    Statistics statistics_;
+    mutable std::mutex statistics_mutex_;
+
+    // not set for the 'stream' backend.  Last so it is gone before the
+    // statistics it updates.
+
+    std::unique_ptr<IOUringWriter> io_uring_writer_;
+
+}; // -----  end of class FileWriter  -----
+
+FileWriter::Backend FileWriterBackendFromString(COL::sview backend_name);
+std::string FileWriterBackendToString(FileWriter::Backend backend);
+
+// writes file_count files of file_size bytes in a scratch directory under
+// directory, from writer_count threads, with each backend we can use and
+// logs how long it took and how long the writing threads were held up.
+// The scratch directory is removed afterwards.
+
+void BenchmarkFileWriters(const fs::path &directory, std::size_t file_count, std::size_t file_size,
+                          int writer_count);
+
+#endif /* FILEWRITER_H_ */
@@ -0,0 +1,598 @@
+// =====================================================================================
+//
+//       Filename:  FilingCatalog.cpp
+//
+//    Description:  Implements local catalog of all the filings in our
+//    downloaded index files
+//
+//        Version:  1.0
+//        Created:  10/19/2026 04:40:05 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryFileUtils.h"
+#include "BinaryIndexFile.h"
+#include "CIKFilter.h"
+#include "FilingCatalog.h"
+#include "FormTypeMatcher.h"
+
+// the file starts with this header.  Everything after it is at an offset we
+// can compute from the counts in the header.  Each section starts on an 8 byte
+// boundary so everything can be used in place.
+//
+//  source sizes            uint64[source_count]
+//  source mtimes           int64[source_count]
+//  source name offsets     uint64[source_count + 1]
+//  source names            char[source_names_size]
+//  form type offsets       uint32[form_count + 1]
+//  form type names         char[form_names_size]
+//  CIKs                    uint32[row_count]
+//  form IDs                uint16[row_count]
+//  dates filed             int32[row_count]
+//  file name offsets       uint64[row_count + 1]
+//  form row starts         uint32[form_count + 1]
+//  rows by form            uint32[row_count]
+//  rows by date            uint32[row_count]
+//  file names              char[strings_size]
+
+namespace
+{
+constexpr std::array<char, 8> k_magic{'C', 'O', 'L', 'C', 'A', 'T', '0', '1'};
+constexpr std::uint32_t k_version = 1;
+
+struct CatalogHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t source_count;
+    std::uint32_t form_count;
+    std::uint32_t row_count;
+    std::uint64_t source_names_size;
+    std::uint64_t form_names_size;
+    std::uint64_t strings_size;
+};
+static_assert(sizeof(CatalogHeader) == 48);
+
+enum CatalogSection
+{
+    e_source_sizes,
+    e_source_mtimes,
+    e_source_name_offsets,
+    e_source_names,
+    e_form_offsets,
+    e_form_names,
+    e_CIKs,
+    e_form_IDs,
+    e_dates_filed,
+    e_file_name_offsets,
+    e_form_row_starts,
+    e_rows_by_form,
+    e_rows_by_date,
+    e_strings,
+    e_section_count
+};
+
+// returns the offset of each section plus the total file size at the end.
+
+std::array<std::size_t, e_section_count + 1> ComputeLayout(const CatalogHeader &header)
+{
+    const std::size_t sources = header.source_count;
+    const std::size_t forms = header.form_count;
+    const std::size_t rows = header.row_count;
+
+    const std::array<std::size_t, e_section_count> section_sizes{
+        sources * sizeof(std::uint64_t),    sources * sizeof(std::int64_t), (sources + 1) * sizeof(std::uint64_t),
+        header.source_names_size,           (forms + 1) * sizeof(std::uint32_t), header.form_names_size,
+        rows * sizeof(std::uint32_t),       rows * sizeof(std::uint16_t),        rows * sizeof(std::int32_t),
+        (rows + 1) * sizeof(std::uint64_t), (forms + 1) * sizeof(std::uint32_t), rows * sizeof(std::uint32_t),
+        rows * sizeof(std::uint32_t),       header.strings_size};
+
+    std::array<std::size_t, e_section_count + 1> offsets;
+    offsets[0] = AlignUp(sizeof(CatalogHeader));
+    for (int section = 0; section < e_section_count; ++section)
+    {
+        offsets[section + 1] = offsets[section] + section_sizes[section];
+        if (section + 1 < e_section_count)
+        {
+            offsets[section + 1] = AlignUp(offsets[section + 1]);
+        }
+    }
+    return offsets;
+}
+
+
+// split a blob of strings up using its offsets table.
+
+template <typename Offset>
+std::vector<COL::sview> SplitStrings(COL::sview blob, std::span<const Offset> offsets)
+{
+    std::vector<COL::sview> results;
+    results.reserve(offsets.size() - 1);
+    for (std::size_t i = 0; i + 1 < offsets.size(); ++i)
+    {
+        results.push_back(blob.substr(offsets[i], offsets[i + 1] - offsets[i]));
+    }
+    return results;
+}
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  FilingCatalog
+//      Method:  FilingCatalog
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+FilingCatalog::FilingCatalog(const fs::path &catalog_file_name)
+    : catalog_file_{catalog_file_name, MemoryMappedFile::AccessPattern::random}
+{
+    const auto data = catalog_file_.GetView();
+
+    if (data.size() < sizeof(CatalogHeader))
+    {
+        throw std::runtime_error(catenate("Catalog file: ", catalog_file_name.string(), " is too short."));
+    }
+
+    CatalogHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != k_magic || header.version != k_version)
+    {
+        throw std::runtime_error(
+            catenate("File: ", catalog_file_name.string(), " is not a version ", k_version, " catalog file."));
+    }
+
+    const auto layout = ComputeLayout(header);
+    if (layout[e_section_count] != data.size())
+    {
+        throw std::runtime_error(
+            catenate("Catalog file: ", catalog_file_name.string(), " has the wrong size for its contents."));
+    }
+
+    auto section = [&data, &layout](CatalogSection which) { return data.data() + layout[which]; };
+
+    source_sizes_ = {reinterpret_cast<const std::uint64_t *>(section(e_source_sizes)), header.source_count};
+    source_mtimes_ = {reinterpret_cast<const std::int64_t *>(section(e_source_mtimes)), header.source_count};
+    const std::span<const std::uint64_t> source_name_offsets{
+        reinterpret_cast<const std::uint64_t *>(section(e_source_name_offsets)), header.source_count + 1};
+    const COL::sview source_names{section(e_source_names), header.source_names_size};
+
+    const std::span<const std::uint32_t> form_offsets{
+        reinterpret_cast<const std::uint32_t *>(section(e_form_offsets)), header.form_count + 1};
+    const COL::sview form_names{section(e_form_names), header.form_names_size};
+
+    CIKs_ = {reinterpret_cast<const std::uint32_t *>(section(e_CIKs)), header.row_count};
+    form_IDs_ = {reinterpret_cast<const std::uint16_t *>(section(e_form_IDs)), header.row_count};
+    dates_filed_ = {reinterpret_cast<const std::int32_t *>(section(e_dates_filed)), header.row_count};
+    file_name_offsets_ = {reinterpret_cast<const std::uint64_t *>(section(e_file_name_offsets)),
+                          header.row_count + 1};
+    form_row_starts_ = {reinterpret_cast<const std::uint32_t *>(section(e_form_row_starts)), header.form_count + 1};
+    rows_by_form_ = {reinterpret_cast<const std::uint32_t *>(section(e_rows_by_form)), header.row_count};
+    rows_by_date_ = {reinterpret_cast<const std::uint32_t *>(section(e_rows_by_date)), header.row_count};
+    strings_ = {section(e_strings), header.strings_size};
+
+    // a damaged file could send us off the end of our mapping so check the
+    // things we will be using as offsets and indexes.
+
+    auto row_in_range = [&header](auto row) { return row < header.row_count; };
+    auto form_in_range = [&header](auto form_ID) { return form_ID < header.form_count; };
+
+    if (!std::ranges::is_sorted(source_name_offsets) || source_name_offsets.back() != source_names.size() ||
+        !std::ranges::is_sorted(form_offsets) || form_offsets.back() != form_names.size() ||
+        !std::ranges::is_sorted(form_row_starts_) || form_row_starts_.back() != header.row_count ||
+        !std::ranges::is_sorted(file_name_offsets_) || file_name_offsets_.back() != strings_.size() ||
+        !std::ranges::all_of(form_IDs_, form_in_range) || !std::ranges::all_of(rows_by_form_, row_in_range) ||
+        !std::ranges::all_of(rows_by_date_, row_in_range))
+    {
+        throw std::runtime_error(catenate("Catalog file: ", catalog_file_name.string(), " is damaged."));
+    }
+
+    source_names_ = SplitStrings(source_names, source_name_offsets);
+    form_types_ = SplitStrings(form_names, form_offsets);
+} // -----  end of method FilingCatalog::FilingCatalog  (constructor)  -----
+
+FilingCatalog FilingCatalog::OpenForIndexDirectory(const fs::path &catalog_file_name, const fs::path &index_directory)
+{
+    const auto index_files = FindIndexFiles(index_directory);
+
+    if (fs::exists(catalog_file_name))
+    {
+        try
+        {
+            FilingCatalog catalog{catalog_file_name};
+            if (catalog.IsCurrentFor(index_files))
+            {
+                spdlog::debug(catenate("C: Using catalog: ", catalog_file_name.string(), " with ",
+                                       catalog.GetRowCount(), " filings from ", catalog.GetSourceCount(),
+                                       " index files."));
+                return catalog;
+            }
+            spdlog::info(catenate("C: Index files have changed. Rebuilding catalog: ", catalog_file_name.string()));
+        }
+        catch (const std::runtime_error &e)
+        {
+            spdlog::info(catenate("C: ", e.what(), " Rebuilding it."));
+        }
+    }
+
+    BuildCatalog(catalog_file_name, index_files);
+    return FilingCatalog{catalog_file_name};
+} // -----  end of method FilingCatalog::OpenForIndexDirectory  -----
+
+bool FilingCatalog::IsCurrentFor(const std::vector<fs::path> &index_files) const
+{
+    if (index_files.size() != source_names_.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < index_files.size(); ++i)
+    {
+        std::error_code err;
+        const auto file_size = fs::file_size(index_files[i], err);
+        if (err || index_files[i].string() != source_names_[i] || file_size != source_sizes_[i] ||
+            FileModificationTime(index_files[i]) != source_mtimes_[i])
+        {
+            return false;
+        }
+    }
+    return true;
+} // -----  end of method FilingCatalog::IsCurrentFor  -----
+
+std::vector<fs::path> FilingCatalog::FindIndexFiles(const fs::path &index_directory)
+{
+    // we only want the master and form index files.  They have the same data,
+    // just sorted differently.
+
+    std::vector<fs::path> results;
+    for (const auto &entry : fs::recursive_directory_iterator{index_directory})
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".idx")
+        {
+            continue;
+        }
+        const auto file_name = entry.path().filename().string();
+        if (file_name.starts_with("master") || file_name.starts_with("form"))
+        {
+            results.push_back(entry.path());
+        }
+    }
+    std::ranges::sort(results);
+    return results;
+} // -----  end of method FilingCatalog::FindIndexFiles  -----
+
+void FilingCatalog::BuildCatalog(const fs::path &catalog_file_name, const std::vector<fs::path> &index_files)
+{
+    const auto build_start = std::chrono::steady_clock::now();
+
+    // get these before we read anything.  If an index file changes while we
+    // are working, the catalog will just look out of date next time.
+
+    std::vector<std::uint64_t> source_sizes;
+    std::vector<std::int64_t> source_mtimes;
+    std::vector<std::uint64_t> source_name_offsets{0};
+    std::string source_names;
+
+    for (const auto &index_file : index_files)
+    {
+        source_sizes.push_back(fs::file_size(index_file));
+        source_mtimes.push_back(FileModificationTime(index_file));
+        source_names.append(index_file.string());
+        source_name_offsets.push_back(source_names.size());
+    }
+
+    // we read the binary copies of the index files.  Any we don't have yet
+    // get made here so do that concurrently.
+
+    std::vector<std::optional<BinaryIndexFile>> indexes(index_files.size());
+    std::atomic<std::size_t> next_file{0};
+
+    auto open_files = [&]() {
+        for (auto i = next_file++; i < index_files.size(); i = next_file++)
+        {
+            indexes[i].emplace(BinaryIndexFile::OpenForTextIndexFile(index_files[i]));
+        }
+    };
+
+    std::vector<std::future<void>> tasks;
+    for (unsigned int i = 0; i < std::max(1U, std::thread::hardware_concurrency()); ++i)
+    {
+        tasks.emplace_back(std::async(std::launch::async, open_files));
+    }
+    std::exception_ptr first_error;
+    for (auto &task : tasks)
+    {
+        try
+        {
+            task.get();
+        }
+        catch (...)
+        {
+            if (!first_error)
+            {
+                first_error = std::current_exception();
+            }
+        }
+    }
+    if (first_error)
+    {
+        std::rethrow_exception(first_error);
+    }
+
+    // every index file has its own form type table.  Make one sorted table
+    // for the catalog and map each file's form IDs into it.
+
+    std::set<COL::sview> all_form_types;
+    for (const auto &index : indexes)
+    {
+        all_form_types.insert(index->GetFormTypes().begin(), index->GetFormTypes().end());
+    }
+    BOOST_ASSERT_MSG(all_form_types.size() < std::numeric_limits<std::uint16_t>::max(),
+                     "Too many form types for catalog.");
+
+    const std::vector<COL::sview> form_types(all_form_types.begin(), all_form_types.end());
+
+    std::vector<std::vector<std::uint16_t>> form_ID_maps;
+    std::size_t total_rows{0};
+    for (const auto &index : indexes)
+    {
+        auto &form_ID_map = form_ID_maps.emplace_back();
+        for (const auto form_type : index->GetFormTypes())
+        {
+            form_ID_map.push_back(
+                static_cast<std::uint16_t>(std::ranges::lower_bound(form_types, form_type) - form_types.begin()));
+        }
+        total_rows += index->GetRowCount();
+    }
+    BOOST_ASSERT_MSG(total_rows < std::numeric_limits<std::uint32_t>::max(), "Too many filings for catalog.");
+
+    // now, gather up all the rows, put them in catalog order and drop the
+    // duplicates.
+
+    struct RowRef
+    {
+        std::uint32_t CIK;
+        std::int32_t date_filed;
+        std::uint16_t form_ID;
+        std::uint32_t source;
+        std::uint32_t row;
+    };
+
+    std::vector<RowRef> rows;
+    rows.reserve(total_rows);
+    for (std::uint32_t source = 0; source < indexes.size(); ++source)
+    {
+        const auto &index = *indexes[source];
+        for (std::uint32_t row = 0; row < index.GetRowCount(); ++row)
+        {
+            rows.push_back({index.GetCIKs()[row], index.GetDatesFiled()[row],
+                            form_ID_maps[source][index.GetFormIDs()[row]], source, row});
+        }
+    }
+
+    auto file_name = [&indexes](const RowRef &row) { return indexes[row.source]->GetFileName(row.row); };
+    auto row_key = [&file_name](const RowRef &row) {
+        return std::tuple(row.CIK, row.date_filed, row.form_ID, file_name(row));
+    };
+
+    std::ranges::sort(rows, [&row_key](const auto &lhs, const auto &rhs) { return row_key(lhs) < row_key(rhs); });
+    const auto duplicates =
+        std::ranges::unique(rows, [&row_key](const auto &lhs, const auto &rhs) { return row_key(lhs) == row_key(rhs); });
+    rows.erase(duplicates.begin(), duplicates.end());
+
+    // pull out our columns.
+
+    const auto row_count = static_cast<std::uint32_t>(rows.size());
+
+    std::vector<std::uint32_t> CIKs;
+    std::vector<std::uint16_t> form_IDs;
+    std::vector<std::int32_t> dates_filed;
+    std::vector<std::uint64_t> file_name_offsets{0};
+    std::string file_names;
+
+    CIKs.reserve(row_count);
+    form_IDs.reserve(row_count);
+    dates_filed.reserve(row_count);
+    file_name_offsets.reserve(row_count + 1);
+
+    for (const auto &row : rows)
+    {
+        CIKs.push_back(row.CIK);
+        form_IDs.push_back(row.form_ID);
+        dates_filed.push_back(row.date_filed);
+        file_names.append(file_name(row));
+        file_name_offsets.push_back(file_names.size());
+    }
+
+    std::vector<std::uint32_t> form_offsets{0};
+    std::string form_names;
+    for (const auto form_type : form_types)
+    {
+        form_names.append(form_type);
+        form_offsets.push_back(static_cast<std::uint32_t>(form_names.size()));
+    }
+
+    // our secondary orderings.  Ties are broken by row number so they are in
+    // catalog order within a form or date.
+
+    std::vector<std::uint32_t> rows_by_form(row_count);
+    std::iota(rows_by_form.begin(), rows_by_form.end(), std::uint32_t{0});
+    std::ranges::sort(rows_by_form, {}, [&](auto row) { return std::tuple(form_IDs[row], dates_filed[row], row); });
+
+    std::vector<std::uint32_t> form_row_starts(form_types.size() + 1, 0);
+    for (const auto form_ID : form_IDs)
+    {
+        ++form_row_starts[form_ID + 1];
+    }
+    for (std::size_t i = 1; i < form_row_starts.size(); ++i)
+    {
+        form_row_starts[i] += form_row_starts[i - 1];
+    }
+
+    std::vector<std::uint32_t> rows_by_date(row_count);
+    std::iota(rows_by_date.begin(), rows_by_date.end(), std::uint32_t{0});
+    std::ranges::sort(rows_by_date, {}, [&](auto row) { return std::pair(dates_filed[row], row); });
+
+    CatalogHeader header{};
+    header.magic = k_magic;
+    header.version = k_version;
+    header.source_count = static_cast<std::uint32_t>(index_files.size());
+    header.form_count = static_cast<std::uint32_t>(form_types.size());
+    header.row_count = row_count;
+    header.source_names_size = source_names.size();
+    header.form_names_size = form_names.size();
+    header.strings_size = file_names.size();
+
+    // write under a temporary name then rename so anyone else looking for
+    // this file sees all of it or none of it.
+
+    const auto temp_file_name = MakeTempFileName(catalog_file_name);
+
+    {
+        std::ofstream output{temp_file_name, std::ios::out | std::ios::binary | std::ios::trunc};
+        BOOST_ASSERT_MSG(output.is_open(), catenate("Unable to open catalog file: ", temp_file_name.string()).c_str());
+
+        WriteSection(output, &header, 1);
+        WriteSection(output, source_sizes.data(), source_sizes.size());
+        WriteSection(output, source_mtimes.data(), source_mtimes.size());
+        WriteSection(output, source_name_offsets.data(), source_name_offsets.size());
+        WriteSection(output, source_names.data(), source_names.size());
+        WriteSection(output, form_offsets.data(), form_offsets.size());
+        WriteSection(output, form_names.data(), form_names.size());
+        WriteSection(output, CIKs.data(), CIKs.size());
+        WriteSection(output, form_IDs.data(), form_IDs.size());
+        WriteSection(output, dates_filed.data(), dates_filed.size());
+        WriteSection(output, file_name_offsets.data(), file_name_offsets.size());
+        WriteSection(output, form_row_starts.data(), form_row_starts.size());
+        WriteSection(output, rows_by_form.data(), rows_by_form.size());
+        WriteSection(output, rows_by_date.data(), rows_by_date.size());
+        output.write(file_names.data(), static_cast<std::streamsize>(file_names.size()));
+
+        output.close();
+        if (output.fail())
+        {
+            fs::remove(temp_file_name);
+            throw std::runtime_error(catenate("Unable to write catalog file: ", temp_file_name.string()));
+        }
+    }
+    fs::rename(temp_file_name, catalog_file_name);
+
+    const std::chrono::duration<double> build_time = std::chrono::steady_clock::now() - build_start;
+
+    spdlog::info(std::format("C: Built catalog: {} with {} filings ({} duplicates dropped) from {} index files in "
+                             "{:.3f} seconds.",
+                             catalog_file_name, row_count, total_rows - row_count, index_files.size(),
+                             build_time.count()));
+} // -----  end of method FilingCatalog::BuildCatalog  -----
+
+std::vector<std::uint32_t> FilingCatalog::FindFilings(const FormTypeMatcher &form_matcher,
+                                                      const CIKFilter &cik_filter,
+                                                      std::optional<std::chrono::sys_days> begin_date,
+                                                      std::optional<std::chrono::sys_days> end_date) const
+{
+    const std::int32_t first_day = begin_date ? static_cast<std::int32_t>(begin_date->time_since_epoch().count())
+                                              : std::numeric_limits<std::int32_t>::min();
+    const std::int32_t last_day = end_date ? static_cast<std::int32_t>(end_date->time_since_epoch().count())
+                                           : std::numeric_limits<std::int32_t>::max();
+
+    // there are only a few hundred form types so match them all once.
+
+    std::vector<bool> form_wanted(form_types_.size());
+    for (std::size_t form_ID = 0; form_ID < form_types_.size(); ++form_ID)
+    {
+        form_wanted[form_ID] = form_matcher.Match(form_types_[form_ID]).has_value();
+    }
+
+    // given a list of rows in date order, find the ones in our date range.
+
+    auto in_date_range = [&](std::span<const std::uint32_t> rows) {
+        auto first = std::ranges::partition_point(rows, [&](auto row) { return dates_filed_[row] < first_day; });
+        auto last = std::ranges::partition_point(rows, [&](auto row) { return dates_filed_[row] <= last_day; });
+        return std::span<const std::uint32_t>{first, std::max(first, last)};
+    };
+
+    std::vector<std::uint32_t> results;
+
+    if (cik_filter.IsActive())
+    {
+        // rows are in CIK then date order so the rows for a CIK in our date
+        // range are all together.  The filter's CIKs are sorted so results
+        // come out in catalog order.
+
+        for (const auto CIK : cik_filter.GetCIKs())
+        {
+            const auto [CIK_first, CIK_last] = std::ranges::equal_range(CIKs_, CIK);
+            auto first = static_cast<std::uint32_t>(CIK_first - CIKs_.begin());
+            auto last = static_cast<std::uint32_t>(CIK_last - CIKs_.begin());
+
+            const auto dates = dates_filed_.subspan(first, last - first);
+            last = first + static_cast<std::uint32_t>(std::ranges::upper_bound(dates, last_day) - dates.begin());
+            first += static_cast<std::uint32_t>(std::ranges::lower_bound(dates, first_day) - dates.begin());
+
+            for (auto row = first; row < last; ++row)
+            {
+                if (form_wanted[form_IDs_[row]])
+                {
+                    results.push_back(row);
+                }
+            }
+        }
+        return results;
+    }
+
+    if (!form_matcher.MatchesEverything())
+    {
+        for (std::size_t form_ID = 0; form_ID < form_types_.size(); ++form_ID)
+        {
+            if (form_wanted[form_ID])
+            {
+                const auto form_rows =
+                    rows_by_form_.subspan(form_row_starts_[form_ID], form_row_starts_[form_ID + 1] - form_row_starts_[form_ID]);
+                std::ranges::copy(in_date_range(form_rows), std::back_inserter(results));
+            }
+        }
+    }
+    else
+    {
+        std::ranges::copy(in_date_range(rows_by_date_), std::back_inserter(results));
+    }
+
+    std::ranges::sort(results);
+    return results;
+} // -----  end of method FilingCatalog::FindFilings  -----
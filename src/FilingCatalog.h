@@ -0,0 +1,177 @@
+// =====================================================================================
+//
+//       Filename:  FilingCatalog.h
+//
+//    Description:  Local catalog of all the filings in our downloaded index
+//                  files
+//
+//        Version:  1.0
+//        Created:  10/19/2026 04:21:37 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef FILINGCATALOG_H_
+#define FILINGCATALOG_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Collector_Utils.h"
+#include "MemoryMappedFile.h"
+
+namespace fs = std::filesystem;
+
+class CIKFilter;
+class FormTypeMatcher;
+
+// =====================================================================================
+//        Class:  FilingCatalog
+//  Description:  one file holding every row from all the daily and quarterly
+//                index files under an index directory.  Duplicate rows (the
+//                same filing shows up in daily and quarterly indexes) are
+//                dropped.
+//
+//                Rows are sorted by CIK, then date filed, then form type so
+//                CIK queries are binary searches.  There are also secondary
+//                orderings of the rows by form type (then date) and by date
+//                so any combination of CIK, form and date range can be
+//                answered without looking at every row.
+//
+//                The catalog remembers which index files it was built from
+//                (and their sizes and modification times) and is rebuilt
+//                when that changes.
+// =====================================================================================
+class FilingCatalog
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    FilingCatalog() = delete;
+
+    // throws if the file is not a valid catalog file.
+
+    explicit FilingCatalog(const fs::path &catalog_file_name);
+
+    FilingCatalog(const FilingCatalog &rhs) = delete;
+    FilingCatalog(FilingCatalog &&rhs) noexcept = default;
+
+    ~FilingCatalog() = default;
+
+    // use the existing catalog if it is up to date with the index files in
+    // the given directory, otherwise build a new one.
+
+    static FilingCatalog OpenForIndexDirectory(const fs::path &catalog_file_name, const fs::path &index_directory);
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] std::size_t GetRowCount() const
+    {
+        return CIKs_.size();
+    }
+    [[nodiscard]] std::size_t GetSourceCount() const
+    {
+        return source_names_.size();
+    }
+
+    [[nodiscard]] std::uint32_t GetCIK(std::uint32_t row) const
+    {
+        return CIKs_[row];
+    }
+    [[nodiscard]] COL::sview GetFormType(std::uint32_t row) const
+    {
+        return form_types_[form_IDs_[row]];
+    }
+    [[nodiscard]] std::chrono::sys_days GetDateFiled(std::uint32_t row) const
+    {
+        return std::chrono::sys_days{std::chrono::days{dates_filed_[row]}};
+    }
+    [[nodiscard]] COL::sview GetFileName(std::uint32_t row) const
+    {
+        return strings_.substr(file_name_offsets_[row], file_name_offsets_[row + 1] - file_name_offsets_[row]);
+    }
+
+    // returns the matching rows in catalog order (CIK, date filed, form type).
+    // Dates are a closed interval and either end can be left open.
+
+    [[nodiscard]] std::vector<std::uint32_t> FindFilings(const FormTypeMatcher &form_matcher,
+                                                         const CIKFilter &cik_filter,
+                                                         std::optional<std::chrono::sys_days> begin_date,
+                                                         std::optional<std::chrono::sys_days> end_date) const;
+
+    // ====================  MUTATORS      =======================================
+
+    FilingCatalog &operator=(const FilingCatalog &rhs) = delete;
+    FilingCatalog &operator=(FilingCatalog &&rhs) noexcept = default;
+
+    // ====================  OPERATORS     =======================================
+
+    // the master and form index files under the given directory, in path order.
+
+    static std::vector<fs::path> FindIndexFiles(const fs::path &index_directory);
+
+    // read all the index files (using their binary copies) and write a new
+    // catalog.  Written under a temporary name and renamed into place.
+
+    static void BuildCatalog(const fs::path &catalog_file_name, const std::vector<fs::path> &index_files);
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // was this catalog built from exactly these files as they are now.
+
+    [[nodiscard]] bool IsCurrentFor(const std::vector<fs::path> &index_files) const;
+
+    // ====================  DATA MEMBERS  =======================================
+
+    MemoryMappedFile catalog_file_;
+
+    std::vector<COL::sview> source_names_;
+    std::span<const std::uint64_t> source_sizes_;
+    std::span<const std::int64_t> source_mtimes_;
+
+    // form types are sorted so form IDs are in form type order.
+
+    std::vector<COL::sview> form_types_;
+
+    std::span<const std::uint32_t> CIKs_;
+    std::span<const std::uint16_t> form_IDs_;
+    std::span<const std::int32_t> dates_filed_;
+    std::span<const std::uint64_t> file_name_offsets_;
+    COL::sview strings_;
+
+    // secondary orderings.  Rows for form ID N are rows_by_form_[form_row_starts_[N], form_row_starts_[N+1]).
+
+    std::span<const std::uint32_t> form_row_starts_;
+    std::span<const std::uint32_t> rows_by_form_;
+    std::span<const std::uint32_t> rows_by_date_;
+
+}; // -----  end of class FilingCatalog  -----
+
+#endif /* FILINGCATALOG_H_ */
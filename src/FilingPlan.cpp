@@ -0,0 +1,204 @@
+// =====================================================================================
+//
+//       Filename:  FilingPlan.cpp
+//
+//    Description:  Implements compact list of the filings we plan to download
+//
+//        Version:  1.0
+//        Created:  10/19/2026 08:11:40 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include "FilingPlan.h"
+
+//--------------------------------------------------------------------------------------
+//       Class:  FilingPlan
+//      Method:  FilingPlan
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+FilingPlan::FilingPlan(std::vector<std::string> form_types, std::vector<Filing> filings, std::string file_names)
+    : form_types_{std::move(form_types)}, filings_{std::move(filings)}, file_names_{std::move(file_names)}
+{
+    if (form_types_.size() > std::numeric_limits<std::uint16_t>::max() ||
+        std::ranges::any_of(filings_,
+                            [this](const auto &filing) {
+                                return filing.form_ID >= form_types_.size() ||
+                                       std::size_t{filing.file_name_offset} + filing.file_name_length >
+                                           file_names_.size();
+                            }))
+    {
+        throw std::runtime_error("Filing plan data is not consistent.");
+    }
+
+    for (std::size_t form_ID = 0; form_ID < form_types_.size(); ++form_ID)
+    {
+        form_IDs_.emplace(form_types_[form_ID], static_cast<std::uint16_t>(form_ID));
+    }
+    sorted_by_form_type_ = std::ranges::is_sorted(
+        filings_, [this](const auto &a, const auto &b) { return form_types_[a.form_ID] < form_types_[b.form_ID]; });
+} // -----  end of method FilingPlan::FilingPlan  (constructor)  -----
+
+fs::path FilingPlan::GetRemoteFileName(const Filing &filing) const
+{
+    fs::path remote_file_name{"/Archives"};
+    remote_file_name /= GetFileName(filing);
+    return remote_file_name;
+} // -----  end of method FilingPlan::GetRemoteFileName  -----
+
+std::vector<std::pair<COL::sview, std::span<const FilingPlan::Filing>>> FilingPlan::GetFilingsByFormType() const
+{
+    BOOST_ASSERT_MSG(sorted_by_form_type_, "Filing plan must be sorted by form type.");
+
+    std::vector<std::pair<COL::sview, std::span<const Filing>>> results;
+
+    for (auto first = filings_.begin(); first != filings_.end();)
+    {
+        const auto form_ID = first->form_ID;
+        const auto last = std::find_if(first, filings_.end(), [form_ID](const auto &f) { return f.form_ID != form_ID; });
+        results.emplace_back(form_types_[form_ID], std::span<const Filing>{first, last});
+        first = last;
+    }
+    return results;
+} // -----  end of method FilingPlan::GetFilingsByFormType  -----
+
+std::size_t FilingPlan::GetMemoryUsed() const
+{
+    std::size_t memory_used = sizeof(FilingPlan) + filings_.capacity() * sizeof(Filing) + file_names_.capacity();
+    for (const auto &form_type : form_types_)
+    {
+        // count each form type twice for the lookup table.
+
+        memory_used += 2 * (sizeof(std::string) + form_type.capacity());
+    }
+    return memory_used;
+} // -----  end of method FilingPlan::GetMemoryUsed  -----
+
+std::uint16_t FilingPlan::InternFormType(COL::sview form_type)
+{
+    if (auto found = form_IDs_.find(form_type); found != form_IDs_.end())
+    {
+        return found->second;
+    }
+
+    BOOST_ASSERT_MSG(form_types_.size() < std::numeric_limits<std::uint16_t>::max(),
+                     "Too many form types in filing plan.");
+
+    const auto form_ID = static_cast<std::uint16_t>(form_types_.size());
+    form_types_.emplace_back(form_type);
+    form_IDs_.emplace(form_types_.back(), form_ID);
+    return form_ID;
+} // -----  end of method FilingPlan::InternFormType  -----
+
+void FilingPlan::AddFiling(std::uint16_t form_ID, std::uint32_t CIK, std::chrono::sys_days date_filed,
+                           COL::sview file_name)
+{
+    // file names in text index files can have trailing white space.
+
+    file_name.remove_suffix(file_name.size() - (file_name.find_last_not_of(" \r\t") + 1));
+
+    BOOST_ASSERT_MSG(file_names_.size() + file_name.size() < std::numeric_limits<std::uint32_t>::max(),
+                     "Too many file names in filing plan.");
+
+    if (!filings_.empty() && form_types_[form_ID] < form_types_[filings_.back().form_ID])
+    {
+        sorted_by_form_type_ = false;
+    }
+
+    filings_.push_back(Filing{.CIK = CIK,
+                              .date_filed = date_filed.time_since_epoch().count(),
+                              .file_name_offset = static_cast<std::uint32_t>(file_names_.size()),
+                              .file_name_length = static_cast<std::uint32_t>(file_name.size()),
+                              .form_ID = form_ID});
+    file_names_.append(file_name);
+} // -----  end of method FilingPlan::AddFiling  -----
+
+void FilingPlan::Append(const FilingPlan &other)
+{
+    // the other plan numbers its form types its own way.
+
+    std::vector<std::uint16_t> form_IDs;
+    form_IDs.reserve(other.form_types_.size());
+    for (const auto &form_type : other.form_types_)
+    {
+        form_IDs.push_back(InternFormType(form_type));
+    }
+
+    filings_.reserve(filings_.size() + other.filings_.size());
+    file_names_.reserve(file_names_.size() + other.file_names_.size());
+
+    for (const auto &filing : other.filings_)
+    {
+        AddFiling(form_IDs[filing.form_ID], filing.CIK, other.GetDateFiled(filing), other.GetFileName(filing));
+    }
+} // -----  end of method FilingPlan::Append  -----
+
+void FilingPlan::SortByFormType()
+{
+    if (sorted_by_form_type_)
+    {
+        return;
+    }
+
+    // form IDs are in the order we first saw each form type so sort on each
+    // form type's position in name order.
+
+    std::vector<std::uint16_t> form_ranks(form_types_.size());
+    for (std::uint16_t rank = 0; const auto &[form_type, form_ID] : form_IDs_)
+    {
+        form_ranks[form_ID] = rank++;
+    }
+
+    std::ranges::stable_sort(filings_, {}, [&form_ranks](const auto &filing) { return form_ranks[filing.form_ID]; });
+    sorted_by_form_type_ = true;
+} // -----  end of method FilingPlan::SortByFormType  -----
+
+void FilingPlan::LimitFilingsPerFormType(std::size_t max_per_form_type)
+{
+    SortByFormType();
+
+    std::vector<Filing> kept_filings;
+    kept_filings.reserve(filings_.size());
+
+    for (const auto &[form_type, form_filings] : GetFilingsByFormType())
+    {
+        std::vector<Filing> these_filings{form_filings.begin(), form_filings.end()};
+        if (these_filings.size() > max_per_form_type)
+        {
+            std::default_random_engine dre;
+            std::shuffle(these_filings.begin(), these_filings.end(), dre);
+            these_filings.resize(max_per_form_type);
+        }
+        kept_filings.insert(kept_filings.end(), these_filings.begin(), these_filings.end());
+    }
+
+    // the dropped file names stay in the string.  Not worth compacting it.
+
+    filings_ = std::move(kept_filings);
+} // -----  end of method FilingPlan::LimitFilingsPerFormType  -----
@@ -0,0 +1,186 @@
+// =====================================================================================
+//
+//       Filename:  FilingPlan.h
+//
+//    Description:  Compact list of the filings we plan to download
+//
+//        Version:  1.0
+//        Created:  10/19/2026 08:03:17 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef FILINGPLAN_H_
+#define FILINGPLAN_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Collector_Utils.h"
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  FilingPlan
+//  Description:  the filings found in the index files which we want to
+//                download.
+//
+//                A big backfill can find a million or more filings so rather
+//                than a path object (and its allocations) per filing, each
+//                filing is a small fixed size record and all the file names
+//                are kept end to end in one string.  Form types are interned
+//                and referred to by ID.
+//
+//                Remote and local path names are only made when a filing is
+//                actually downloaded.
+// =====================================================================================
+class FilingPlan
+{
+public:
+    struct Filing
+    {
+        std::uint32_t CIK;
+        std::int32_t date_filed;        // days since 1970-01-01
+        std::uint32_t file_name_offset; // into our file names string
+        std::uint32_t file_name_length;
+        std::uint16_t form_ID;
+    };
+
+    // ====================  LIFECYCLE     =======================================
+
+    FilingPlan() = default;
+
+    // put back together a plan saved from its pieces.  Throws if they don't
+    // fit together.
+
+    FilingPlan(std::vector<std::string> form_types, std::vector<Filing> filings, std::string file_names);
+
+    FilingPlan(const FilingPlan &rhs) = default;
+    FilingPlan(FilingPlan &&rhs) noexcept = default;
+
+    ~FilingPlan() = default;
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] std::size_t GetFilingCount() const
+    {
+        return filings_.size();
+    }
+    [[nodiscard]] bool IsEmpty() const
+    {
+        return filings_.empty();
+    }
+    [[nodiscard]] const std::vector<std::string> &GetFormTypes() const
+    {
+        return form_types_;
+    }
+    [[nodiscard]] const std::vector<Filing> &GetFilings() const
+    {
+        return filings_;
+    }
+    [[nodiscard]] const std::string &GetFileNames() const
+    {
+        return file_names_;
+    }
+
+    [[nodiscard]] COL::sview GetFormType(const Filing &filing) const
+    {
+        return form_types_[filing.form_ID];
+    }
+    [[nodiscard]] std::chrono::sys_days GetDateFiled(const Filing &filing) const
+    {
+        return std::chrono::sys_days{std::chrono::days{filing.date_filed}};
+    }
+    [[nodiscard]] COL::sview GetFileName(const Filing &filing) const
+    {
+        return COL::sview{file_names_}.substr(filing.file_name_offset, filing.file_name_length);
+    }
+
+    // the name to ask the server for.
+
+    [[nodiscard]] fs::path GetRemoteFileName(const Filing &filing) const;
+
+    // the filings for each form type, in form type order.  The plan must
+    // have been sorted by form type.
+
+    [[nodiscard]] std::vector<std::pair<COL::sview, std::span<const Filing>>> GetFilingsByFormType() const;
+
+    // what the plan is taking up in memory.
+
+    [[nodiscard]] std::size_t GetMemoryUsed() const;
+
+    // ====================  MUTATORS      =======================================
+
+    FilingPlan &operator=(const FilingPlan &rhs) = default;
+    FilingPlan &operator=(FilingPlan &&rhs) noexcept = default;
+
+    // returns the ID to use for the form type with AddFiling.
+
+    std::uint16_t InternFormType(COL::sview form_type);
+
+    void AddFiling(std::uint16_t form_ID, std::uint32_t CIK, std::chrono::sys_days date_filed, COL::sview file_name);
+    void AddFiling(COL::sview form_type, std::uint32_t CIK, std::chrono::sys_days date_filed, COL::sview file_name)
+    {
+        AddFiling(InternFormType(form_type), CIK, date_filed, file_name);
+    }
+
+    // adds the other plan's filings after ours.
+
+    void Append(const FilingPlan &other);
+
+    // groups the filings by form type.  Filings for the same form type stay
+    // in the order they were added.
+
+    void SortByFormType();
+
+    // keep at most this many filings for each form type, picked at random.
+
+    void LimitFilingsPerFormType(std::size_t max_per_form_type);
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // ====================  DATA MEMBERS  =======================================
+
+    std::vector<std::string> form_types_;
+    std::map<std::string, std::uint16_t, std::less<>> form_IDs_;
+
+    std::vector<Filing> filings_;
+    std::string file_names_;
+
+    bool sorted_by_form_type_ = true;
+
+}; // -----  end of class FilingPlan  -----
+
+#endif /* FILINGPLAN_H_ */
@@ -0,0 +1,323 @@
+// =====================================================================================
+//
+//       Filename:  FormDirectoryLayout.cpp
+//
+//    Description:  Where the <CIK> directories go in the form directory
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:58:40 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryFileUtils.h"
+#include "FormDirectoryLayout.h"
+
+namespace
+{
+constexpr const char *k_layout_file_name = ".layout";
+
+constexpr std::size_t k_padded_CIK_size = 10;
+
+// how many files to look up when measuring lookup times.
+
+constexpr std::size_t k_lookup_sample_count = 10'000;
+
+std::string PadCIK(COL::sview CIK_directory)
+{
+    std::string padded_CIK(CIK_directory.size() < k_padded_CIK_size ? k_padded_CIK_size - CIK_directory.size() : 0,
+                           '0');
+    padded_CIK += CIK_directory;
+    return padded_CIK;
+}
+
+bool IsCIKDirectoryName(const std::string &name)
+{
+    return name.size() == k_padded_CIK_size && std::ranges::all_of(name, [](char c) { return c >= '0' && c <= '9'; });
+}
+
+bool IsShardDirectoryName(const std::string &name)
+{
+    return name.size() == 2 && std::ranges::all_of(name, [](char c) {
+               return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+           });
+}
+
+void ForEachSubdirectory(const fs::path &directory,
+                         const std::function<bool(const std::string &)> &wanted,
+                         const std::function<void(const fs::path &)> &handle_directory)
+{
+    for (const auto &dir_entry : fs::directory_iterator(directory, fs::directory_options::skip_permission_denied))
+    {
+        if (dir_entry.is_directory() && wanted(dir_entry.path().filename().string()))
+        {
+            handle_directory(dir_entry.path());
+        }
+    }
+}
+
+// moves what we can of from into to, which is already there.  Anything
+// already in to is kept.
+
+void MergeDirectory(const fs::path &from, const fs::path &to)
+{
+    for (const auto &dir_entry : fs::directory_iterator(from))
+    {
+        const auto target = to / dir_entry.path().filename();
+        if (!fs::exists(target))
+        {
+            fs::rename(dir_entry.path(), target);
+        }
+        else if (dir_entry.is_directory() && fs::is_directory(target))
+        {
+            MergeDirectory(dir_entry.path(), target);
+        }
+        else
+        {
+            spdlog::info(catenate("L: Already have: ", target.string(), ". Leaving: ", dir_entry.path().string()));
+        }
+    }
+
+    std::error_code ec;
+    fs::remove(from, ec);
+}
+
+// <CIK>, <form name>/<file> pairs to look up.
+
+using LookupSample = std::vector<std::pair<std::string, fs::path>>;
+
+LookupSample PickLookupSample(const std::vector<fs::path> &CIK_directories)
+{
+    LookupSample sample;
+    const auto step = std::max<std::size_t>(1, CIK_directories.size() / k_lookup_sample_count);
+    for (std::size_t i = 0; i < CIK_directories.size(); i += step)
+    {
+        for (const auto &form_entry : fs::directory_iterator(CIK_directories[i]))
+        {
+            if (!form_entry.is_directory())
+            {
+                continue;
+            }
+            if (auto file_entry = fs::directory_iterator(form_entry.path()); file_entry != fs::directory_iterator())
+            {
+                sample.emplace_back(CIK_directories[i].filename().string(),
+                                    form_entry.path().filename() / file_entry->path().filename());
+                break;
+            }
+        }
+    }
+    return sample;
+}
+
+// average microseconds to find each sample file.
+
+double MeasureLookups(const fs::path &local_form_directory, FormDirectoryLayout layout, const LookupSample &sample)
+{
+    if (sample.empty())
+    {
+        return 0.0;
+    }
+    std::size_t found_count = 0;
+    const auto lookup_start = std::chrono::steady_clock::now();
+    for (const auto &[CIK, form_file_name] : sample)
+    {
+        found_count += fs::exists(MakeCIKDirName(local_form_directory, CIK, layout) / form_file_name) ? 1 : 0;
+    }
+    const std::chrono::duration<double, std::micro> lookup_time = std::chrono::steady_clock::now() - lookup_start;
+    if (found_count != sample.size())
+    {
+        spdlog::error(catenate("L: Only found ", found_count, " of ", sample.size(), " sample files."));
+    }
+    return lookup_time.count() / static_cast<double>(sample.size());
+}
+
+} // namespace
+
+FormDirectoryLayout FormDirectoryLayoutFromString(COL::sview layout_name)
+{
+    if (layout_name == "flat")
+    {
+        return FormDirectoryLayout::e_flat;
+    }
+    if (layout_name == "sharded")
+    {
+        return FormDirectoryLayout::e_sharded;
+    }
+    throw std::invalid_argument(catenate("Form directory layout must be 'flat' or 'sharded' ==> ", layout_name));
+}
+
+std::string FormDirectoryLayoutToString(FormDirectoryLayout layout)
+{
+    return layout == FormDirectoryLayout::e_sharded ? "sharded" : "flat";
+}
+
+std::optional<FormDirectoryLayout> ReadFormDirectoryLayout(const fs::path &local_form_directory)
+{
+    std::ifstream layout_file{local_form_directory / k_layout_file_name};
+    if (!layout_file.is_open())
+    {
+        return {};
+    }
+    std::string layout_name;
+    layout_file >> layout_name;
+    return FormDirectoryLayoutFromString(layout_name);
+}
+
+void WriteFormDirectoryLayout(const fs::path &local_form_directory, FormDirectoryLayout layout)
+{
+    const auto layout_file_name = local_form_directory / k_layout_file_name;
+    const auto temp_file_name = MakeTempFileName(layout_file_name);
+    {
+        std::ofstream layout_file{temp_file_name, std::ios::out | std::ios::trunc};
+        layout_file << FormDirectoryLayoutToString(layout) << '\n';
+        layout_file.close();
+        if (layout_file.fail())
+        {
+            throw std::runtime_error(catenate("Unable to write form directory layout: ", temp_file_name.string()));
+        }
+    }
+    fs::rename(temp_file_name, layout_file_name);
+}
+
+fs::path MakeCIKDirName(const fs::path &local_form_directory, COL::sview CIK_directory, FormDirectoryLayout layout)
+{
+    const auto padded_CIK = PadCIK(CIK_directory);
+
+    auto CIK_dir_name{local_form_directory};
+    if (layout == FormDirectoryLayout::e_sharded)
+    {
+        // this has to give the same answer everywhere, forever, so no std::hash.
+
+        const auto hash = FNV1a32(padded_CIK);
+        CIK_dir_name /= std::format("{:02x}", (hash >> 8) & 0xFF);
+        CIK_dir_name /= std::format("{:02x}", hash & 0xFF);
+    }
+    CIK_dir_name /= padded_CIK;
+    return CIK_dir_name;
+}
+
+void ForEachCIKDirectory(const fs::path &local_form_directory,
+                         FormDirectoryLayout layout,
+                         const std::function<void(const fs::path &)> &handle_CIK_directory)
+{
+    if (layout == FormDirectoryLayout::e_flat)
+    {
+        ForEachSubdirectory(local_form_directory, IsCIKDirectoryName, handle_CIK_directory);
+        return;
+    }
+    ForEachSubdirectory(local_form_directory, IsShardDirectoryName, [&](const fs::path &shard_directory) {
+        ForEachSubdirectory(shard_directory, IsShardDirectoryName, [&](const fs::path &shard_subdirectory) {
+            ForEachSubdirectory(shard_subdirectory, IsCIKDirectoryName, handle_CIK_directory);
+        });
+    });
+}
+
+std::size_t MigrateFormDirectory(const fs::path &local_form_directory,
+                                 FormDirectoryLayout from_layout,
+                                 FormDirectoryLayout to_layout)
+{
+    // a directory listing of the old layout is what we want to get away
+    // from so time it too.
+
+    const auto list_start = std::chrono::steady_clock::now();
+    std::vector<fs::path> CIK_directories;
+    ForEachCIKDirectory(local_form_directory, from_layout,
+                        [&CIK_directories](const fs::path &CIK_directory)
+                        { CIK_directories.push_back(CIK_directory); });
+    const std::chrono::duration<double> list_time = std::chrono::steady_clock::now() - list_start;
+
+    const auto lookup_sample = PickLookupSample(CIK_directories);
+    const auto lookup_time_before = MeasureLookups(local_form_directory, from_layout, lookup_sample);
+
+    const auto migrate_start = std::chrono::steady_clock::now();
+
+    std::set<std::string> made_directories;
+    std::size_t moved_count = 0;
+    for (const auto &CIK_directory : CIK_directories)
+    {
+        const auto new_CIK_directory =
+            MakeCIKDirName(local_form_directory, CIK_directory.filename().string(), to_layout);
+        if (new_CIK_directory == CIK_directory)
+        {
+            continue;
+        }
+        if (made_directories.insert(new_CIK_directory.parent_path().string()).second)
+        {
+            fs::create_directories(new_CIK_directory.parent_path());
+        }
+        if (fs::exists(new_CIK_directory))
+        {
+            MergeDirectory(CIK_directory, new_CIK_directory);
+        }
+        else
+        {
+            fs::rename(CIK_directory, new_CIK_directory);
+        }
+        ++moved_count;
+
+        // shard directories we have emptied out go.  These fail quietly if
+        // there is anything left.
+
+        if (from_layout == FormDirectoryLayout::e_sharded)
+        {
+            std::error_code ec;
+            fs::remove(CIK_directory.parent_path(), ec);
+            fs::remove(CIK_directory.parent_path().parent_path(), ec);
+        }
+    }
+    WriteFormDirectoryLayout(local_form_directory, to_layout);
+
+    const std::chrono::duration<double> migrate_time = std::chrono::steady_clock::now() - migrate_start;
+
+    const auto relist_start = std::chrono::steady_clock::now();
+    std::size_t CIK_directory_count = 0;
+    ForEachCIKDirectory(local_form_directory, to_layout,
+                        [&CIK_directory_count](const fs::path &) { ++CIK_directory_count; });
+    const std::chrono::duration<double> relist_time = std::chrono::steady_clock::now() - relist_start;
+
+    const auto lookup_time_after = MeasureLookups(local_form_directory, to_layout, lookup_sample);
+
+    spdlog::info(std::format("L: Moved {} of {} CIK directories in: {} from '{}' to '{}' layout in {:.3f} seconds.",
+                             moved_count, CIK_directories.size(), local_form_directory.string(),
+                             FormDirectoryLayoutToString(from_layout), FormDirectoryLayoutToString(to_layout),
+                             migrate_time.count()));
+    spdlog::info(std::format("L: Listing all CIK directories took {:.3f} seconds before and {:.3f} seconds after "
+                             "({} found). Looking up {} sample files took {:.1f} us each before and {:.1f} us after.",
+                             list_time.count(), relist_time.count(), CIK_directory_count, lookup_sample.size(),
+                             lookup_time_before, lookup_time_after));
+
+    return moved_count;
+}
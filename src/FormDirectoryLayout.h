@@ -0,0 +1,88 @@
+// =====================================================================================
+//
+//       Filename:  FormDirectoryLayout.h
+//
+//    Description:  Where the <CIK> directories go in the form directory
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:58:40 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef FORMDIRECTORYLAYOUT_H_
+#define FORMDIRECTORYLAYOUT_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include "Collector_Utils.h"
+
+namespace fs = std::filesystem;
+
+// flat:     <form directory>/<CIK>/<form name>/<file>
+// sharded:  <form directory>/ab/cd/<CIK>/<form name>/<file>
+//
+// The flat layout puts every CIK we have ever downloaded for in one
+// directory.  That is hundreds of thousands of entries and lookups and
+// listings of it get slow.  The sharded layout spreads the CIK directories
+// over 65536 directories, two levels deep, using a hash of the CIK.
+//
+// The layout used for a form directory is kept in a '.layout' file in it.
+// No file means flat.
+
+enum class FormDirectoryLayout
+{
+    e_flat,
+    e_sharded
+};
+
+FormDirectoryLayout FormDirectoryLayoutFromString(COL::sview layout_name);
+std::string FormDirectoryLayoutToString(FormDirectoryLayout layout);
+
+std::optional<FormDirectoryLayout> ReadFormDirectoryLayout(const fs::path &local_form_directory);
+void WriteFormDirectoryLayout(const fs::path &local_form_directory, FormDirectoryLayout layout);
+
+// CIK_directory is the CIK as it appears in EDGAR file names.  The result
+// uses the CIK padded to 10 digits.
+
+fs::path MakeCIKDirName(const fs::path &local_form_directory, COL::sview CIK_directory, FormDirectoryLayout layout);
+
+// calls handle_CIK_directory with each <CIK> directory in the form directory.
+
+void ForEachCIKDirectory(const fs::path &local_form_directory,
+                         FormDirectoryLayout layout,
+                         const std::function<void(const fs::path &)> &handle_CIK_directory);
+
+// moves each <CIK> directory from where from_layout has it to where
+// to_layout wants it and records the new layout.  Returns how many
+// directories were moved.  Form files are never copied, only renamed.
+
+std::size_t MigrateFormDirectory(const fs::path &local_form_directory,
+                                 FormDirectoryLayout from_layout,
+                                 FormDirectoryLayout to_layout);
+
+#endif /* FORMDIRECTORYLAYOUT_H_ */
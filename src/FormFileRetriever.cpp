@@ -31,22 +31,39 @@
 /* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <ranges>
 #include <set>
+#include <thread>
+#include <unordered_map>
 
 #include <spdlog/spdlog.h>
 
+#include "BinaryIndexFile.h"
+#include "CIKFilter.h"
 #include "Collector_Utils.h"
+#include "CompressedFormFiles.h"
+#include "ContentStore.h"
+#include "DownloadManifest.h"
 #include "FormFileRetriever.h"
+#include "FormTypeMatcher.h"
+#include "GroupCommit.h"
 #include "HTTPS_Downloader.h"
-
-// use these values to index into our index record fields.
-
-constexpr size_t K_CIK_FLD = 0;
-constexpr size_t K_FORM_FLD = 2;
-constexpr size_t K_FILE_FLD = 4;
+#include "IndexRecordScanner.h"
+#include "IndexStreamFilter.h"
+#include "MemoryMappedFile.h"
+#include "QueryResultCache.h"
+#include "SegmentStore.h"
 
 // define our own 'transform_if' for now.
 // don't use the one from boost because it pulls in a
@@ -67,6 +84,32 @@ OutputIterator transform_if(InputIterator first, InputIterator last, OutputItera
     return result;
 }
 
+// wait for all our scan tasks to finish.  If any of them has a problem, we
+// let the others finish before passing the first problem along.
+
+static void WaitForAllTasks(std::vector<std::future<void>> &tasks)
+{
+    std::exception_ptr ep = nullptr;
+    for (auto &task : tasks)
+    {
+        try
+        {
+            task.get();
+        }
+        catch (...)
+        {
+            if (!ep)
+            {
+                ep = std::current_exception();
+            }
+        }
+    }
+    if (ep)
+    {
+        std::rethrow_exception(ep);
+    }
+}
+
 //--------------------------------------------------------------------------------------
 //       Class:  FormFileRetriever
 //      Method:  FormFileRetriever
@@ -79,94 +122,475 @@ FormFileRetriever::FormFileRetriever(const std::string &host, const std::string
 } // -----  end of method FormFileRetriever::FormFileRetriever  (constructor)
   // -----
 
-bool FormFileRetriever::CIK_is_in_CIKList(const std::vector<std::string_view> &cik_list,
-                                          std::string_view cik_from_index_file)
+void FormFileRetriever::FilterOnDateFiled(std::chrono::year_month_day begin_date, std::chrono::year_month_day end_date)
+{
+    first_date_filed_ = std::chrono::sys_days{begin_date};
+    last_date_filed_ = std::chrono::sys_days{end_date};
+} // -----  end of method FormFileRetriever::FilterOnDateFiled  -----
+
+bool FormFileRetriever::HaveLocalFile(const fs::path &local_file_name) const
+{
+    const auto have_file = [this](const fs::path &file_name)
+    { return download_manifest_ != nullptr ? download_manifest_->HasFile(file_name) : fs::exists(file_name); };
+
+    return have_file(local_file_name) ||
+           (form_file_compressor_ != nullptr && have_file(MakeCompressedFileName(local_file_name)));
+} // -----  end of method FormFileRetriever::HaveLocalFile  -----
+
+fs::path FormFileRetriever::MakeDownloadFileName(const fs::path &local_file_name) const
 {
-    if (cik_list.empty())
+    return content_store_ != nullptr || group_commit_ != nullptr ? ContentStore::MakeDownloadFileName(local_file_name)
+                                                                 : local_file_name;
+} // -----  end of method FormFileRetriever::MakeDownloadFileName  -----
+
+void FormFileRetriever::FinishDownload(const fs::path &download_file_name,
+                                       const std::string &content_hash,
+                                       std::optional<RunJournal::Item> journal_item)
+{
+    auto local_file_name = download_file_name;
+    if (content_store_ != nullptr || group_commit_ != nullptr)
     {
-        return true; //	no filter so pass everything
+        local_file_name.replace_extension();
     }
 
-    return std::ranges::find(cik_list, cik_from_index_file) != cik_list.end();
-};
+    // the compressor and group commit finish up after we are gone so they
+    // get the manifest and journal, not us.  A filing isn't done in the
+    // journal until its file is where it belongs.
 
-fs::path FormFileRetriever::ExtractFileName(std::string_view index_file_name)
-{
+    const auto record_file =
+        [download_manifest = download_manifest_, run_journal = run_journal_, journal_item](const fs::path &file_name)
     {
-        index_file_name.remove_suffix(index_file_name.size() - index_file_name.find_last_not_of(" \r\t") - 1);
-        fs::path f_path{"/Archives"};
-        f_path /= index_file_name;
-        return f_path;
+        if (download_manifest != nullptr)
+        {
+            download_manifest->RecordFile(file_name);
+        }
+        if (run_journal != nullptr && journal_item)
+        {
+            run_journal->RecordItem(*journal_item, RunJournal::ItemState::e_completed);
+        }
     };
-}
 
-FormFileRetriever::FormsAndFilesList FormFileRetriever::FindFilesForForms(
-    const std::vector<std::string> &the_form_types,
-    const fs::path &local_index_file_name,
-    const TickerConverter::TickerCIKMap &ticker_map)
+    // where the file is now.  With group commit, everything is done under
+    // the download name and the result committed.
+
+    auto file_name = download_file_name;
+    if (content_store_ != nullptr)
+    {
+        if (group_commit_ == nullptr)
+        {
+            file_name = local_file_name;
+        }
+        content_store_->AddFile(download_file_name, content_hash, file_name);
+    }
+
+    // the compressed file is recorded once it has been made.
+
+    if (form_file_compressor_ != nullptr)
+    {
+        form_file_compressor_->CompressFile(file_name, record_file);
+        return;
+    }
+    if (group_commit_ != nullptr)
+    {
+        group_commit_->Commit(file_name, local_file_name,
+                              [record_file, local_file_name]() { record_file(local_file_name); });
+        return;
+    }
+    record_file(local_file_name);
+} // -----  end of method FormFileRetriever::FinishDownload  -----
+
+std::optional<RunJournal::Item> FormFileRetriever::FindJournalItem(const FilingPlan &filing_plan,
+                                                                   const FilingPlan::Filing &filing) const
 {
+    // the journal numbers filings by where they are in its copy of the plan.
 
-    // The master.idx file is in order by CIK.
-    // CIK is the first field in each data line.
-    // Data lines are delimited by '|' characters.
+    if (run_journal_ == nullptr || !journal_plan_ || &filing_plan != &run_journal_->GetPlan(*journal_plan_))
+    {
+        return {};
+    }
+    return RunJournal::Item{*journal_plan_, static_cast<std::uint32_t>(&filing - filing_plan.GetFilings().data())};
+} // -----  end of method FormFileRetriever::FindJournalItem  -----
 
-    spdlog::debug(catenate("F: Searching index file: ", local_index_file_name.string()));
+void FormFileRetriever::MakeFormDirectories(const FilingPlan &filing_plan,
+                                            const fs::path &local_form_directory,
+                                            int max_threads)
+{
+    const auto make_start = std::chrono::steady_clock::now();
 
-    // we load our file into memory so we have more flexibility in how we search
-    // it.
+    // find the distinct <CIK>/<form type> pairs without making a path for
+    // each filing.  The CIK directory is the last directory in the file name.
 
-    const std::string index_file_data = LoadDataFileForUse(local_index_file_name);
+    // forms kept in the segment store don't get directories.
 
-    // split into lines
-    // if there is a '\r' at the end of a line, it will be stripped out later.
+    std::vector<bool> form_in_segments(filing_plan.GetFormTypes().size(), false);
+    if (segment_store_ != nullptr)
+    {
+        for (std::size_t form_ID = 0; form_ID < form_in_segments.size(); ++form_ID)
+        {
+            form_in_segments[form_ID] = segment_store_->WantsFormType(filing_plan.GetFormTypes()[form_ID]);
+        }
+    }
 
-    auto index_data_lines = split_string<std::string_view>(index_file_data, "\n");
+    std::set<std::pair<std::uint16_t, COL::sview>> CIK_form_pairs;
+    for (const auto &filing : filing_plan.GetFilings())
+    {
+        if (form_in_segments[filing.form_ID])
+        {
+            continue;
+        }
+        const auto file_name = filing_plan.GetFileName(filing);
+        const auto last_slash = file_name.rfind('/');
+        auto CIK_directory = last_slash == COL::sview::npos ? COL::sview{} : file_name.substr(0, last_slash);
+        if (const auto slash = CIK_directory.rfind('/'); slash != COL::sview::npos)
+        {
+            CIK_directory.remove_prefix(slash + 1);
+        }
+        CIK_form_pairs.emplace(filing.form_ID, CIK_directory);
+    }
 
-    spdlog::debug(
-        catenate("F: Index file: ", local_index_file_name.string(), "has: ", index_data_lines.size(), " lines."));
+    std::vector<fs::path> directories;
+    for (const auto &[form_ID, CIK_directory] : CIK_form_pairs)
+    {
+        std::string form_name{filing_plan.GetFormTypes()[form_ID]};
+        std::replace(form_name.begin(), form_name.end(), '/', '_');
 
-    std::vector<std::string> forms_list{the_form_types};
-    std::sort(forms_list.begin(), forms_list.end());
+        auto directory_name = MakeLocalDirName(local_form_directory, CIK_directory, form_name, form_directory_layout_);
+        if (!made_directories_.contains(directory_name.string()))
+        {
+            directories.push_back(std::move(directory_name));
+        }
+    }
+    if (directories.empty())
+    {
+        return;
+    }
 
-    //	just in case there are duplicates in the forms list
+    // keep directories for the same CIK next to each other so threads mostly
+    // don't try to make the same parent at the same time.
 
-    forms_list.erase(std::unique(forms_list.begin(), forms_list.end()), forms_list.end());
+    std::ranges::sort(directories);
 
-    // We may have been given a list of symbols to filter against.  If so,
-    // we need to translate the symbol to its CIK.  We have a table with this
-    // mapping.
+    const auto threads_to_use =
+        std::clamp<std::size_t>(max_threads > 0 ? max_threads : 1, 1, directories.size());
+    const auto directories_per_thread = (directories.size() + threads_to_use - 1) / threads_to_use;
 
-    // CIKs can have leading zeroes in the table but the leading zeroes are not
-    // in the CIK field in the index file.
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(threads_to_use);
+    for (std::size_t first = 0; first < directories.size(); first += directories_per_thread)
+    {
+        const auto last = std::min(first + directories_per_thread, directories.size());
+        tasks.emplace_back(std::async(std::launch::async, [&directories, first, last]() {
+            for (auto i = first; i < last; ++i)
+            {
+                fs::create_directories(directories[i]);
+            }
+        }));
+    }
+    WaitForAllTasks(tasks);
+
+    for (const auto &directory_name : directories)
+    {
+        made_directories_.insert(directory_name.string());
+    }
+
+    const std::chrono::duration<double> make_time = std::chrono::steady_clock::now() - make_start;
+    spdlog::debug(std::format("F: Made {} form directories for {} filings using {} threads in {:.3f} seconds.",
+                              directories.size(), filing_plan.GetFilingCount(), tasks.size(), make_time.count()));
+} // -----  end of method FormFileRetriever::MakeFormDirectories  -----
+
+void FormFileRetriever::MakeDirectory(const fs::path &directory_name)
+{
+    if (made_directories_.contains(directory_name.string()))
+    {
+        return;
+    }
+    fs::create_directories(directory_name);
+    made_directories_.insert(directory_name.string());
+} // -----  end of method FormFileRetriever::MakeDirectory  -----
 
-    std::vector<COL::sview> cik_list;
-    if (!ticker_map.empty())
+std::pair<FilingPlan, std::size_t> FormFileRetriever::FilterIndexRecords(
+    COL::sview index_records, const FormTypeMatcher &form_matcher, const CIKFilter &cik_filter,
+    std::size_t form_type_width)
+{
+    // the scanner hands us views into the mapped file and the form matcher
+    // works directly on those views so there is no allocation per line here.
+    // The rows we keep are packed into the plan.
+
+    FilingPlan results;
+
+    IndexRecordScanner scanner =
+        form_type_width > 0 ? IndexRecordScanner{index_records, form_type_width} : IndexRecordScanner{index_records};
+    IndexRecord record;
+
+    while (scanner.NextRecord(record))
     {
-        std::transform(std::begin(ticker_map), std::end(ticker_map), std::back_inserter(cik_list),
-                       [](const auto &elem) {
-                           COL::sview x{elem.second};
-                           x.remove_prefix(x.find_first_not_of('0'));
-                           return x;
-                       });
+        const auto which_form = form_matcher.Match(record.form_type);
+
+        if (!which_form || !cik_filter.Contains(record.CIK))
+        {
+            continue;
+        }
+
+        // an unusable date only gets through if we are not filtering on date.
+
+        const auto date_filed = ParseIndexDate(record.date_filed);
+        if (first_date_filed_ && !(date_filed && DateFiledIsWanted(*date_filed)))
+        {
+            continue;
+        }
+        results.AddFiling(*which_form, ParseCIK(record.CIK).value_or(0), date_filed.value_or(std::chrono::sys_days{}),
+                          record.file_name);
     }
-    // for (int i = 0; i < 5; ++i) {
-    //   std::cout << cik_list[i] << '\n';
-    // };
+    return {std::move(results), scanner.GetRecordCount()};
+} // -----  end of method FormFileRetriever::FilterIndexRecords  -----
+
+std::pair<FilingPlan, std::size_t> FormFileRetriever::FilterBinaryIndexRecords(
+    const BinaryIndexFile &binary_index, std::span<const BinaryIndexFile::RowRange> row_ranges,
+    const FormTypeMatcher &form_matcher, const CIKFilter &cik_filter)
+{
+    // each file has its own form type table so match those once up front.
+    // After that, each row is just a table lookup and a CIK test.
+
+    // We keep the plan's form ID for each form type we want.
 
-    std::sort(std::begin(cik_list), std::end(cik_list));
+    FilingPlan results;
 
-    auto itor{std::begin(index_data_lines)};
-    auto itor_end{std::end(index_data_lines)};
+    std::vector<std::optional<std::uint16_t>> form_matches;
+    form_matches.reserve(binary_index.GetFormTypes().size());
+    for (const auto &form_type : binary_index.GetFormTypes())
+    {
+        const auto which_form = form_matcher.Match(form_type);
+        form_matches.push_back(which_form ? std::optional{results.InternFormType(*which_form)} : std::nullopt);
+    }
+
+    const auto CIKs = binary_index.GetCIKs();
+    const auto form_IDs = binary_index.GetFormIDs();
+
+    std::size_t row_count{0};
+    for (const auto &[first_row, last_row] : row_ranges)
+    {
+        for (std::size_t row = first_row; row < last_row; ++row)
+        {
+            const auto &which_form = form_matches[form_IDs[row]];
+
+            if (which_form && cik_filter.Contains(CIKs[row]) && DateFiledIsWanted(binary_index.GetDateFiled(row)))
+            {
+                results.AddFiling(*which_form, CIKs[row], binary_index.GetDateFiled(row),
+                                  binary_index.GetFileName(row));
+            }
+        }
+        row_count += last_row - first_row;
+    }
+    return {std::move(results), row_count};
+} // -----  end of method FormFileRetriever::FilterBinaryIndexRecords  -----
+
+std::vector<std::pair<FilingPlan, std::size_t>> FormFileRetriever::ScanBinaryIndexFile(
+    const BinaryIndexFile &binary_index, const FormTypeMatcher &form_matcher, const CIKFilter &cik_filter,
+    int max_threads)
+{
+    // same plan as for text index files: binary search the sorted column when
+    // we only want a little of the file, otherwise split the rows up and
+    // filter the pieces concurrently.
+
+    std::optional<std::vector<BinaryIndexFile::RowRange>> row_ranges;
+    const bool search_form_types = binary_index.IsSortedByFormType() && !form_matcher.MatchesEverything();
+
+    if (search_form_types)
+    {
+        std::vector<std::uint16_t> wanted_form_IDs;
+        for (std::size_t form_ID = 0; form_ID < binary_index.GetFormTypes().size(); ++form_ID)
+        {
+            if (form_matcher.Match(binary_index.GetFormTypes()[form_ID]))
+            {
+                wanted_form_IDs.push_back(static_cast<std::uint16_t>(form_ID));
+            }
+        }
+        row_ranges = binary_index.FindFormTypeRows(wanted_form_IDs);
+    }
+    else if (binary_index.IsSortedByCIK() && cik_filter.IsActive())
+    {
+        row_ranges = binary_index.FindCIKRows(cik_filter.GetCIKs());
+    }
+
+    if (row_ranges)
+    {
+        spdlog::debug(std::format("F: Binary index file has {} rows. Found {} {} ranges.", binary_index.GetRowCount(),
+                                  row_ranges->size(), search_form_types ? "form type" : "CIK"));
+
+        std::vector<std::pair<FilingPlan, std::size_t>> chunk_results;
+        chunk_results.push_back(FilterBinaryIndexRecords(binary_index, *row_ranges, form_matcher, cik_filter));
+        return chunk_results;
+    }
+
+    const auto chunk_count = std::min<std::size_t>(
+        std::max<std::size_t>(1, binary_index.GetRowCount() / k_min_binary_scan_chunk_rows),
+        std::max<int>(1, max_threads > 0 ? max_threads : static_cast<int>(std::thread::hardware_concurrency())));
+
+    std::vector<BinaryIndexFile::RowRange> chunks;
+    chunks.reserve(chunk_count);
+    for (std::size_t i = 0; i < chunk_count; ++i)
+    {
+        chunks.emplace_back(binary_index.GetRowCount() * i / chunk_count,
+                            binary_index.GetRowCount() * (i + 1) / chunk_count);
+    }
+
+    std::vector<std::pair<FilingPlan, std::size_t>> chunk_results(chunks.size());
+
+    if (chunks.size() == 1)
+    {
+        chunk_results[0] = FilterBinaryIndexRecords(binary_index, chunks, form_matcher, cik_filter);
+    }
+    else
+    {
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(chunks.size());
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            tasks.emplace_back(std::async(std::launch::async, [&, i, this]() {
+                chunk_results[i] =
+                    FilterBinaryIndexRecords(binary_index, std::span{chunks}.subspan(i, 1), form_matcher, cik_filter);
+            }));
+        }
+        WaitForAllTasks(tasks);
+    }
+    return chunk_results;
+} // -----  end of method FormFileRetriever::ScanBinaryIndexFile  -----
+
+std::vector<std::pair<FilingPlan, std::size_t>> FormFileRetriever::ScanTextIndexFile(
+    const fs::path &local_index_file_name, const FormTypeMatcher &form_matcher, const CIKFilter &cik_filter,
+    int max_threads)
+{
+    // we map our file into memory so we have more flexibility in how we search
+    // it and so we can parse it in place without copying it.
+    // We may only need a few pieces of the file so don't have the kernel read
+    // all of it in until we know we are going to scan it all.
+
+    const MemoryMappedFile index_file{local_index_file_name, MemoryMappedFile::AccessPattern::random};
+    const COL::sview index_file_data = index_file.GetView();
 
     //	let's skip over the header lines in the file
 
-    auto form_itor = std::find_if(itor, itor_end, [](const auto &line) { return line.starts_with("----------"); });
+    const auto data_start = FindIndexDataStart(index_file_data);
 
     BOOST_ASSERT_MSG(
-        form_itor != itor_end,
+        data_start != COL::sview::npos,
         catenate("Unable to find start of index entries in file: ", local_index_file_name.string()).c_str());
 
-    // point to first data line.
+    const std::size_t form_type_width = FindFormTypeColumnWidth(index_file_data, data_start).value_or(0);
+
+    const COL::sview index_records = index_file_data.substr(data_start);
+
+    // since index files are sorted, we can binary search for the lines we
+    // want and leave the rest of the file alone:
+    // - form index files when we are not looking for every form type.
+    // - master index files when we only want some CIKs.
+
+    std::optional<std::vector<COL::sview>> index_ranges;
+
+    if (form_type_width > 0 && !form_matcher.MatchesEverything())
+    {
+        index_ranges = FindFormTypeRanges(index_records, form_type_width, form_matcher.GetExactForms(),
+                                          form_matcher.GetPrefixPatterns());
+    }
+    else if (form_type_width == 0 && cik_filter.IsActive())
+    {
+        index_ranges = FindCIKRanges(index_records, cik_filter.GetCIKs());
+    }
+
+    std::vector<COL::sview> chunks;
+    bool scan_concurrently{true};
+
+    if (index_ranges)
+    {
+        chunks = std::move(*index_ranges);
+        scan_concurrently = false;
+
+        const auto bytes_to_scan = std::accumulate(chunks.begin(), chunks.end(), std::size_t{0},
+                                                   [](auto sum, auto chunk) { return sum + chunk.size(); });
+        spdlog::debug(std::format("F: Index file: {}. Found {} {} ranges. Scanning {} of {} bytes.",
+                                  local_index_file_name, chunks.size(), form_type_width > 0 ? "form type" : "CIK",
+                                  bytes_to_scan, index_records.size()));
+    }
+    else
+    {
+        index_file.Advise(MemoryMappedFile::AccessPattern::sequential);
+    }
+
+    // otherwise, big files (a quarterly index has over a million rows) are
+    // split into chunks at line boundaries and each chunk is filtered on its
+    // own thread.  The chunk results are concatenated in order so we end up
+    // with the same thing a straight front to back scan would give us.
+
+    if (scan_concurrently)
+    {
+        const auto chunk_count = std::min<std::size_t>(
+            std::max<std::size_t>(1, index_records.size() / k_min_scan_chunk_size),
+            std::max<int>(1, max_threads > 0 ? max_threads : static_cast<int>(std::thread::hardware_concurrency())));
+
+        chunks = SplitAtLineBoundaries(index_records, chunk_count);
+    }
+
+    std::vector<std::pair<FilingPlan, std::size_t>> chunk_results(chunks.size());
+
+    if (!scan_concurrently || chunks.size() == 1)
+    {
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            chunk_results[i] = FilterIndexRecords(chunks[i], form_matcher, cik_filter, form_type_width);
+        }
+    }
+    else
+    {
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(chunks.size());
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            tasks.emplace_back(std::async(std::launch::async, [&, i, this]() {
+                chunk_results[i] = FilterIndexRecords(chunks[i], form_matcher, cik_filter, form_type_width);
+            }));
+        }
+        WaitForAllTasks(tasks);
+    }
+    return chunk_results;
+} // -----  end of method FormFileRetriever::ScanTextIndexFile  -----
+
+FilingPlan FormFileRetriever::FindFilesForForms(
+    const std::vector<std::string> &the_form_types,
+    const fs::path &local_index_file_name,
+    const TickerConverter::TickerCIKMap &ticker_map,
+    int max_threads)
+{
+
+    // The master.idx file is in order by CIK.
+    // CIK is the first field in each data line.
+    // Data lines are delimited by '|' characters.
+
+    // The form.idx file has the same data in order by form type.
+    // Form type is the first field in each data line.
+    // Data lines are fixed width.
+
+    spdlog::debug(catenate("F: Searching index file: ", local_index_file_name.string()));
+
+    // the matcher takes care of any duplicates in the forms list.
+    // form types ending in '*' match any form type starting with the given text.
+
+    const FormTypeMatcher form_matcher{the_form_types};
+
+    // We may have been given a list of symbols to filter against.  If so,
+    // we need to translate the symbol to its CIK.  We have a table with this
+    // mapping.
+
+    // CIKs can have leading zeroes in the table but the leading zeroes are not
+    // in the CIK field in the index file.  The filter works with the CIKs as
+    // numbers so that doesn't matter.
+
+    const CIKFilter cik_filter{ticker_map};
+
+    if (cik_filter.IsActive())
+    {
+        spdlog::debug(catenate("F: Filtering on ", cik_filter.GetCIKs().size(), " CIKs using ",
+                               cik_filter.UsesBitmap() ? "bitmap." : "binary search."));
+    }
 
     // for each data line in the index file,
     // - extract the form name
@@ -176,100 +600,492 @@ FormFileRetriever::FormsAndFilesList FormFileRetriever::FindFilesForForms(
     // -- if so
     // --- add the filename to the list for that form.
 
-    // point to the first data record in the master index file
-    //
-    ++form_itor;
+    const auto scan_start = std::chrono::steady_clock::now();
 
-    FormsAndFilesList results;
-    for (const auto &the_form : forms_list)
+    // old index files don't change so if we have searched this one with this
+    // filter before, we already have the answer.
+
+    std::optional<QueryResultCache> result_cache;
+    if (use_query_result_cache_)
     {
-        results[the_form] = std::vector<fs::path>{};
+        try
+        {
+            result_cache.emplace(local_index_file_name, form_matcher, cik_filter, first_date_filed_,
+                                 last_date_filed_);
+            if (auto saved_results = result_cache->Load(); saved_results)
+            {
+                const std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - scan_start;
+                spdlog::debug(std::format("F: Using saved results for index file: {} from: {} in {:.3f} seconds.",
+                                          local_index_file_name, result_cache->GetCacheFileName(),
+                                          load_time.count()));
+                return std::move(*saved_results);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::debug(catenate("F: Unable to use saved results for: ", local_index_file_name.string(), ". ",
+                                   e.what()));
+        }
     }
 
-    auto data_lines = std::ranges::subrange(form_itor, itor_end);
+    // the binary copy of an index file is much quicker to search than the text
+    // so we prefer it.  It is made the first time we see the text file.  It
+    // gets the same range searches and concurrent scanning as the text.  If we
+    // can't make it for some reason, just search the text.
 
-    for (const auto data_line : data_lines)
+    std::optional<BinaryIndexFile> binary_index;
+    if (use_binary_index_files_)
     {
-        const auto line_flds = split_string<std::string_view>(data_line, "|");
-        const auto frm = line_flds[K_FORM_FLD];
-        const std::string form{frm.begin(), frm.end()};
+        try
+        {
+            binary_index.emplace(BinaryIndexFile::OpenForTextIndexFile(local_index_file_name));
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::debug(catenate("F: Unable to use binary index for: ", local_index_file_name.string(), ". ",
+                                   e.what(), " Searching text index file."));
+        }
+    }
 
-        if (std::ranges::find(forms_list, form) != forms_list.end() &&
-            CIK_is_in_CIKList(cik_list, line_flds[K_CIK_FLD]))
+    std::vector<std::pair<FilingPlan, std::size_t>> chunk_results;
+    if (binary_index)
+    {
+        chunk_results = ScanBinaryIndexFile(*binary_index, form_matcher, cik_filter, max_threads);
+    }
+    else
+    {
+        chunk_results = ScanTextIndexFile(local_index_file_name, form_matcher, cik_filter, max_threads);
+    }
+
+    // a single chunk is the usual case so don't copy it.
+
+    FilingPlan results;
+    std::size_t record_count{0};
+    for (auto &[chunk_filings, chunk_records] : chunk_results)
+    {
+        if (chunk_results.size() == 1)
         {
-            results[{form}].push_back(ExtractFileName(line_flds[K_FILE_FLD]));
+            results = std::move(chunk_filings);
         }
+        else
+        {
+            results.Append(chunk_filings);
+        }
+        record_count += chunk_records;
     }
+    results.SortByFormType();
+
+    const std::chrono::duration<double> scan_time = std::chrono::steady_clock::now() - scan_start;
+
+    spdlog::debug(std::format(
+        "F: {} index file: {} has: {} rows. Scanned {} chunks in {:.3f} seconds ({:.0f} rows/sec).",
+        binary_index ? "Binary" : "Text", local_index_file_name, record_count, chunk_results.size(), scan_time.count(),
+        scan_time.count() > 0 ? record_count / scan_time.count() : 0.0));
 
-    int grand_total{0};
-    for (const auto &[form, files] : results)
+    if (result_cache)
     {
-        grand_total += files.size();
+        try
+        {
+            result_cache->Save(results);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::debug(catenate("F: Unable to save results for: ", local_index_file_name.string(), ". ",
+                                   e.what()));
+        }
     }
 
-    spdlog::debug(catenate("F: Found a total of ", grand_total, " files for specified forms: ", forms_list));
+    spdlog::debug(catenate("F: Found a total of ", results.GetFilingCount(), " files for specified forms: ",
+                           the_form_types));
     return results;
 } // -----  end of method FormFileRetriever::FindFilesForForms  -----
 
-FormFileRetriever::FormsAndFilesList FormFileRetriever::FindFilesForForms(
+FilingPlan FormFileRetriever::FindFilesForForms(
     const std::vector<std::string> &the_form_types,
     const std::vector<fs::path> &local_index_files,
-    const TickerConverter::TickerCIKMap &ticker_map)
+    const TickerConverter::TickerCIKMap &ticker_map,
+    int max_threads)
 {
-    // separately process each file in our list and accumulate the results
+    // separately process each file in our list and accumulate the results.
+    // The files are independent of each other so we scan several at once.
+    // Each file gets its own result slot so we can merge them back together
+    // in file order no matter which scan finishes first.
 
-    FormsAndFilesList results;
+    const auto scan_start = std::chrono::steady_clock::now();
 
-    for (const auto &index_file : local_index_files)
-    {
-        decltype(auto) single_file_results = FindFilesForForms(the_form_types, index_file, ticker_map);
+    std::vector<FilingPlan> per_file_results(local_index_files.size());
 
-        for (const auto &[form, files] : single_file_results)
-        {
-            // if we already have found files for the given form type, add them to to
-            // the list otherwise, make a new entry.
-            // this code nicely works in either case.
+    const auto threads_to_use = static_cast<std::size_t>(
+        std::clamp<int>(max_threads > 0 ? max_threads : static_cast<int>(std::thread::hardware_concurrency()), 1,
+                        std::max<int>(1, static_cast<int>(local_index_files.size()))));
+
+    // if we have fewer files than threads, let each file scan use the spare
+    // threads to split itself up.
 
-            std::move(files.begin(), files.end(), std::back_inserter(results[form]));
+    const int threads_per_file = std::max<int>(
+        1, (max_threads > 0 ? max_threads : static_cast<int>(std::thread::hardware_concurrency())) /
+               static_cast<int>(threads_to_use));
+
+    std::atomic<std::size_t> next_file{0};
+
+    auto scan_files = [&, this]() {
+        for (auto i = next_file++; i < local_index_files.size(); i = next_file++)
+        {
+            per_file_results[i] =
+                FindFilesForForms(the_form_types, local_index_files[i], ticker_map, threads_per_file);
         }
+    };
+
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(threads_to_use);
+    for (std::size_t i = 0; i < threads_to_use; ++i)
+    {
+        tasks.emplace_back(std::async(std::launch::async, scan_files));
     }
+    WaitForAllTasks(tasks);
+
+    FilingPlan results;
 
-    int grand_total{0};
-    for (const auto &elem : results)
+    for (const auto &single_file_results : per_file_results)
     {
-        grand_total += elem.second.size();
+        results.Append(single_file_results);
     }
+    results.SortByFormType();
 
-    spdlog::info(catenate("F: Found a grand total of ", grand_total, " files for specified forms in ",
+    const std::chrono::duration<double> scan_time = std::chrono::steady_clock::now() - scan_start;
+
+    spdlog::info(std::format("F: Scanned {} index files using {} threads in {:.3f} seconds.", local_index_files.size(),
+                             threads_to_use, scan_time.count()));
+
+    spdlog::info(catenate("F: Found a grand total of ", results.GetFilingCount(), " files for specified forms in ",
                           local_index_files.size(), " files."));
 
+    const auto memory_used = results.GetMemoryUsed();
+    spdlog::info(std::format("F: Filing plan uses {} bytes ({:.1f} bytes per filing).", memory_used,
+                             results.IsEmpty() ? 0.0 : static_cast<double>(memory_used) / results.GetFilingCount()));
+
     return results;
 } // -----  end of method FormFileRetriever::FindFilesForForm  -----
 
-void FormFileRetriever::RetrieveSpecifiedFiles(const FormsAndFilesList &form_list, const fs::path &local_form_directory,
+void FormFileRetriever::RetrieveSpecifiedFiles(const FilingPlan &filing_plan, const fs::path &local_form_directory,
                                                bool replace_files)
 {
-    for (const auto &[form_type, form_files] : form_list)
+    MakeFormDirectories(filing_plan, local_form_directory, 1);
+
+    for (const auto &[form_type, filings] : filing_plan.GetFilingsByFormType())
     {
-        RetrieveSpecifiedFiles(form_files, form_type, local_form_directory, replace_files);
+        RetrieveSpecifiedFiles(filing_plan, filings, form_type, local_form_directory, replace_files);
     }
 }
 
-void FormFileRetriever::ConcurrentlyRetrieveSpecifiedFiles(const FormsAndFilesList &form_list,
+void FormFileRetriever::ConcurrentlyRetrieveSpecifiedFiles(const FilingPlan &filing_plan,
                                                            const fs::path &local_form_directory,
                                                            int max_at_a_time,
                                                            bool replace_files)
 {
-    for (const auto &[form_type, form_files] : form_list)
+    MakeFormDirectories(filing_plan, local_form_directory, max_at_a_time);
+
+    for (const auto &[form_type, filings] : filing_plan.GetFilingsByFormType())
     {
-        ConcurrentlyRetrieveSpecifiedFiles(form_files, form_type, local_form_directory, max_at_a_time, replace_files);
+        ConcurrentlyRetrieveSpecifiedFiles(filing_plan, filings, form_type, local_form_directory, max_at_a_time,
+                                           replace_files);
     }
 }
 
-void FormFileRetriever::RetrieveSpecifiedFiles(const std::vector<fs::path> &remote_file_names,
-                                               const std::string &form_type, const fs::path &local_form_directory,
+void FormFileRetriever::RetrieveFilesForPlan(const std::string &source,
+                                             const PlanMaker &make_plan,
+                                             const fs::path &local_form_directory,
+                                             int max_at_a_time,
+                                             bool replace_files)
+{
+    if (run_journal_ == nullptr)
+    {
+        ConcurrentlyRetrieveSpecifiedFiles(make_plan(), local_form_directory, max_at_a_time, replace_files);
+        return;
+    }
+
+    auto plan_number = run_journal_->FindPlan(source);
+    if (plan_number)
+    {
+        spdlog::info(catenate("F: Using filing plan for: ", source, " from run journal."));
+    }
+    else
+    {
+        plan_number = run_journal_->AddPlan(source, make_plan());
+    }
+    run_journal_->MarkDownloadsStarting();
+
+    // we download from the journal's copy of the plan so we can tell which
+    // of its filings each download is.
+
+    journal_plan_ = plan_number;
+    try
+    {
+        ConcurrentlyRetrieveSpecifiedFiles(run_journal_->GetPlan(*plan_number), local_form_directory, max_at_a_time,
+                                           replace_files);
+    }
+    catch (...)
+    {
+        journal_plan_.reset();
+        throw;
+    }
+    journal_plan_.reset();
+} // -----  end of method FormFileRetriever::RetrieveFilesForPlan  -----
+
+void FormFileRetriever::RetrieveFilesForFormsAsIndexFilesArrive(const std::vector<std::string> &the_form_types,
+                                                                const std::vector<fs::path> &remote_index_files,
+                                                                const IndexFileCopier &copy_index_file,
+                                                                const TickerConverter::TickerCIKMap &ticker_map,
+                                                                const fs::path &local_form_directory,
+                                                                int max_at_a_time,
+                                                                bool replace_files)
+{
+    // the index side gets and searches up to max_at_a_time index files at a
+    // time and produces a list of form files for each.  We consume them here
+    // in whatever order they are done.
+
+    std::mutex form_lists_mutex;
+    std::condition_variable form_lists_ready;
+    std::deque<std::pair<std::string, FilingPlan>> form_lists;
+    bool index_files_done = false;
+    std::atomic<bool> stop_index_files{false};
+    std::atomic<std::size_t> next_index_file{0};
+
+    auto find_form_files = [&]()
+    {
+        for (auto i = next_index_file++; i < remote_index_files.size() && !stop_index_files; i = next_index_file++)
+        {
+            // the run journal may already have the plan for this one.
+
+            auto source = remote_index_files[i].string();
+            FilingPlan form_list;
+            if (run_journal_ == nullptr || !run_journal_->FindPlan(source))
+            {
+                IndexStreamFilter index_filter{*this, the_form_types, ticker_map};
+                auto local_index_file =
+                    copy_index_file(remote_index_files[i],
+                                    [&index_filter](COL::sview index_data) { index_filter.AddData(index_data); });
+                form_list = index_filter.Finish(local_index_file);
+            }
+            {
+                std::lock_guard<std::mutex> lock{form_lists_mutex};
+                form_lists.emplace_back(std::move(source), std::move(form_list));
+            }
+            form_lists_ready.notify_one();
+        }
+    };
+
+    const auto index_threads = std::clamp<std::size_t>(max_at_a_time > 0 ? max_at_a_time : 1, 1,
+                                                       std::max<std::size_t>(remote_index_files.size(), 1));
+    std::atomic<std::size_t> index_threads_running{index_threads};
+
+    auto index_thread_finished = [&]()
+    {
+        if (--index_threads_running > 0)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock{form_lists_mutex};
+            index_files_done = true;
+        }
+        form_lists_ready.notify_one();
+    };
+
+    std::vector<std::future<void>> index_side;
+    index_side.reserve(index_threads);
+    for (std::size_t i = 0; i < index_threads; ++i)
+    {
+        index_side.emplace_back(std::async(std::launch::async,
+                                           [&]()
+                                           {
+                                               try
+                                               {
+                                                   find_form_files();
+                                               }
+                                               catch (...)
+                                               {
+                                                   stop_index_files = true;
+                                                   index_thread_finished();
+                                                   throw;
+                                               }
+                                               index_thread_finished();
+                                           }));
+    }
+
+    // the form side keeps one download queue going across all the index
+    // files.  When it has handed out the form files for one index file, it
+    // moves on to the next list, waiting for one if it has to.
+
+    std::optional<FilingPlan> form_list;
+    const FilingPlan *filing_plan = nullptr;
+    std::vector<std::uint32_t> files_to_download;
+    std::size_t next_file_to_download{0};
+
+    std::size_t index_files_processed{0};
+    std::size_t total_files_to_download{0};
+    std::size_t skipped_files_counter{0};
+
+    auto start_next_form_list = [&]()
+    {
+        std::string source;
+        {
+            std::unique_lock<std::mutex> lock{form_lists_mutex};
+            form_lists_ready.wait(lock, [&]() { return !form_lists.empty() || index_files_done; });
+            if (form_lists.empty())
+            {
+                return false;
+            }
+            source = std::move(form_lists.front().first);
+            form_list = std::move(form_lists.front().second);
+            form_lists.pop_front();
+        }
+        ++index_files_processed;
+
+        // with a run journal, we download from its copy of the plan so we can
+        // tell which of its filings each download is.
+
+        filing_plan = &*form_list;
+        if (run_journal_ != nullptr)
+        {
+            journal_plan_ = run_journal_->FindPlan(source);
+            if (journal_plan_)
+            {
+                spdlog::info(catenate("F: Using filing plan for: ", source, " from run journal."));
+            }
+            else
+            {
+                journal_plan_ = run_journal_->AddPlan(source, std::move(*form_list));
+            }
+            run_journal_->MarkDownloadsStarting();
+            filing_plan = &run_journal_->GetPlan(*journal_plan_);
+        }
+        MakeFormDirectories(*filing_plan, local_form_directory, max_at_a_time);
+
+        files_to_download.clear();
+        next_file_to_download = 0;
+        for (const auto &[form_type, filings] : filing_plan->GetFilingsByFormType())
+        {
+            if (segment_store_ != nullptr && segment_store_->WantsFormType(form_type))
+            {
+                RetrieveFilesToSegments(*filing_plan, filings, form_type, max_at_a_time, replace_files);
+                continue;
+            }
+
+            std::string form_name{form_type};
+            std::replace(form_name.begin(), form_name.end(), '/', '_');
+
+            const auto first_filing = static_cast<std::uint32_t>(filings.data() - filing_plan->GetFilings().data());
+            const auto form_files_to_download =
+                FindFilingsToDownload(*filing_plan, filings, form_name, local_form_directory, replace_files);
+            for (const auto i : form_files_to_download)
+            {
+                files_to_download.push_back(first_filing + i);
+            }
+            skipped_files_counter += filings.size() - form_files_to_download.size();
+        }
+        total_files_to_download += files_to_download.size();
+
+        std::cout << std::format("# files to download: {}\n", files_to_download.size());
+        return true;
+    };
+
+    // the downloader only gives us back the download file name so, with a
+    // run journal, keep track of which filing each download in progress is.
+    // All the callbacks are made from the downloader's thread.
+
+    std::unordered_map<std::string, RunJournal::Item> journal_items_in_progress;
+
+    auto next_file_names = [&]() -> std::optional<HTTPS_Downloader::copy_file_names>
+    {
+        while (next_file_to_download == files_to_download.size())
+        {
+            if (!start_next_form_list())
+            {
+                return {};
+            }
+        }
+        const auto &filing = filing_plan->GetFilings()[files_to_download[next_file_to_download++]];
+
+        std::string form_name{filing_plan->GetFormTypes()[filing.form_ID]};
+        std::replace(form_name.begin(), form_name.end(), '/', '_');
+
+        auto file_names = MakeFormFileNames(*filing_plan, filing, form_name, local_form_directory);
+        if (const auto journal_item = FindJournalItem(*filing_plan, filing); journal_item)
+        {
+            journal_items_in_progress.emplace(file_names.second.string(), *journal_item);
+        }
+        return file_names;
+    };
+    auto take_journal_item = [&journal_items_in_progress](const fs::path &download_file_name)
+    {
+        std::optional<RunJournal::Item> journal_item;
+        if (auto found = journal_items_in_progress.find(download_file_name.string());
+            found != journal_items_in_progress.end())
+        {
+            journal_item = found->second;
+            journal_items_in_progress.erase(found);
+        }
+        return journal_item;
+    };
+
+    HTTPS_Downloader the_server(host_, port_);
+    the_server.HashDownloads(content_store_ != nullptr);
+    the_server.UseFileWriter(file_writer_);
+
+    int success_counter = 0;
+    int error_counter = 0;
+    try
+    {
+        std::tie(success_counter, error_counter) = the_server.DownloadFilesConcurrently(
+            next_file_names, max_at_a_time,
+            [&](const fs::path &download_file_name, const std::string &content_hash)
+            { FinishDownload(download_file_name, content_hash, take_journal_item(download_file_name)); },
+            [&](const fs::path &download_file_name, const std::string & /* error */)
+            { RecordJournalItem(take_journal_item(download_file_name), RunJournal::ItemState::e_failed); });
+    }
+    catch (...)
+    {
+        // don't leave the index side running on its own.
+
+        journal_plan_.reset();
+        stop_index_files = true;
+        for (auto &index_thread : index_side)
+        {
+            index_thread.wait();
+        }
+        throw;
+    }
+    journal_plan_.reset();
+
+    // passes along any problem from the index side.
+
+    WaitForAllTasks(index_side);
+
+    spdlog::info(catenate("F: Retrieved form files for: ", index_files_processed, " index files. Downloaded: ",
+                          success_counter, ". Skipped: ", skipped_files_counter, ". Errors: ", error_counter, "."));
+
+    // TODO: figure our error handling when some files do not get downloaded.
+    // Let's try this for now.
+
+    if (success_counter != total_files_to_download)
+    {
+        throw std::runtime_error(
+            catenate("Download count = ", success_counter, ". Should be: ", total_files_to_download));
+    }
+} // -----  end of method FormFileRetriever::RetrieveFilesForFormsAsIndexFilesArrive  -----
+
+void FormFileRetriever::RetrieveSpecifiedFiles(const FilingPlan &filing_plan,
+                                               std::span<const FilingPlan::Filing> filings,
+                                               COL::sview form_type,
+                                               const fs::path &local_form_directory,
                                                bool replace_files)
 {
+    if (segment_store_ != nullptr && segment_store_->WantsFormType(form_type))
+    {
+        return RetrieveFilesToSegments(filing_plan, filings, form_type, 1, replace_files);
+    }
+
     // some forms can have slash in the form local_file_name so...
 
     std::string form_name{form_type};
@@ -279,22 +1095,43 @@ void FormFileRetriever::RetrieveSpecifiedFiles(const std::vector<fs::path> &remo
     int skipped_files_counter = 0;
     int error_counter = 0;
 
-    for (const auto &remote_file_name : remote_file_names)
+    for (const auto &filing : filings)
     {
+        const auto journal_item = FindJournalItem(filing_plan, filing);
+        if (JournalHasDone(journal_item))
+        {
+            ++skipped_files_counter;
+            continue;
+        }
+
+        const auto remote_file_name = filing_plan.GetRemoteFileName(filing);
+
         // we download the remote file to a local directory structure like this
         // <local_form_directory>/<CIK>/<form_type>/<remote_file_name>
 
-        auto local_dir_name = MakeLocalDirNameFromRemoteFileName(local_form_directory, remote_file_name, form_name);
+        auto local_dir_name = MakeLocalDirNameFromRemoteFileName(local_form_directory, remote_file_name, form_name,
+                                                                 form_directory_layout_);
         auto local_file_name{local_dir_name};
         local_file_name /= remote_file_name.filename();
 
-        if (replace_files || !fs::exists(local_file_name))
+        if (replace_files || !HaveLocalFile(local_file_name))
         {
             try
             {
-                fs::create_directories(local_dir_name);
+                MakeDirectory(local_dir_name);
                 HTTPS_Downloader the_server(host_, port_);
-                the_server.DownloadFile(remote_file_name, local_file_name);
+                const auto download_file_name = MakeDownloadFileName(local_file_name);
+                if (content_store_ != nullptr)
+                {
+                    FinishDownload(download_file_name,
+                                   the_server.DownloadFileAndHash(remote_file_name, download_file_name),
+                                   journal_item);
+                }
+                else
+                {
+                    the_server.DownloadFile(remote_file_name, download_file_name);
+                    FinishDownload(download_file_name, {}, journal_item);
+                }
                 ++downloaded_files_counter;
                 spdlog::debug(catenate("F: Retrieved remote form file: ", remote_file_name.string(),
                                        " to: ", local_file_name.string()));
@@ -309,6 +1146,7 @@ void FormFileRetriever::RetrieveSpecifiedFiles(const std::vector<fs::path> &remo
                                        " to: ", local_file_name.string(), " !!\n", e.what()));
 
                 ++error_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_failed);
                 continue;
             }
             catch (std::exception &e)
@@ -319,6 +1157,7 @@ void FormFileRetriever::RetrieveSpecifiedFiles(const std::vector<fs::path> &remo
                 spdlog::error(catenate("F: !! Problem retrieving remote form file: ", remote_file_name.string(),
                                        " to: ", local_file_name.string(), " !!\n", e.what()));
                 ++error_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_failed);
             }
         }
         else
@@ -326,6 +1165,7 @@ void FormFileRetriever::RetrieveSpecifiedFiles(const std::vector<fs::path> &remo
             spdlog::debug(catenate("F: File exists and 'replace' is false: skipping download: ",
                                    local_file_name.filename().string()));
             ++skipped_files_counter;
+            RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
         }
     }
 
@@ -333,39 +1173,21 @@ void FormFileRetriever::RetrieveSpecifiedFiles(const std::vector<fs::path> &remo
                           ". Errors: ", error_counter, ". for files for form type: ", form_type));
 } // -----  end of method FormFileRetriever::RetrieveSpecifiedFiles  -----
 
-auto FormFileRetriever::AddToCopyList(const std::string &form_name,
-                                      const fs::path &local_form_directory,
-                                      bool replace_files)
-{
-    //	construct our lambda function here so it doesn't clutter up our code
-    // below.
-
-    return [this, &form_name, &local_form_directory, replace_files](const auto &remote_file_name) {
-        auto local_dir_name = MakeLocalDirNameFromRemoteFileName(local_form_directory, remote_file_name, form_name);
-        auto local_file_name{local_dir_name};
-        local_file_name /= remote_file_name.filename();
-
-        if (replace_files || !fs::exists(local_file_name))
-        {
-            fs::create_directories(local_dir_name);
-            return HTTPS_Downloader::copy_file_names(remote_file_name, local_file_name);
-        }
-        // we use an empty remote file name to indicate no copy needed as the local
-        // file already exists.
-
-        return HTTPS_Downloader::copy_file_names({}, local_file_name);
-    };
-}
-
-void FormFileRetriever::ConcurrentlyRetrieveSpecifiedFiles(const std::vector<fs::path> &remote_file_names,
-                                                           const std::string &form_type,
+void FormFileRetriever::ConcurrentlyRetrieveSpecifiedFiles(const FilingPlan &filing_plan,
+                                                           std::span<const FilingPlan::Filing> filings,
+                                                           COL::sview form_type,
                                                            const fs::path &local_form_directory,
                                                            int max_at_a_time,
                                                            bool replace_files)
 {
-    if (remote_file_names.size() < max_at_a_time)
+    if (segment_store_ != nullptr && segment_store_->WantsFormType(form_type))
     {
-        return RetrieveSpecifiedFiles(remote_file_names, form_type, local_form_directory, replace_files);
+        return RetrieveFilesToSegments(filing_plan, filings, form_type, max_at_a_time, replace_files);
+    }
+
+    if (filings.size() < max_at_a_time)
+    {
+        return RetrieveSpecifiedFiles(filing_plan, filings, form_type, local_form_directory, replace_files);
     }
 
     // some forms can have slash in the form local_file_name so...
@@ -373,30 +1195,62 @@ void FormFileRetriever::ConcurrentlyRetrieveSpecifiedFiles(const std::vector<fs:
     std::string form_name{form_type};
     std::replace(form_name.begin(), form_name.end(), '/', '_');
 
-    // we need to create a list of file name pairs -- remote file name, local file
-    // name. we'll pass that list to the downloader and let it manage to process
-    // from there.
+    // decide what needs downloading up front so we can say how much there is
+    // before we start.  With a manifest or run journal, that is a lookup for
+    // each filing.
+
+    const auto files_to_download =
+        FindFilingsToDownload(filing_plan, filings, form_name, local_form_directory, replace_files);
+    const auto skipped_files_counter = static_cast<int>(filings.size() - files_to_download.size());
+
+    // the downloader asks us for the remote and local file names of each
+    // filing when it is ready to download it.  That way we only have path
+    // names for the files in progress, not the whole plan.
 
     // Also, here we will create the directory hierarchies for the to-be
     // downloaded files. Taking the easy way out so we don't have to worry about
     // file system race conditions.
 
-    HTTPS_Downloader::remote_local_list concurrent_copy_list;
+    // the downloader only gives us back the download file name so, with a
+    // run journal, keep track of which filing each download in progress is.
+    // All the callbacks are made from the downloader's thread.
 
-    std::transform(std::begin(remote_file_names), std::end(remote_file_names), std::back_inserter(concurrent_copy_list),
-                   AddToCopyList(form_name, local_form_directory, replace_files));
-    // now, we expect some magic to happen here...
+    std::unordered_map<std::string, RunJournal::Item> journal_items_in_progress;
 
-    std::cout << std::format("# files to download: {}\n",
-                             std::count_if(concurrent_copy_list.begin(), concurrent_copy_list.end(),
-                                           [](const auto &x) { return x.first.has_value(); }));
-    HTTPS_Downloader the_server(host_, port_);
-    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(concurrent_copy_list, max_at_a_time);
+    auto make_file_names = [&](std::size_t i)
+    {
+        const auto &filing = filings[files_to_download[i]];
+        auto file_names = MakeFormFileNames(filing_plan, filing, form_name, local_form_directory);
+        if (const auto journal_item = FindJournalItem(filing_plan, filing); journal_item)
+        {
+            journal_items_in_progress.emplace(file_names.second.string(), *journal_item);
+        }
+        return file_names;
+    };
 
-    // if the first file name in the pair is empty, there was no download done.
+    // now, we expect some magic to happen here...
 
-    int skipped_files_counter = std::count_if(std::begin(concurrent_copy_list), std::end(concurrent_copy_list),
-                                              [](const auto &e) { return !e.first; });
+    std::cout << std::format("# files to download: {}\n", files_to_download.size());
+    HTTPS_Downloader the_server(host_, port_);
+    the_server.HashDownloads(content_store_ != nullptr);
+    the_server.UseFileWriter(file_writer_);
+    auto take_journal_item = [&journal_items_in_progress](const fs::path &download_file_name)
+    {
+        std::optional<RunJournal::Item> journal_item;
+        if (auto found = journal_items_in_progress.find(download_file_name.string());
+            found != journal_items_in_progress.end())
+        {
+            journal_item = found->second;
+            journal_items_in_progress.erase(found);
+        }
+        return journal_item;
+    };
+    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(
+        files_to_download.size(), make_file_names, max_at_a_time,
+        [&](const fs::path &download_file_name, const std::string &content_hash)
+        { FinishDownload(download_file_name, content_hash, take_journal_item(download_file_name)); },
+        [&](const fs::path &download_file_name, const std::string & /* error */)
+        { RecordJournalItem(take_journal_item(download_file_name), RunJournal::ItemState::e_failed); });
 
     spdlog::info(catenate("F: Downloaded: ", success_counter, ". Skipped: ", skipped_files_counter,
                           ". Errors: ", error_counter, ". for files for form type: ", form_type));
@@ -404,28 +1258,198 @@ void FormFileRetriever::ConcurrentlyRetrieveSpecifiedFiles(const std::vector<fs:
     // TODO: figure our error handling when some files do not get downloaded.
     // Let's try this for now.
 
-    if (concurrent_copy_list.size() != success_counter + skipped_files_counter)
+    if (filings.size() != success_counter + skipped_files_counter)
     {
-        throw std::runtime_error(
-            catenate("Download count = ", success_counter, ". Should be: ", concurrent_copy_list.size()));
+        throw std::runtime_error(catenate("Download count = ", success_counter, ". Should be: ", filings.size()));
     }
 
 } // -----  end of method FormFileRetriever::RetrieveSpecifiedFiles  -----
 
+std::vector<std::uint32_t> FormFileRetriever::FindFilingsToDownload(const FilingPlan &filing_plan,
+                                                                    std::span<const FilingPlan::Filing> filings,
+                                                                    const std::string &form_name,
+                                                                    const fs::path &local_form_directory,
+                                                                    bool replace_files)
+{
+    std::vector<std::uint32_t> files_to_download;
+    for (std::uint32_t i = 0; i < filings.size(); ++i)
+    {
+        const auto journal_item = FindJournalItem(filing_plan, filings[i]);
+        if (JournalHasDone(journal_item))
+        {
+            continue;
+        }
+        if (!replace_files)
+        {
+            const auto remote_file_name = filing_plan.GetRemoteFileName(filings[i]);
+            auto local_file_name = MakeLocalDirNameFromRemoteFileName(local_form_directory, remote_file_name,
+                                                                      form_name, form_directory_layout_);
+            local_file_name /= remote_file_name.filename();
+            if (HaveLocalFile(local_file_name))
+            {
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
+                continue;
+            }
+        }
+        files_to_download.push_back(i);
+    }
+    return files_to_download;
+} // -----  end of method FormFileRetriever::FindFilingsToDownload  -----
+
+HTTPS_Downloader::copy_file_names FormFileRetriever::MakeFormFileNames(const FilingPlan &filing_plan,
+                                                                       const FilingPlan::Filing &filing,
+                                                                       const std::string &form_name,
+                                                                       const fs::path &local_form_directory)
+{
+    auto remote_file_name = filing_plan.GetRemoteFileName(filing);
+    auto local_dir_name = MakeLocalDirNameFromRemoteFileName(local_form_directory, remote_file_name, form_name,
+                                                             form_directory_layout_);
+    auto local_file_name{local_dir_name};
+    local_file_name /= remote_file_name.filename();
+
+    MakeDirectory(local_dir_name);
+    return HTTPS_Downloader::copy_file_names(std::move(remote_file_name), MakeDownloadFileName(local_file_name));
+} // -----  end of method FormFileRetriever::MakeFormFileNames  -----
+
+void FormFileRetriever::RetrieveFilesToSegments(const FilingPlan &filing_plan,
+                                                std::span<const FilingPlan::Filing> filings,
+                                                COL::sview form_type,
+                                                int max_at_a_time,
+                                                bool replace_files)
+{
+    int downloaded_files_counter = 0;
+    int skipped_files_counter = 0;
+    int shared_files_counter = 0;
+    int error_counter = 0;
+
+    // a Form 3, 4 or 5 is listed under the issuer and each reporting owner.
+    // Once we have it for one of them, the others just get index entries.
+
+    if (max_at_a_time <= 1 || filings.size() < max_at_a_time)
+    {
+        for (const auto &filing : filings)
+        {
+            const auto journal_item = FindJournalItem(filing_plan, filing);
+            if (JournalHasDone(journal_item))
+            {
+                ++skipped_files_counter;
+                continue;
+            }
+            const auto file_name = filing_plan.GetFileName(filing);
+            if (!replace_files && segment_store_->HasFile(filing.CIK, file_name))
+            {
+                spdlog::debug(catenate("F: File is in segment store and 'replace' is false: skipping download: ",
+                                       file_name));
+                ++skipped_files_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
+                continue;
+            }
+            if (!replace_files && segment_store_->AddSharedFile(filing.CIK, form_type, file_name))
+            {
+                ++shared_files_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
+                continue;
+            }
+            try
+            {
+                HTTPS_Downloader the_server(host_, port_);
+                const auto download_file_name = segment_store_->MakeDownloadFileName(filing.CIK, file_name);
+                the_server.DownloadFile(filing_plan.GetRemoteFileName(filing), download_file_name);
+                segment_store_->AddFile(download_file_name, filing.CIK, form_type, file_name);
+                ++downloaded_files_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
+            }
+            catch (std::exception &e)
+            {
+                spdlog::error(catenate("F: Unable to download file: ", file_name, " because: ", e.what()));
+                ++error_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_failed);
+            }
+        }
+    }
+    else
+    {
+        // the downloader only gives us back the download file name so keep
+        // track of which filing each download in progress is for.  Both
+        // callbacks are made from the downloader's thread.
+
+        std::unordered_map<std::string, const FilingPlan::Filing *> downloads_in_progress;
+
+        auto make_file_names = [&](std::size_t i)
+        {
+            const auto &filing = filings[i];
+            const auto journal_item = FindJournalItem(filing_plan, filing);
+            if (JournalHasDone(journal_item))
+            {
+                ++skipped_files_counter;
+                return HTTPS_Downloader::copy_file_names({}, {});
+            }
+            const auto file_name = filing_plan.GetFileName(filing);
+            if (!replace_files && segment_store_->HasFile(filing.CIK, file_name))
+            {
+                ++skipped_files_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
+                return HTTPS_Downloader::copy_file_names({}, {});
+            }
+            if (!replace_files && segment_store_->AddSharedFile(filing.CIK, form_type, file_name))
+            {
+                ++shared_files_counter;
+                RecordJournalItem(journal_item, RunJournal::ItemState::e_completed);
+                return HTTPS_Downloader::copy_file_names({}, {});
+            }
+            auto download_file_name = segment_store_->MakeDownloadFileName(filing.CIK, file_name);
+            downloads_in_progress.emplace(download_file_name.string(), &filing);
+            return HTTPS_Downloader::copy_file_names(filing_plan.GetRemoteFileName(filing),
+                                                     std::move(download_file_name));
+        };
+
+        HTTPS_Downloader the_server(host_, port_);
+        the_server.UseFileWriter(file_writer_);
+        std::tie(downloaded_files_counter, error_counter) = the_server.DownloadFilesConcurrently(
+            filings.size(), make_file_names, max_at_a_time,
+            [&](const fs::path &download_file_name, const std::string & /* content_hash */)
+            {
+                const auto found = downloads_in_progress.find(download_file_name.string());
+                BOOST_ASSERT_MSG(found != downloads_in_progress.end(),
+                                 catenate("Unexpected download: ", download_file_name.string()).c_str());
+                const auto &filing = *found->second;
+                downloads_in_progress.erase(found);
+                segment_store_->AddFile(download_file_name, filing.CIK, form_type, filing_plan.GetFileName(filing));
+                RecordJournalItem(FindJournalItem(filing_plan, filing), RunJournal::ItemState::e_completed);
+            },
+            [&](const fs::path &download_file_name, const std::string & /* error */)
+            {
+                if (const auto found = downloads_in_progress.find(download_file_name.string());
+                    found != downloads_in_progress.end())
+                {
+                    RecordJournalItem(FindJournalItem(filing_plan, *found->second), RunJournal::ItemState::e_failed);
+                    downloads_in_progress.erase(found);
+                }
+            });
+    }
+
+    spdlog::info(catenate("F: Downloaded: ", downloaded_files_counter, ". Skipped: ", skipped_files_counter,
+                          ". Shared: ", shared_files_counter, ". Errors: ", error_counter,
+                          ". for files for form type: ", form_type, " to segment store."));
+} // -----  end of method FormFileRetriever::RetrieveFilesToSegments  -----
+
 fs::path MakeLocalDirNameFromRemoteFileName(const fs::path &local_form_directory_name,
                                             const fs::path &remote_file_name,
-                                            const std::string &form_name)
+                                            const std::string &form_name,
+                                            FormDirectoryLayout layout)
 {
     //    auto CIK_directory{remote_file_name.parent_path().filename()};	//
     //    pull off the CIK directory name
-    std::string CIK_directory{remote_file_name.parent_path().filename().string()}; //	pull off the CIK directory name
-
-    // pad our CIK component to 10 positions.
-
-    CIK_directory.insert(0, 10 - CIK_directory.size(), '0');
+    return MakeLocalDirName(local_form_directory_name, remote_file_name.parent_path().filename().string(), form_name,
+                            layout);
+}
 
-    auto local_dir_name{local_form_directory_name};
-    local_dir_name /= CIK_directory;
+fs::path MakeLocalDirName(const fs::path &local_form_directory_name,
+                          COL::sview CIK_directory,
+                          const std::string &form_name,
+                          FormDirectoryLayout layout)
+{
+    auto local_dir_name = MakeCIKDirName(local_form_directory_name, CIK_directory, layout);
     local_dir_name /= form_name;
     return local_dir_name;
 }
@@ -34,23 +34,54 @@
 #ifndef FORMRETRIEVER_H_
 #define FORMRETRIEVER_H_
 
+#include <chrono>
 #include <filesystem>
-#include <map>
+#include <functional>
+#include <optional>
+#include <span>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+#include "FilingPlan.h"
+#include "FormDirectoryLayout.h"
+#include "HTTPS_Downloader.h"
+#include "RunJournal.h"
 #include "TickerConverter.h"
 
+class BinaryIndexFile;
+class CIKFilter;
+class ContentStore;
+class DownloadManifest;
+class FileWriter;
+class FormFileCompressor;
+class FormTypeMatcher;
+class GroupCommit;
+class SegmentStore;
+
 // =====================================================================================
 //        Class:  FormFileRetriever
 //  Description:
 // =====================================================================================
 class FormFileRetriever
 {
+    // filters index data while it downloads using the same code we use for
+    // local index files.
+
+    friend class IndexStreamFilter;
+
 public:
-    using FormsAndFilesList = std::map<std::string, std::vector<fs::path>>;
+    // gets an index file from the server, passing its data to the handler as
+    // it arrives, and returns the local file name.
+
+    using IndexFileCopier = std::function<fs::path(const fs::path &, const HTTPS_Downloader::DataHandler &)>;
+
+    // makes the filing plan for a run when there isn't one saved.
+
+    using PlanMaker = std::function<FilingPlan()>;
 
     // ====================  LIFECYCLE     =======================================
 
@@ -65,60 +96,317 @@ public:
 
     // ====================  MUTATORS      =======================================
 
+    // search the binary copies of index files (made as needed) instead of
+    // the text files.  On by default.
+
+    void UseBinaryIndexFiles(bool use_binary_index_files)
+    {
+        use_binary_index_files_ = use_binary_index_files;
+    }
+
+    // save the results of searching each index file next to it and use them
+    // the next time the same index file is searched with the same filter.
+    // On by default.
+
+    void UseQueryResultCache(bool use_query_result_cache)
+    {
+        use_query_result_cache_ = use_query_result_cache;
+    }
+
+    // decide which form files we already have from the manifest instead of
+    // looking for each one in the file system.  Downloads are recorded in it.
+
+    void UseDownloadManifest(DownloadManifest *download_manifest)
+    {
+        download_manifest_ = download_manifest;
+    }
+
+    // keep form files in the content store and link to them from the form
+    // directories.
+
+    void UseContentStore(ContentStore *content_store)
+    {
+        content_store_ = content_store;
+    }
+
+    // append the form types the segment store wants to its segment files
+    // instead of saving them as separate files.
+
+    void UseSegmentStore(SegmentStore *segment_store)
+    {
+        segment_store_ = segment_store;
+    }
+
+    // compress each form file once it has been downloaded.  Files we already
+    // have count whether they are compressed or not.
+
+    void UseFormFileCompressor(FormFileCompressor *form_file_compressor)
+    {
+        form_file_compressor_ = form_file_compressor;
+    }
+
+    // download form files to temp files and let group_commit give them
+    // their real names once they are safely on disk.  They are recorded in
+    // the manifest then too.
+
+    void UseGroupCommit(GroupCommit *group_commit)
+    {
+        group_commit_ = group_commit;
+    }
+
+    // concurrent downloads hand their files to file_writer to write.
+
+    void UseFileWriter(FileWriter *file_writer)
+    {
+        file_writer_ = file_writer;
+    }
+
+    // take the filing plans from the run journal when it has them and record
+    // each filing as it is done or fails.  Filings the journal has as done
+    // are skipped without looking for their files.
+
+    void UseRunJournal(RunJournal *run_journal)
+    {
+        run_journal_ = run_journal;
+    }
+
+    // how the <CIK> directories are arranged in the form directory.  Flat
+    // unless told otherwise.
+
+    void UseFormDirectoryLayout(FormDirectoryLayout form_directory_layout)
+    {
+        form_directory_layout_ = form_directory_layout;
+    }
+
+    // only keep filings with a date filed in this closed interval.  Quarterly
+    // index files cover 3 months so this lets us take just part of one.
+
+    void FilterOnDateFiled(std::chrono::year_month_day begin_date, std::chrono::year_month_day end_date);
+
     FormFileRetriever &operator=(const FormFileRetriever &rhs) = delete;
     FormFileRetriever &operator=(FormFileRetriever &&rhs) = delete;
 
     // ====================  OPERATORS     =======================================
 
-    FormsAndFilesList FindFilesForForms(const std::vector<std::string> &the_form_types,
-                                        const fs::path &local_index_file_name,
-                                        const TickerConverter::TickerCIKMap &ticker_map = {});
+    // large index files are split up and scanned concurrently.  max_threads <= 0
+    // means use one thread per available core.
+
+    // the results are sorted by form type.
+
+    FilingPlan FindFilesForForms(const std::vector<std::string> &the_form_types,
+                                 const fs::path &local_index_file_name,
+                                 const TickerConverter::TickerCIKMap &ticker_map = {},
+                                 int max_threads = 0);
 
-    FormsAndFilesList FindFilesForForms(const std::vector<std::string> &the_form_types,
-                                        const std::vector<fs::path> &local_index_files,
-                                        const TickerConverter::TickerCIKMap &ticker_map = {});
+    // scans the index files concurrently.  max_threads <= 0 means use
+    // one thread per available core.  Results are accumulated in the order
+    // of the given files.
+
+    FilingPlan FindFilesForForms(const std::vector<std::string> &the_form_types,
+                                 const std::vector<fs::path> &local_index_files,
+                                 const TickerConverter::TickerCIKMap &ticker_map = {},
+                                 int max_threads = 0);
 
     // NOTE: the retrieved files will be placed in a directory hierarchy as
     // follows: <form_directory>/<the_form_type>/<CIK number>/<file name>
 
-    void RetrieveSpecifiedFiles(const FormsAndFilesList &form_list,
+    void RetrieveSpecifiedFiles(const FilingPlan &filing_plan,
                                 const fs::path &local_form_directory,
                                 bool replace_files = false);
 
-    void ConcurrentlyRetrieveSpecifiedFiles(const FormsAndFilesList &form_list,
+    void ConcurrentlyRetrieveSpecifiedFiles(const FilingPlan &filing_plan,
                                             const fs::path &local_form_directory,
                                             int max_at_a_time,
                                             bool replace_files = false);
 
+    // source names the index file(s) the plan comes from.  With a run
+    // journal, the plan for source comes from the journal if it has one.
+    // Otherwise make_plan makes it and it is added to the journal.  Without
+    // one, this is just ConcurrentlyRetrieveSpecifiedFiles(make_plan(), ...).
+
+    void RetrieveFilesForPlan(const std::string &source,
+                              const PlanMaker &make_plan,
+                              const fs::path &local_form_directory,
+                              int max_at_a_time,
+                              bool replace_files = false);
+
+    // instead of getting all the index files and then all the form files,
+    // start on the form files for each index file as soon as it has been
+    // downloaded and searched.  Up to max_at_a_time index files are done at
+    // a time on other threads.  Their form files all go through one download
+    // queue, max_at_a_time at a time, in the order the index files are done.
+
+    void RetrieveFilesForFormsAsIndexFilesArrive(const std::vector<std::string> &the_form_types,
+                                                 const std::vector<fs::path> &remote_index_files,
+                                                 const IndexFileCopier &copy_index_file,
+                                                 const TickerConverter::TickerCIKMap &ticker_map,
+                                                 const fs::path &local_form_directory,
+                                                 int max_at_a_time,
+                                                 bool replace_files = false);
+
 protected:
-    void RetrieveSpecifiedFiles(const std::vector<fs::path> &remote_file_names,
-                                const std::string &form_type,
+    // the filings for just the given form type.
+
+    void RetrieveSpecifiedFiles(const FilingPlan &filing_plan,
+                                std::span<const FilingPlan::Filing> filings,
+                                COL::sview form_type,
                                 const fs::path &local_form_directory,
                                 bool replace_files = false);
 
-    void ConcurrentlyRetrieveSpecifiedFiles(const std::vector<fs::path> &remote_file_names,
-                                            const std::string &form_type, const fs::path &local_form_directory,
+    void ConcurrentlyRetrieveSpecifiedFiles(const FilingPlan &filing_plan,
+                                            std::span<const FilingPlan::Filing> filings,
+                                            COL::sview form_type, const fs::path &local_form_directory,
                                             int max_at_a_time, bool replace_files = false);
 
+    // for form types kept in the segment store.  max_at_a_time <= 1 means one
+    // at a time.
+
+    void RetrieveFilesToSegments(const FilingPlan &filing_plan,
+                                 std::span<const FilingPlan::Filing> filings,
+                                 COL::sview form_type,
+                                 int max_at_a_time,
+                                 bool replace_files);
+
     // ====================  DATA MEMBERS  =======================================
 
 private:
-    bool CIK_is_in_CIKList(const std::vector<std::string_view> &cik_list, std::string_view cik_from_index_file);
-    fs::path ExtractFileName(std::string_view index_file_name);
+    [[nodiscard]] bool HaveLocalFile(const fs::path &local_file_name) const;
+
+    // where to download a form file to.  Different from the file name when
+    // using the content store or group commit.
+
+    [[nodiscard]] fs::path MakeDownloadFileName(const fs::path &local_file_name) const;
+
+    // the filings we don't have yet, by where they are in filings.  Those we
+    // have are recorded as done in the run journal.
+
+    [[nodiscard]] std::vector<std::uint32_t> FindFilingsToDownload(const FilingPlan &filing_plan,
+                                                                 std::span<const FilingPlan::Filing> filings,
+                                                                 const std::string &form_name,
+                                                                 const fs::path &local_form_directory,
+                                                                 bool replace_files);
+
+    // the remote file name for a filing and the name to download it to.
+    // Makes its directory if we haven't yet.
+
+    [[nodiscard]] HTTPS_Downloader::copy_file_names MakeFormFileNames(const FilingPlan &filing_plan,
+                                                                    const FilingPlan::Filing &filing,
+                                                                    const std::string &form_name,
+                                                                    const fs::path &local_form_directory);
+
+    // puts a downloaded form file where it belongs and records it.
+
+    void FinishDownload(const fs::path &download_file_name,
+                        const std::string &content_hash,
+                        std::optional<RunJournal::Item> journal_item = {});
+
+    // the run journal's item for a filing in the plan being retrieved.
+    // Nothing without a journal.
+
+    [[nodiscard]] std::optional<RunJournal::Item> FindJournalItem(const FilingPlan &filing_plan,
+                                                                  const FilingPlan::Filing &filing) const;
+    [[nodiscard]] bool JournalHasDone(const std::optional<RunJournal::Item> &journal_item) const
+    {
+        return journal_item && run_journal_->GetItemState(*journal_item) == RunJournal::ItemState::e_completed;
+    }
+    void RecordJournalItem(const std::optional<RunJournal::Item> &journal_item, RunJournal::ItemState state)
+    {
+        if (journal_item)
+        {
+            run_journal_->RecordItem(*journal_item, state);
+        }
+    }
+
+    // thousands of filings can share a <CIK>/<form type> directory so we
+    // make each distinct directory for a plan once, several at a time, and
+    // remember we did.
+
+    void MakeFormDirectories(const FilingPlan &filing_plan, const fs::path &local_form_directory, int max_threads);
+    void MakeDirectory(const fs::path &directory_name);
+
+    [[nodiscard]] bool DateFiledIsWanted(std::chrono::sys_days date_filed) const
+    {
+        return !first_date_filed_ || (date_filed >= *first_date_filed_ && date_filed <= *last_date_filed_);
+    }
+
+    // form_type_width is 0 for master index data.  See FindFormTypeColumnWidth.
+
+    std::pair<FilingPlan, std::size_t> FilterIndexRecords(COL::sview index_records,
+                                                          const FormTypeMatcher &form_matcher,
+                                                          const CIKFilter &cik_filter,
+                                                          std::size_t form_type_width);
+
+    // row_ranges are BinaryIndexFile::RowRanges.
 
-    auto AddToCopyList(const std::string &form_name, const fs::path &local_form_directory, bool replace_files);
+    std::pair<FilingPlan, std::size_t> FilterBinaryIndexRecords(
+        const BinaryIndexFile &binary_index, std::span<const std::pair<std::size_t, std::size_t>> row_ranges,
+        const FormTypeMatcher &form_matcher, const CIKFilter &cik_filter);
+
+    // returns the results for each piece of the file we scanned, in file order.
+
+    std::vector<std::pair<FilingPlan, std::size_t>> ScanTextIndexFile(const fs::path &local_index_file_name,
+                                                                      const FormTypeMatcher &form_matcher,
+                                                                      const CIKFilter &cik_filter,
+                                                                      int max_threads);
+    std::vector<std::pair<FilingPlan, std::size_t>> ScanBinaryIndexFile(const BinaryIndexFile &binary_index,
+                                                                        const FormTypeMatcher &form_matcher,
+                                                                        const CIKFilter &cik_filter,
+                                                                        int max_threads);
 
     // ====================  DATA MEMBERS  =======================================
 
     static constexpr std::string::size_type k_index_CIK_offset = 79;
 
+    // don't bother splitting up index data smaller than this for concurrent
+    // scanning.  Daily index files generally fall below it.
+
+    static constexpr std::size_t k_min_scan_chunk_size = 8 * 1024 * 1024;
+
+    // same idea for binary index files.  A row there is much cheaper to check.
+
+    static constexpr std::size_t k_min_binary_scan_chunk_rows = 256 * 1024;
+
     std::string host_;
     std::string port_;
 
+    bool use_binary_index_files_ = true;
+    bool use_query_result_cache_ = true;
+
+    DownloadManifest *download_manifest_ = nullptr;
+    ContentStore *content_store_ = nullptr;
+    SegmentStore *segment_store_ = nullptr;
+    FormFileCompressor *form_file_compressor_ = nullptr;
+    GroupCommit *group_commit_ = nullptr;
+    FileWriter *file_writer_ = nullptr;
+    RunJournal *run_journal_ = nullptr;
+
+    // the journal's number for the plan being retrieved.
+
+    std::optional<std::uint32_t> journal_plan_;
+
+    FormDirectoryLayout form_directory_layout_ = FormDirectoryLayout::e_flat;
+
+    // directories we know are there.  Only used from the thread doing the
+    // downloads.
+
+    std::unordered_set<std::string> made_directories_;
+
+    std::optional<std::chrono::sys_days> first_date_filed_;
+    std::optional<std::chrono::sys_days> last_date_filed_;
+
 }; // -----  end of class FormFileRetriever  -----
 
 fs::path MakeLocalDirNameFromRemoteFileName(const fs::path &local_form_directory_name,
                                             const fs::path &remote_file_name,
-                                            const std::string &form_name);
+                                            const std::string &form_name,
+                                            FormDirectoryLayout layout = FormDirectoryLayout::e_flat);
+
+// <local_form_directory_name>/<CIK padded to 10 digits>/<form_name> with the
+// CIK directory wherever the layout puts it.
+
+fs::path MakeLocalDirName(const fs::path &local_form_directory_name,
+                          COL::sview CIK_directory,
+                          const std::string &form_name,
+                          FormDirectoryLayout layout = FormDirectoryLayout::e_flat);
 
 #endif /* FORMRETRIEVER_H_ */
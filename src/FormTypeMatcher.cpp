@@ -0,0 +1,123 @@
+// =====================================================================================
+//
+//       Filename:  FormTypeMatcher.cpp
+//
+//    Description:  Implements precompiled matcher for the form types we are
+//    looking for
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:40:02 AM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include "BinaryFileUtils.h"
+#include "FormTypeMatcher.h"
+
+//--------------------------------------------------------------------------------------
+//       Class:  FormTypeMatcher
+//      Method:  FormTypeMatcher
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+FormTypeMatcher::FormTypeMatcher(const std::vector<std::string> &form_types)
+{
+    for (const auto &form_type : form_types)
+    {
+        if (form_type == "*")
+        {
+            match_everything_ = true;
+        }
+        else if (form_type.ends_with('*'))
+        {
+            prefix_patterns_.emplace_back(form_type.substr(0, form_type.size() - 1));
+        }
+        else
+        {
+            exact_forms_.push_back(form_type);
+        }
+    }
+
+    std::sort(exact_forms_.begin(), exact_forms_.end());
+    exact_forms_.erase(std::unique(exact_forms_.begin(), exact_forms_.end()), exact_forms_.end());
+
+    std::sort(prefix_patterns_.begin(), prefix_patterns_.end());
+    prefix_patterns_.erase(std::unique(prefix_patterns_.begin(), prefix_patterns_.end()), prefix_patterns_.end());
+
+    BOOST_ASSERT_MSG(exact_forms_.size() < std::numeric_limits<std::uint16_t>::max(), "Too many form types to match.");
+
+    // keep the table at most half full so probe sequences stay short.
+
+    const auto table_size = std::bit_ceil(std::max<std::size_t>(16, exact_forms_.size() * 2));
+    hash_slots_.assign(table_size, 0);
+    hash_mask_ = static_cast<std::uint32_t>(table_size - 1);
+
+    for (std::size_t form_ID = 0; form_ID < exact_forms_.size(); ++form_ID)
+    {
+        auto slot = HashForm(exact_forms_[form_ID]) & hash_mask_;
+        while (hash_slots_[slot] != 0)
+        {
+            slot = (slot + 1) & hash_mask_;
+        }
+        hash_slots_[slot] = static_cast<std::uint16_t>(form_ID + 1);
+    }
+} // -----  end of method FormTypeMatcher::FormTypeMatcher  (constructor)  -----
+
+std::optional<COL::sview> FormTypeMatcher::Match(COL::sview form_type) const
+{
+    if (const auto form_ID = FindFormID(form_type); form_ID >= 0)
+    {
+        return COL::sview{exact_forms_[form_ID]};
+    }
+
+    if (match_everything_ ||
+        std::ranges::any_of(prefix_patterns_, [form_type](const auto &prefix) { return form_type.starts_with(prefix); }))
+    {
+        return form_type;
+    }
+    return std::nullopt;
+} // -----  end of method FormTypeMatcher::Match  -----
+
+int FormTypeMatcher::FindFormID(COL::sview form_type) const
+{
+    for (auto slot = HashForm(form_type) & hash_mask_; hash_slots_[slot] != 0; slot = (slot + 1) & hash_mask_)
+    {
+        const int form_ID = hash_slots_[slot] - 1;
+        if (exact_forms_[form_ID] == form_type)
+        {
+            return form_ID;
+        }
+    }
+    return -1;
+} // -----  end of method FormTypeMatcher::FindFormID  -----
+
+std::uint32_t FormTypeMatcher::HashForm(COL::sview form_type)
+{
+    // form types are short so this is just a handful of multiplies.
+
+    return FNV1a32(form_type);
+} // -----  end of method FormTypeMatcher::HashForm  -----
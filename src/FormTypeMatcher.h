@@ -0,0 +1,116 @@
+// =====================================================================================
+//
+//       Filename:  FormTypeMatcher.h
+//
+//    Description:  Precompiled matcher for the form types we are looking for
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:31:26 AM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef FORMTYPEMATCHER_H_
+#define FORMTYPEMATCHER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Collector_Utils.h"
+
+// =====================================================================================
+//        Class:  FormTypeMatcher
+//  Description:  built once from the user's list of form types and then used to
+//                test the form field of every index record.
+//
+//                Plain form types ("10-K", "8-K/A") are interned and looked up
+//                in a small open addressing hash table.  Form types ending in
+//                '*' ("10-K*") are treated as prefix patterns.  A lone "*"
+//                matches everything.
+//
+//                Matching works directly on the string_view from the index
+//                data so nothing is allocated per row.
+// =====================================================================================
+class FormTypeMatcher
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    FormTypeMatcher() = delete;
+    explicit FormTypeMatcher(const std::vector<std::string> &form_types);
+
+    // ====================  ACCESSORS     =======================================
+
+    // returns the form type to file a match under or nothing if the form type
+    // is not one we want.  For exact matches this is a view of our interned
+    // copy, for pattern matches it is the given view.
+
+    [[nodiscard]] std::optional<COL::sview> Match(COL::sview form_type) const;
+
+    // the interned (exact) form types, sorted and de-duplicated.  A form's
+    // position here is its form ID.
+
+    [[nodiscard]] const std::vector<std::string> &GetExactForms() const
+    {
+        return exact_forms_;
+    }
+    [[nodiscard]] const std::vector<std::string> &GetPrefixPatterns() const
+    {
+        return prefix_patterns_;
+    }
+    [[nodiscard]] bool MatchesEverything() const
+    {
+        return match_everything_;
+    }
+
+    // -1 if the form is not one of our exact form types.
+
+    [[nodiscard]] int FindFormID(COL::sview form_type) const;
+
+    // ====================  MUTATORS      =======================================
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    static std::uint32_t HashForm(COL::sview form_type);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    // each slot holds a form ID + 1 so 0 can mean empty.
+
+    std::vector<std::uint16_t> hash_slots_;
+    std::uint32_t hash_mask_ = 0;
+
+    std::vector<std::string> exact_forms_;
+    std::vector<std::string> prefix_patterns_;
+
+    bool match_everything_ = false;
+
+}; // -----  end of class FormTypeMatcher  -----
+
+#endif /* FORMTYPEMATCHER_H_ */
@@ -0,0 +1,259 @@
+// =====================================================================================
+//
+//       Filename:  GroupCommit.cpp
+//
+//    Description:  Makes downloaded files durable a batch at a time before
+//                  giving them their real names
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:31 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <cerrno>
+#include <exception>
+#include <format>
+#include <map>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "Collector_Utils.h"
+#include "GroupCommit.h"
+
+namespace
+{
+// flushes everything waiting to be written on each file system the files
+// are on.  One call covers every file in the batch on that file system.
+
+bool SyncFileSystems(const std::vector<fs::path> &file_names)
+{
+    std::map<dev_t, fs::path> file_systems;
+    for (const auto &file_name : file_names)
+    {
+        struct stat file_status{};
+        if (::stat(file_name.c_str(), &file_status) == 0)
+        {
+            file_systems.try_emplace(file_status.st_dev, file_name);
+        }
+    }
+
+    bool all_synced = true;
+    for (const auto &[device, file_name] : file_systems)
+    {
+        const int fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1 || ::syncfs(fd) != 0)
+        {
+            std::error_code ec{errno, std::system_category()};
+            spdlog::error(catenate("W: Unable to sync file system for: ", file_name.string(), ". ", ec.message()));
+            all_synced = false;
+        }
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+    }
+    return all_synced;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  GroupCommit
+//      Method:  GroupCommit
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+GroupCommit::GroupCommit(std::size_t batch_size, std::chrono::milliseconds interval)
+    : batch_size_{batch_size}, interval_{interval}
+{
+    BOOST_ASSERT_MSG(batch_size_ > 0, "Group commit batch size must be > 0.");
+    BOOST_ASSERT_MSG(interval_.count() > 0, "Group commit interval must be > 0.");
+
+    pending_files_.reserve(batch_size_);
+    committer_ = std::thread{&GroupCommit::CommitAtIntervals, this};
+} // -----  end of method GroupCommit::GroupCommit  (constructor)  -----
+
+GroupCommit::~GroupCommit()
+{
+    {
+        std::lock_guard<std::mutex> lock{pending_mutex_};
+        stopping_ = true;
+    }
+    pending_condition_.notify_one();
+    committer_.join();
+
+    CommitPendingFiles();
+} // -----  end of method GroupCommit::~GroupCommit  (destructor)  -----
+
+GroupCommit::Statistics GroupCommit::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock{pending_mutex_};
+    return statistics_;
+} // -----  end of method GroupCommit::GetStatistics  -----
+
+void GroupCommit::LogStatistics() const
+{
+    const auto statistics = GetStatistics();
+    const std::chrono::duration<double> commit_time = statistics.commit_time;
+    spdlog::info(std::format("W: Committed {} files in {} batches ({:.1f} files per batch) in {:.3f} seconds. "
+                             "Errors: {}.",
+                             statistics.files_committed, statistics.batches_committed,
+                             statistics.batches_committed > 0 ? static_cast<double>(statistics.files_committed) /
+                                                                    static_cast<double>(statistics.batches_committed)
+                                                              : 0.0,
+                             commit_time.count(), statistics.errors));
+} // -----  end of method GroupCommit::LogStatistics  -----
+
+void GroupCommit::Commit(const fs::path &temp_file_name, const fs::path &file_name, CommitHandler on_committed)
+{
+    bool batch_is_full = false;
+    {
+        std::lock_guard<std::mutex> lock{pending_mutex_};
+        pending_files_.emplace_back(temp_file_name, file_name, std::move(on_committed));
+        batch_is_full = pending_files_.size() >= batch_size_;
+    }
+    if (batch_is_full)
+    {
+        pending_condition_.notify_one();
+    }
+} // -----  end of method GroupCommit::Commit  -----
+
+void GroupCommit::Flush()
+{
+    CommitPendingFiles();
+} // -----  end of method GroupCommit::Flush  -----
+
+void GroupCommit::CommitAtIntervals()
+{
+    std::unique_lock<std::mutex> lock{pending_mutex_};
+    while (!stopping_)
+    {
+        pending_condition_.wait_for(lock, interval_,
+                                    [this] { return stopping_ || pending_files_.size() >= batch_size_; });
+        lock.unlock();
+        CommitPendingFiles();
+        lock.lock();
+    }
+} // -----  end of method GroupCommit::CommitAtIntervals  -----
+
+void GroupCommit::CommitPendingFiles()
+{
+    // holding commit_mutex_ while taking the batch means Flush can't return
+    // while a batch taken before it is still being committed.
+
+    std::lock_guard<std::mutex> commit_lock{commit_mutex_};
+
+    std::vector<PendingFile> batch;
+    {
+        std::lock_guard<std::mutex> lock{pending_mutex_};
+        batch.swap(pending_files_);
+        pending_files_.reserve(batch_size_);
+    }
+    if (!batch.empty())
+    {
+        CommitBatch(batch);
+    }
+} // -----  end of method GroupCommit::CommitPendingFiles  -----
+
+void GroupCommit::CommitBatch(std::vector<PendingFile> &batch)
+{
+    const auto commit_start = std::chrono::steady_clock::now();
+
+    std::uint64_t files_committed = 0;
+    std::uint64_t errors = 0;
+
+    // the data first.  If that can't be done, the files stay as '.tmp' files
+    // and will be downloaded again next time.
+
+    std::vector<fs::path> temp_file_names;
+    temp_file_names.reserve(batch.size());
+    for (const auto &pending_file : batch)
+    {
+        temp_file_names.push_back(pending_file.temp_file_name);
+    }
+
+    bool names_are_durable = false;
+    if (SyncFileSystems(temp_file_names))
+    {
+        // a rename lost in a crash leaves a '.tmp' file, which is never
+        // trusted, so the renames need no flush of their own before they are
+        // done.  They do before anyone is told.
+
+        std::vector<fs::path> file_names;
+        file_names.reserve(batch.size());
+        for (auto &pending_file : batch)
+        {
+            std::error_code ec;
+            fs::rename(pending_file.temp_file_name, pending_file.file_name, ec);
+            if (ec)
+            {
+                spdlog::error(catenate("W: Unable to commit: ", pending_file.temp_file_name.string(), " as: ",
+                                       pending_file.file_name.string(), ". ", ec.message()));
+                ++errors;
+                pending_file.on_committed = {};
+                continue;
+            }
+            file_names.push_back(pending_file.file_name);
+            ++files_committed;
+        }
+        names_are_durable = SyncFileSystems(file_names);
+    }
+
+    if (!names_are_durable)
+    {
+        // anything renamed is complete and Reconcile will find it.
+
+        errors = batch.size();
+        files_committed = 0;
+    }
+    else
+    {
+        for (const auto &pending_file : batch)
+        {
+            if (!pending_file.on_committed)
+            {
+                continue;
+            }
+            try
+            {
+                pending_file.on_committed();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error(catenate("W: Problem finishing: ", pending_file.file_name.string(), ". ", e.what()));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock{pending_mutex_};
+    statistics_.files_committed += files_committed;
+    statistics_.errors += errors;
+    ++statistics_.batches_committed;
+    statistics_.commit_time += std::chrono::steady_clock::now() - commit_start;
+} // -----  end of method GroupCommit::CommitBatch  -----
@@ -0,0 +1,153 @@
+// =====================================================================================
+//
+//       Filename:  GroupCommit.h
+//
+//    Description:  Makes downloaded files durable a batch at a time before
+//                  giving them their real names
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:31 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef GROUPCOMMIT_H_
+#define GROUPCOMMIT_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  GroupCommit
+//  Description:  a file written under its real name and closed without an
+//                fsync may be incomplete after a crash and there is no
+//                telling which ones are.
+//
+//                With group commit, files are written under a temporary name
+//                and handed to Commit.  A batch at a time, the data is
+//                flushed to disk, each file is renamed to its real name and
+//                the renames are flushed.  So a file with its real name is
+//                always complete, and a crash loses at most the files in the
+//                current batch (as '.tmp' files, which are never trusted).
+//
+//                Flushing with one syncfs per file system per batch instead
+//                of an fsync per file is what keeps this from slowing the
+//                downloads down.  A batch is committed when it has
+//                batch_size files or interval has passed.
+// =====================================================================================
+class GroupCommit
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t files_committed = 0;
+        std::uint64_t batches_committed = 0;
+        std::uint64_t errors = 0;
+        std::chrono::steady_clock::duration commit_time{};
+    };
+
+    // called once a file has been committed.  Called from our thread or
+    // from whoever calls Flush.
+
+    using CommitHandler = std::function<void()>;
+
+    // ====================  LIFECYCLE     =======================================
+
+    GroupCommit() = delete;
+    GroupCommit(std::size_t batch_size, std::chrono::milliseconds interval);
+
+    GroupCommit(const GroupCommit &rhs) = delete;
+    GroupCommit(GroupCommit &&rhs) = delete;
+
+    // commits anything still waiting.
+
+    ~GroupCommit();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    void LogStatistics() const;
+
+    // ====================  MUTATORS      =======================================
+
+    GroupCommit &operator=(const GroupCommit &rhs) = delete;
+    GroupCommit &operator=(GroupCommit &&rhs) = delete;
+
+    // temp_file_name has been written and closed.  It will be renamed to
+    // file_name once it is safely on disk.  Safe to call from any thread.
+
+    void Commit(const fs::path &temp_file_name, const fs::path &file_name, CommitHandler on_committed = {});
+
+    // commits everything waiting now and returns when it is done.
+
+    void Flush();
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    struct PendingFile
+    {
+        fs::path temp_file_name;
+        fs::path file_name;
+        CommitHandler on_committed;
+    };
+
+    void CommitAtIntervals();
+    void CommitPendingFiles();
+    void CommitBatch(std::vector<PendingFile> &batch);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    std::size_t batch_size_;
+    std::chrono::milliseconds interval_;
+
+    std::vector<PendingFile> pending_files_;
+    bool stopping_ = false;
+
+    Statistics statistics_;
+
+    mutable std::mutex pending_mutex_;
+    std::condition_variable pending_condition_;
+
+    // one batch at a time.
+
+    std::mutex commit_mutex_;
+
+    std::thread committer_;
+
+}; // -----  end of class GroupCommit  -----
+
+#endif /* GROUPCOMMIT_H_ */
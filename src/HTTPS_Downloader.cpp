@@ -35,13 +35,15 @@
 
 #include <algorithm>
 #include <array>
-#include <cerrno>
 #include <chrono>
 #include <csignal>
 #include <exception>
+#include <format>
 #include <fstream>
 #include <future>
 #include <iterator>
+#include <limits>
+#include <optional>
 #include <sstream>
 #include <system_error>
 #include <thread>
@@ -55,11 +57,15 @@
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/json.hpp>
 
+#include <openssl/evp.h>
 #include <spdlog/spdlog.h>
 #include <zip.h>
+#include <zlib.h>
 
 #include "Collector_Utils.h"
+#include "FileWriter.h"
 #include "HTTPS_Downloader.h"
+#include "PreallocatedFile.h"
 
 namespace beast = boost::beast; // from <boost/beast.hpp>
 namespace http = beast::http;   // from <boost/beast/http.hpp>
@@ -100,6 +106,170 @@ int wait_for_any(std::vector<std::future<T>> &vf, std::chrono::steady_clock::dur
     }
 }
 
+namespace
+{
+// how much of the response body we ask for at a time when streaming.
+
+constexpr std::size_t k_stream_chunk_size = 64 * 1024;
+
+// boost's gzip filter wants the whole file up front so we use zlib directly
+// to expand gzipped data a piece at a time as it arrives.
+
+class GZipStreamExpander
+{
+public:
+    GZipStreamExpander()
+    {
+        // 16 + MAX_WBITS tells zlib to expect a gzip header.
+
+        if (inflateInit2(&stream_, 16 + MAX_WBITS) != Z_OK)
+        {
+            throw std::runtime_error("Unable to set up gzip decompression.");
+        }
+    }
+    GZipStreamExpander(const GZipStreamExpander &rhs) = delete;
+    GZipStreamExpander &operator=(const GZipStreamExpander &rhs) = delete;
+
+    ~GZipStreamExpander()
+    {
+        inflateEnd(&stream_);
+    }
+
+    [[nodiscard]] bool IsFinished() const
+    {
+        return finished_;
+    }
+
+    template <typename Handler>
+    void Expand(std::string_view compressed_data, Handler &&handle_expanded_data)
+    {
+        stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed_data.data()));
+        stream_.avail_in = static_cast<uInt>(compressed_data.size());
+
+        do
+        {
+            stream_.next_out = reinterpret_cast<Bytef *>(buffer_.data());
+            stream_.avail_out = static_cast<uInt>(buffer_.size());
+
+            const auto rc = inflate(&stream_, Z_NO_FLUSH);
+            if (rc == Z_BUF_ERROR)
+            {
+                break; // need more input
+            }
+            if (rc != Z_OK && rc != Z_STREAM_END)
+            {
+                throw std::runtime_error(
+                    catenate("Unable to expand gzipped data: ", stream_.msg != nullptr ? stream_.msg : "unknown error."));
+            }
+            if (const auto expanded_size = buffer_.size() - stream_.avail_out; expanded_size > 0)
+            {
+                handle_expanded_data(std::string_view{buffer_.data(), expanded_size});
+            }
+
+            // a gzip file can be several gzip members one after the other.
+
+            finished_ = rc == Z_STREAM_END;
+            if (finished_ && stream_.avail_in > 0)
+            {
+                inflateReset(&stream_);
+            }
+        } while (stream_.avail_in > 0 || stream_.avail_out == 0);
+    }
+
+private:
+    z_stream stream_{};
+    std::array<char, 4 * k_stream_chunk_size> buffer_;
+    bool finished_ = false;
+};
+
+// a gzip file ends with the size of its expanded data, modulo 4 GiB.  If
+// the file has several members, it is only the last one's.  Good enough for
+// a hint.
+
+std::uint64_t GZipExpandedSizeHint(const std::vector<char> &gzipped_data)
+{
+    // header and trailer alone take 18 bytes.
+
+    if (gzipped_data.size() < 18)
+    {
+        return 0;
+    }
+    std::uint64_t expanded_size = 0;
+    for (auto i = gzipped_data.size() - 1; i >= gzipped_data.size() - 4; --i)
+    {
+        expanded_size = (expanded_size << 8) | static_cast<unsigned char>(gzipped_data[i]);
+    }
+    return expanded_size;
+}
+
+// a download may be written under a temp name ('.tmp' on the end) and
+// renamed once it is all there.  This is the extension of the name it ends
+// up with.
+
+fs::path FinalExtension(const fs::path &local_file_name)
+{
+    if (local_file_name.extension() == ".tmp")
+    {
+        return local_file_name.stem().extension();
+    }
+    return local_file_name.extension();
+}
+
+// SHA-256 of data given to us a piece at a time.
+
+class SHA256Hasher
+{
+public:
+    SHA256Hasher() : context_{EVP_MD_CTX_new()}
+    {
+        if (context_ == nullptr || EVP_DigestInit_ex(context_, EVP_sha256(), nullptr) != 1)
+        {
+            EVP_MD_CTX_free(context_);
+            throw std::runtime_error("Unable to set up SHA-256 hashing.");
+        }
+    }
+    SHA256Hasher(const SHA256Hasher &rhs) = delete;
+    SHA256Hasher &operator=(const SHA256Hasher &rhs) = delete;
+
+    ~SHA256Hasher()
+    {
+        EVP_MD_CTX_free(context_);
+    }
+
+    void Update(std::string_view data)
+    {
+        if (EVP_DigestUpdate(context_, data.data(), data.size()) != 1)
+        {
+            throw std::runtime_error("Unable to compute SHA-256 hash.");
+        }
+    }
+
+    // as lower case hex.
+
+    std::string Finish()
+    {
+        std::array<unsigned char, EVP_MAX_MD_SIZE> digest;
+        unsigned int digest_size = 0;
+        if (EVP_DigestFinal_ex(context_, digest.data(), &digest_size) != 1)
+        {
+            throw std::runtime_error("Unable to compute SHA-256 hash.");
+        }
+
+        std::string result;
+        result.reserve(2 * digest_size);
+        for (unsigned int i = 0; i < digest_size; ++i)
+        {
+            std::format_to(std::back_inserter(result), "{:02x}", digest[i]);
+        }
+        return result;
+    }
+
+private:
+    EVP_MD_CTX *context_;
+};
+
+} // namespace
+
 //--------------------------------------------------------------------------------------
 //       Class:  HTTPS_Downloader
 //      Method:  HTTPS_Downloader
@@ -204,6 +374,27 @@ void HTTPS_Downloader::DownloadFile(const fs::path &remote_file_name, const fs::
 
     const bool need_to_unzip = (remote_ext == ".gz" or remote_ext == ".zip") && remote_ext != local_ext;
 
+    const std::vector<char> remote_data = DownloadFileData(remote_file_name);
+
+    if (!need_to_unzip)
+    {
+        DownloadTextFile(local_file_name, remote_data, remote_file_name);
+    }
+    else
+    {
+        if (remote_ext == ".gz")
+        {
+            DownloadGZipFile(local_file_name, remote_data, remote_file_name);
+        }
+        else
+        {
+            DownloadZipFile(local_file_name, remote_data, remote_file_name);
+        }
+    }
+} // -----  end of method HTTPS_Downloader::DownloadFile  -----
+
+std::vector<char> HTTPS_Downloader::DownloadFileData(const fs::path &remote_file_name)
+{
     tcp::resolver resolver(ioc);
     beast::ssl_stream<beast::tcp_stream> stream(ioc, ctx);
 
@@ -246,31 +437,244 @@ void HTTPS_Downloader::DownloadFile(const fs::path &remote_file_name, const fs::
         throw std::system_error(ec, catenate(remote_file_name, ": Result: ", ec.message(), "  ",
                                              response_content.base().reason().data(), ": Unable to download file."));
     }
-    std::vector<char> remote_data = response_content.body();
+    std::vector<char> remote_data = std::move(response_content.body());
 
     // shutdown without causing a 'stream_truncated' error.
 
     beast::get_lowest_layer(stream).cancel();
     beast::get_lowest_layer(stream).close();
 
-    if (!need_to_unzip)
+    return remote_data;
+} // -----  end of method HTTPS_Downloader::DownloadFileData  -----
+
+std::string HTTPS_Downloader::DownloadFileToWriter(const fs::path &remote_file_name,
+                                                   const fs::path &local_file_name,
+                                                   std::future<void> &file_written)
+{
+    auto remote_data = DownloadFileData(remote_file_name);
+    if (remote_data.empty())
     {
-        DownloadTextFile(local_file_name, remote_data, remote_file_name);
+        throw std::runtime_error(catenate("Unable to initiate download of remote file: ", remote_file_name.string(),
+                                          " to local file: ", local_file_name.string()));
     }
-    else
+    file_written = file_writer_->WriteFile(local_file_name, std::move(remote_data));
+
+    // same as DownloadFileAndHash when not hashing.
+
+    return {};
+} // -----  end of method HTTPS_Downloader::DownloadFileToWriter  -----
+
+void HTTPS_Downloader::DownloadAndProcessFile(const fs::path &remote_file_name,
+                                              const fs::path &local_file_name,
+                                              const DataHandler &handle_data)
+{
+    const auto remote_ext = remote_file_name.extension();
+    const auto local_ext = local_file_name.extension();
+
+    const bool need_to_unzip = (remote_ext == ".gz" or remote_ext == ".zip") && remote_ext != local_ext;
+
+    // zip archives keep their directory at the end so there is nothing we can
+    // do until we have the whole thing.
+
+    if (need_to_unzip && remote_ext == ".zip")
     {
-        if (remote_ext == ".gz")
+        DownloadFile(remote_file_name, local_file_name);
+        return;
+    }
+
+    tcp::resolver resolver(ioc);
+    beast::ssl_stream<beast::tcp_stream> stream(ioc, ctx);
+
+    if (!SSL_set_tlsext_host_name(stream.native_handle(), server_name_.c_str()))
+    {
+        beast::error_code ec{static_cast<int>(::ERR_get_error()), net::error::get_ssl_category()};
+        throw beast::system_error{ec};
+    }
+
+    auto const results = resolver.resolve(server_name_, port_);
+
+    beast::get_lowest_layer(stream).connect(results);
+
+    stream.handshake(ssl::stream_base::client);
+
+    http::request<http::string_body> req{http::verb::get, remote_file_name.c_str(), version_};
+    req.set(http::field::host, server_name_);
+    req.set(http::field::user_agent, "driedel@cox.net");
+
+    http::write(stream, req);
+
+    beast::flat_buffer buffer;
+
+    // read the headers first then the body a chunk at a time into our own
+    // buffer.
+
+    http::response_parser<http::buffer_body> res_parser;
+    res_parser.body_limit((std::numeric_limits<std::uint64_t>::max)());
+
+    beast::error_code ec;
+    http::read_header(stream, buffer, res_parser, ec);
+    const auto &response_header = res_parser.get().base();
+
+    if (http::int_to_status(response_header.result_int()) == http::status::request_timeout)
+    {
+        throw Collector::TimeOutException(catenate(remote_file_name, ": Result: ", ec.message(), "  ",
+                                                   response_header.reason().data(), ": Unable to download file."));
+    }
+    if (ec != beast::errc::success || http::int_to_status(response_header.result_int()) != http::status::ok)
+    {
+        throw std::system_error(ec, catenate(remote_file_name, ": Result: ", ec.message(), "  ",
+                                             response_header.reason().data(), ": Unable to download file."));
+    }
+
+    // we only know how big the file will be if we aren't expanding it.
+
+    const auto content_length = res_parser.content_length();
+    PreallocatedFile local_file{local_file_name, !need_to_unzip && content_length ? *content_length : 0};
+
+    auto save_data = [&](std::string_view data)
+    {
+        local_file.Write(data);
+        handle_data(data);
+    };
+
+    // we write as we go so don't leave part of a file behind if something
+    // goes wrong.  It would look like a good file next time.
+
+    try
+    {
+        std::optional<GZipStreamExpander> expander;
+        if (need_to_unzip)
         {
-            DownloadGZipFile(local_file_name, remote_data, remote_file_name);
+            expander.emplace();
         }
-        else
+
+        std::vector<char> chunk(k_stream_chunk_size);
+        std::size_t total_bytes_read = 0;
+
+        while (!res_parser.is_done())
         {
-            DownloadZipFile(local_file_name, remote_data, remote_file_name);
+            res_parser.get().body().data = chunk.data();
+            res_parser.get().body().size = chunk.size();
+
+            http::read(stream, buffer, res_parser, ec);
+
+            // this just means our buffer is full.
+
+            if (ec == http::error::need_buffer)
+            {
+                ec = {};
+            }
+            if (ec)
+            {
+                throw std::system_error(ec, catenate(remote_file_name, ": Result: ", ec.message(),
+                                                     ": Unable to complete download of file."));
+            }
+
+            const std::string_view received_data{chunk.data(), chunk.size() - res_parser.get().body().size};
+            total_bytes_read += received_data.size();
+
+            if (expander)
+            {
+                expander->Expand(received_data, save_data);
+            }
+            else
+            {
+                save_data(received_data);
+            }
+        }
+
+        // shutdown without causing a 'stream_truncated' error.
+
+        beast::get_lowest_layer(stream).cancel();
+        beast::get_lowest_layer(stream).close();
+
+        local_file.Close();
+        if (total_bytes_read == 0 || (expander && !expander->IsFinished()))
+        {
+            throw std::runtime_error(catenate("Incomplete download of remote file: ", remote_file_name.string(),
+                                              " to local file: ", local_file_name.string()));
         }
     }
-} // -----  end of method HTTPS_Downloader::DownloadFile  -----
+    catch (...)
+    {
+        std::error_code remove_err;
+        fs::remove(local_file_name, remove_err);
+        throw;
+    }
 
-std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_local_list &file_list, int max_at_a_time)
+    // we may have a downloads logger so let's use it if we do.
+
+    auto downloads_logger = spdlog::get(DOWNLOADS_LOGGER_NAME);
+    if (downloads_logger)
+    {
+        downloads_logger->info(local_file_name);
+    }
+} // -----  end of method HTTPS_Downloader::DownloadAndProcessFile  -----
+
+std::string HTTPS_Downloader::DownloadFileAndHash(const fs::path &remote_file_name, const fs::path &local_file_name)
+{
+    SHA256Hasher hasher;
+    bool hashed_while_downloading = false;
+
+    DownloadAndProcessFile(remote_file_name, local_file_name,
+                           [&](std::string_view data)
+                           {
+                               hasher.Update(data);
+                               hashed_while_downloading = true;
+                           });
+
+    // a zip archive has to be expanded after the download so hash what we
+    // ended up with.
+
+    if (!hashed_while_downloading)
+    {
+        std::ifstream local_file{local_file_name, std::ios::in | std::ios::binary};
+        std::vector<char> buffer(k_stream_chunk_size);
+        while (local_file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || local_file.gcount() > 0)
+        {
+            hasher.Update(std::string_view{buffer.data(), static_cast<std::size_t>(local_file.gcount())});
+        }
+        if (local_file.bad())
+        {
+            throw std::runtime_error(catenate("Unable to read downloaded file: ", local_file_name.string()));
+        }
+    }
+    return hasher.Finish();
+} // -----  end of method HTTPS_Downloader::DownloadFileAndHash  -----
+
+std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_local_list &file_list,
+                                                                int max_at_a_time,
+                                                                const FileDoneHandler &file_done,
+                                                                const FileDoneHandler &file_failed)
+{
+    return DownloadFilesConcurrently(
+        file_list.size(), [&file_list](std::size_t i) { return file_list[i]; }, max_at_a_time, file_done,
+        file_failed);
+} // -----  end of method HTTPS_Downloader::DownloadFilesConcurrently  -----
+
+std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(std::size_t file_count,
+                                                                const copy_file_names_maker &make_file_names,
+                                                                int max_at_a_time,
+                                                                const FileDoneHandler &file_done,
+                                                                const FileDoneHandler &file_failed)
+{
+    std::size_t i = 0;
+    return DownloadFilesConcurrently(
+        [&]() -> std::optional<copy_file_names>
+        {
+            if (i == file_count)
+            {
+                return {};
+            }
+            return make_file_names(i++);
+        },
+        max_at_a_time, file_done, file_failed);
+} // -----  end of method HTTPS_Downloader::DownloadFilesConcurrently  -----
+
+std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const next_file_names_maker &next_file_names,
+                                                                int max_at_a_time,
+                                                                const FileDoneHandler &file_done,
+                                                                const FileDoneHandler &file_failed)
 
 {
     // since this code can potentially run for hours on end (depending on internet
@@ -300,29 +704,77 @@ std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_loc
     int success_counter = 0;
     int error_counter = 0;
 
-    for (int i = 0; i < file_list.size();)
+    std::size_t file_count = 0;
+    bool more_files = true;
+
+    while (more_files)
     {
         // keep track of our async processes here.
 
-        std::vector<std::future<void>> tasks;
+        std::vector<std::future<std::string>> tasks;
         tasks.reserve(max_at_a_time + 1);
+        std::vector<fs::path> task_files;
+        task_files.reserve(max_at_a_time);
 
-        for (; tasks.size() < max_at_a_time && i < file_list.size(); ++i)
+        // with a file writer, each download task hands its file to it and
+        // is done.  The file is there once its write is.
+
+        std::vector<std::future<void>> task_writes(max_at_a_time + 1);
+
+        while (tasks.size() < max_at_a_time)
         {
             // queue up our tasks up to the limit.
 
-            auto &[remote_file, local_file] = file_list[i];
-            if (remote_file)
+            auto file_names = next_file_names();
+            if (!file_names)
             {
-                tasks.emplace_back(
-                    std::async(std::launch::async, &HTTPS_Downloader::DownloadFile, this, *remote_file, local_file));
+                more_files = false;
+                break;
+            }
+            ++file_count;
+
+            auto [remote_file, local_file] = std::move(*file_names);
+            if (remote_file && hash_downloads_)
+            {
+                tasks.emplace_back(std::async(std::launch::async, &HTTPS_Downloader::DownloadFileAndHash, this,
+                                              *remote_file, local_file));
+                task_files.push_back(std::move(local_file));
+            }
+            else if (remote_file && file_writer_ != nullptr && remote_file->extension() == FinalExtension(local_file))
+            {
+                tasks.emplace_back(std::async(std::launch::async, &HTTPS_Downloader::DownloadFileToWriter, this,
+                                              *remote_file, local_file, std::ref(task_writes[tasks.size()])));
+                task_files.push_back(std::move(local_file));
+            }
+            else if (remote_file)
+            {
+                tasks.emplace_back(std::async(std::launch::async,
+                                              [this, remote_file = *remote_file, local_file]()
+                                              {
+                                                  DownloadFile(remote_file, local_file);
+                                                  return std::string{};
+                                              }));
+                task_files.push_back(std::move(local_file));
             }
             // std::cout << "i: " << i << " j: " << j << '\n';
         }
 
+        // the list ran out right after a full batch or the rest of it was
+        // files we didn't need to download.
+
+        if (tasks.empty())
+        {
+            break;
+        }
+
         // lastly, throw in our delay just in case we need it.
 
-        tasks.emplace_back(std::async(std::launch::async, &HTTPS_Downloader::Timer, this));
+        tasks.emplace_back(std::async(std::launch::async,
+                                      [this]()
+                                      {
+                                          Timer();
+                                          return std::string{};
+                                      }));
 
         // now, let's wait till they're all done
         // and then we'll do the next bunch.
@@ -333,8 +785,26 @@ std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_loc
             // std::cout << "k: " << k << '\n';
             try
             {
-                tasks[k].get();
+                const auto content_hash = tasks[k].get();
+                if (task_writes[k].valid())
+                {
+                    task_writes[k].get();
+
+                    // we may have a downloads logger so let's use it if we do.
+
+                    if (auto downloads_logger = spdlog::get(DOWNLOADS_LOGGER_NAME); downloads_logger)
+                    {
+                        downloads_logger->info(task_files[k]);
+                    }
+                }
                 ++success_counter;
+
+                // the timer task is last and has no file.
+
+                if (file_done && k < task_files.size())
+                {
+                    file_done(task_files[k], content_hash);
+                }
             }
             catch (std::system_error &e)
             {
@@ -347,6 +817,11 @@ std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_loc
                     catenate("Category: ", ec.category().name(), ". Value: ", ec.value(), ". Message: ", ec.message()));
                 ++error_counter;
 
+                if (file_failed && k < task_files.size())
+                {
+                    file_failed(task_files[k], e.what());
+                }
+
                 // OK, let's remember our first time here.
 
                 if (!ep)
@@ -362,6 +837,11 @@ std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_loc
                 spdlog::error(e.what());
                 ++error_counter;
 
+                if (file_failed && k < task_files.size())
+                {
+                    file_failed(task_files[k], e.what());
+                }
+
                 // OK, let's remember our first time here.
 
                 if (!ep)
@@ -377,6 +857,11 @@ std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_loc
                 spdlog::error("Unknown problem with an async download process");
                 ++error_counter;
 
+                if (file_failed && k < task_files.size())
+                {
+                    file_failed(task_files[k], "Unknown problem with an async download process");
+                }
+
                 // OK, let's remember our first time here.
 
                 if (!ep)
@@ -398,14 +883,14 @@ std::pair<int, int> HTTPS_Downloader::DownloadFilesConcurrently(const remote_loc
 
     if (ep)
     {
-        spdlog::error(catenate("Processed: ", file_list.size(), " files. Successes: ", success_counter,
+        spdlog::error(catenate("Processed: ", file_count, " files. Successes: ", success_counter,
                                ". Errors: ", error_counter, "."));
         std::rethrow_exception(ep);
     }
 
     if (HTTPS_Downloader::had_signal_)
     {
-        spdlog::error(catenate("Processed: ", file_list.size(), " files. Successes: ", success_counter,
+        spdlog::error(catenate("Processed: ", file_count, " files. Successes: ", success_counter,
                                ". Errors: ", error_counter, "."));
         throw std::runtime_error("Received keyboard interrupt.  Processing manually terminated.");
     }
@@ -442,8 +927,7 @@ void DownloadTextFile(const fs::path &local_file_name,
                       const std::vector<char> &remote_data,
                       const fs::path &remote_file_name)
 {
-    std::ofstream local_file{local_file_name, std::ios::out | std::ios::binary};
-    if (!local_file || remote_data.empty())
+    if (remote_data.empty())
     {
         throw std::runtime_error(catenate("Unable to initiate download of remote file: ", remote_file_name.string(),
                                           " to local file: ", local_file_name.string()));
@@ -451,14 +935,20 @@ void DownloadTextFile(const fs::path &local_file_name,
 
     // we have an array of chars so let's just dump it out.
 
-    errno = 0;
-    auto &download_result = local_file.write(remote_data.data(), remote_data.size());
-    local_file.close();
-    if (download_result.fail())
+    // don't leave part of a file behind if something goes wrong.  It would
+    // look like a good file next time.
+
+    try
     {
-        std::error_code err{errno, std::system_category()};
-        throw std::system_error{err, catenate("Unable to complete download of remote file: ", remote_file_name.string(),
-                                              " to local file: ", local_file_name.string())};
+        PreallocatedFile local_file{local_file_name, remote_data.size()};
+        local_file.Write(std::string_view{remote_data.data(), remote_data.size()});
+        local_file.Close();
+    }
+    catch (...)
+    {
+        std::error_code remove_err;
+        fs::remove(local_file_name, remove_err);
+        throw;
     }
 
     // we may have a downloads logger so let's use it if we do.
@@ -476,8 +966,7 @@ void DownloadGZipFile(const fs::path &local_file_name,
 {
     // we are going to decompress on the fly...
 
-    std::ofstream expanded_file{local_file_name, std::ios::out | std::ios::binary};
-    if (!expanded_file || remote_data.empty())
+    if (remote_data.empty())
     {
         throw std::runtime_error(catenate("Unable to initiate download of remote file: ", remote_file_name.string(),
                                           " to local file: ", local_file_name.string()));
@@ -494,15 +983,30 @@ void DownloadGZipFile(const fs::path &local_file_name,
     in.push(boost::iostreams::gzip_decompressor());
     in.push(remote);
 
-    errno = 0;
-    auto download_result = std::copy(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(),
-                                     std::ostreambuf_iterator<char>{expanded_file});
-    expanded_file.close();
-    if (download_result.failed())
+    // don't leave part of a file behind if something goes wrong.  It would
+    // look like a good file next time.
+
+    try
+    {
+        PreallocatedFile expanded_file{local_file_name, GZipExpandedSizeHint(remote_data)};
+
+        std::vector<char> buffer(k_stream_chunk_size);
+        while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0)
+        {
+            expanded_file.Write(std::string_view{buffer.data(), static_cast<std::size_t>(in.gcount())});
+        }
+        if (in.bad())
+        {
+            throw std::runtime_error(catenate("Unable to expand download of remote file: ",
+                                              remote_file_name.string(), " to local file: ", local_file_name.string()));
+        }
+        expanded_file.Close();
+    }
+    catch (...)
     {
-        std::error_code err{errno, std::system_category()};
-        throw std::system_error{err, catenate("Unable to complete download of remote file: ", remote_file_name.string(),
-                                              " to local file: ", local_file_name.string())};
+        std::error_code remove_err;
+        fs::remove(local_file_name, remove_err);
+        throw;
     }
 
     // we may have a downloads logger so let's use it if we do.
@@ -518,8 +1022,7 @@ void DownloadZipFile(const fs::path &local_file_name,
                      const std::vector<char> &remote_data,
                      const fs::path &remote_file_name)
 {
-    std::ofstream expanded_file{local_file_name, std::ios::out | std::ios::binary};
-    if (!expanded_file || remote_data.empty())
+    if (remote_data.empty())
     {
         throw std::runtime_error(catenate("Unable to initiate download of remote file: ", remote_file_name.string(),
                                           " to local file: ", local_file_name.string()));
@@ -560,6 +1063,7 @@ void DownloadZipFile(const fs::path &local_file_name,
     // we're all set now, we've found our data in the archive so
     // we're just going to chunk through the archive and write the data out.
     // downloaded files can by 30MB or more in size. Can be smaller too..
+    // The archive tells us which.
 
     constexpr int buffer_size = 100'000;
     constexpr int pad_bytes = 100;
@@ -574,28 +1078,35 @@ void DownloadZipFile(const fs::path &local_file_name,
                                           " in archive because: ", zip_error_strerror(stat_error)));
     }
 
-    while (total_bytes_read < st.size)
+    // don't leave part of a file behind if something goes wrong.  It would
+    // look like a good file next time.
+
+    try
     {
-        auto bytes_read = zip_fread(downloaded_zip_file, my_buffer.data(), buffer_size);
-        if (bytes_read == -1)
-        {
-            auto *stat_error = zip_get_error(zip_data_archive);
-            throw std::runtime_error(
-                catenate("Unable to read from zip archive because: ", zip_error_strerror(stat_error)));
-        }
-        total_bytes_read += bytes_read;
+        PreallocatedFile expanded_file{local_file_name, (st.valid & ZIP_STAT_SIZE) != 0 ? st.size : 0};
 
-        auto &download_result = expanded_file.write(my_buffer.data(), bytes_read);
-        if (download_result.fail())
+        while (total_bytes_read < st.size)
         {
-            std::error_code err{errno, std::system_category()};
-            throw std::system_error{err,
-                                    catenate("Unable to complete download of remote file: ", remote_file_name.string(),
-                                             " to local file: ", local_file_name.string())};
+            auto bytes_read = zip_fread(downloaded_zip_file, my_buffer.data(), buffer_size);
+            if (bytes_read == -1)
+            {
+                auto *stat_error = zip_get_error(zip_data_archive);
+                throw std::runtime_error(
+                    catenate("Unable to read from zip archive because: ", zip_error_strerror(stat_error)));
+            }
+            total_bytes_read += bytes_read;
+
+            expanded_file.Write(std::string_view{my_buffer.data(), static_cast<std::size_t>(bytes_read)});
         }
-    }
 
-    expanded_file.close();
+        expanded_file.Close();
+    }
+    catch (...)
+    {
+        std::error_code remove_err;
+        fs::remove(local_file_name, remove_err);
+        throw;
+    }
     zip_fclose(downloaded_zip_file);
     zip_source_close(downloaded_raw_zip_data);
     zip_error_fini(&err);
@@ -34,8 +34,11 @@
 #define HTTPS_DOWNLOADER_H
 
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <boost/beast/core.hpp>
@@ -51,6 +54,8 @@ namespace beast = boost::beast; // from <boost/beast.hpp>
 #include "example/common/root_certificates.hpp"
 #endif
 
+class FileWriter;
+
 // =====================================================================================
 //        Class:  HTTPS_Downloader
 //  Description:  provides read-only access to an HTTPS server
@@ -61,6 +66,25 @@ public:
     using copy_file_names = std::pair<std::optional<fs::path>, fs::path>;
     using remote_local_list = std::vector<copy_file_names>;
 
+    // makes the names for the i'th file of a list.
+
+    using copy_file_names_maker = std::function<copy_file_names(std::size_t)>;
+
+    // makes the names for the next file of a list or returns nothing when
+    // there are no more.  It may wait for more files to turn up.
+
+    using next_file_names_maker = std::function<std::optional<copy_file_names>()>;
+
+    // told the local name of each file as its download finishes and, if we
+    // are hashing downloads, its content hash.  Also used to tell of a file
+    // which failed, with the error.
+
+    using FileDoneHandler = std::function<void(const fs::path &, const std::string &)>;
+
+    // given the (expanded) contents of a file as they arrive.
+
+    using DataHandler = std::function<void(std::string_view)>;
+
     // ====================  LIFECYCLE     =======================================
     HTTPS_Downloader() = delete;                            // constructor
     HTTPS_Downloader(const HTTPS_Downloader &rhs) = delete; // constructor
@@ -80,17 +104,68 @@ public:
 
     void DownloadFile(const fs::path &remote_file_name, const fs::path &local_file_name);
 
+    // like DownloadFile but the data is also given to handle_data as it arrives
+    // so it can be processed while the download continues.  gzipped files are
+    // expanded as they arrive.  A zip archive can't be expanded until we have
+    // all of it so for those, handle_data is not called and the caller needs
+    // to use the local file.
+
+    void DownloadAndProcessFile(const fs::path &remote_file_name,
+                                const fs::path &local_file_name,
+                                const DataHandler &handle_data);
+
+    // like DownloadFile but also returns the SHA-256 of what was saved, as
+    // hex.  The hash is computed as the data arrives.
+
+    std::string DownloadFileAndHash(const fs::path &remote_file_name, const fs::path &local_file_name);
+
     // download multiple files at a time, up to specified limit.
     // this version returns the number of errors encountered.
     // Errors are trapped and logged by the downloader.
 
-    std::pair<int, int> DownloadFilesConcurrently(const remote_local_list &file_list, int max_at_a_time);
+    std::pair<int, int> DownloadFilesConcurrently(const remote_local_list &file_list, int max_at_a_time,
+                                                  const FileDoneHandler &file_done = {},
+                                                  const FileDoneHandler &file_failed = {});
+
+    // same but the names for each file are made only when it is that file's
+    // turn so a long list doesn't need all its names up front.
+
+    std::pair<int, int> DownloadFilesConcurrently(std::size_t file_count,
+                                                  const copy_file_names_maker &make_file_names,
+                                                  int max_at_a_time,
+                                                  const FileDoneHandler &file_done = {},
+                                                  const FileDoneHandler &file_failed = {});
+
+    // same but for a list we don't know the length of up front, such as one
+    // which is still being made while we download.
+
+    std::pair<int, int> DownloadFilesConcurrently(const next_file_names_maker &next_file_names,
+                                                  int max_at_a_time,
+                                                  const FileDoneHandler &file_done = {},
+                                                  const FileDoneHandler &file_failed = {});
 
     // ====================  MUTATORS      =======================================
 
     HTTPS_Downloader &operator=(const HTTPS_Downloader &rhs) = delete;
     HTTPS_Downloader &operator=(HTTPS_Downloader &&rhs) = delete;
 
+    // have DownloadFilesConcurrently hash each file as it downloads.  Off by
+    // default.
+
+    void HashDownloads(bool hash_downloads)
+    {
+        hash_downloads_ = hash_downloads;
+    }
+
+    // have DownloadFilesConcurrently hand each file it downloads to
+    // file_writer instead of writing it on the download thread.  Files that
+    // need expanding are still written as before.
+
+    void UseFileWriter(FileWriter *file_writer)
+    {
+        file_writer_ = file_writer;
+    }
+
     // ====================  OPERATORS     =======================================
 
 protected:
@@ -102,6 +177,17 @@ private:
     void Timer();
     static void HandleSignal(int signal);
 
+    // the body of the response to a request for remote_file_name, as is.
+
+    std::vector<char> DownloadFileData(const fs::path &remote_file_name);
+
+    // for DownloadFilesConcurrently.  Hands the data to our file writer and
+    // returns.  file_written is ready when the file has been written.
+
+    std::string DownloadFileToWriter(const fs::path &remote_file_name,
+                                     const fs::path &local_file_name,
+                                     std::future<void> &file_written);
+
     // ====================  DATA MEMBERS  =======================================
 
     std::string server_name_;
@@ -113,6 +199,10 @@ private:
     boost::asio::io_context ioc;
     boost::asio::ssl::context ctx;
 
+    bool hash_downloads_ = false;
+
+    FileWriter *file_writer_ = nullptr;
+
     static bool had_signal_;
 }; // -----  end of class HTTPS_Downloader  -----
 
@@ -0,0 +1,653 @@
+// =====================================================================================
+//
+//       Filename:  IndexRecordScanner.cpp
+//
+//    Description:  Implements streaming scanner for records in EDGAR master
+//    index files
+//
+//        Version:  1.0
+//        Created:  10/19/2026 10:15:07 AM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "CIKFilter.h"
+#include "IndexRecordScanner.h"
+
+// our data lines have 5 fields so 4 '|' delimiters.
+
+constexpr int k_delimited_fields = 4;
+
+//--------------------------------------------------------------------------------------
+//       Class:  IndexRecordScanner
+//      Method:  IndexRecordScanner
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+IndexRecordScanner::IndexRecordScanner(COL::sview index_data)
+    : current_{index_data.data()}, end_{index_data.data() + index_data.size()}
+{
+} // -----  end of method IndexRecordScanner::IndexRecordScanner  (constructor)  -----
+
+IndexRecordScanner::IndexRecordScanner(COL::sview index_data, std::size_t form_type_width)
+    : current_{index_data.data()}, end_{index_data.data() + index_data.size()}, form_type_width_{form_type_width}
+{
+} // -----  end of method IndexRecordScanner::IndexRecordScanner  (constructor)  -----
+
+bool IndexRecordScanner::NextRecord(IndexRecord &record)
+{
+    if (form_type_width_ > 0)
+    {
+        return NextFixedWidthRecord(record);
+    }
+
+    std::array<COL::sview, k_delimited_fields> fields;
+
+    while (current_ < end_)
+    {
+        const char *field_start = current_;
+        const char *delim = end_;
+        int fld = 0;
+
+        for (; fld < k_delimited_fields; ++fld)
+        {
+            delim = use_scalar_delimiter_search_ ? FindFieldDelimiterScalar(field_start, end_)
+                                                 : FindFieldDelimiter(field_start, end_);
+            if (delim == end_ || *delim == '\n')
+            {
+                break;
+            }
+            fields[fld] = COL::sview(field_start, delim - field_start);
+            field_start = delim + 1;
+        }
+
+        if (fld < k_delimited_fields)
+        {
+            // short or blank line.  Nothing we can use here so move on.
+
+            current_ = delim == end_ ? end_ : delim + 1;
+            continue;
+        }
+
+        // the file name runs to the end of the line.  glibc's memchr is already
+        // vectorized so just use it for the long last field.
+
+        const auto *line_end = static_cast<const char *>(std::memchr(field_start, '\n', end_ - field_start));
+        if (line_end == nullptr)
+        {
+            line_end = end_;
+        }
+        current_ = line_end == end_ ? end_ : line_end + 1;
+
+        if (line_end > field_start && *(line_end - 1) == '\r')
+        {
+            --line_end;
+        }
+
+        record.CIK = fields[0];
+        record.company_name = fields[1];
+        record.form_type = fields[2];
+        record.date_filed = fields[3];
+        record.file_name = COL::sview(field_start, line_end - field_start);
+
+        ++record_count_;
+        return true;
+    }
+    return false;
+} // -----  end of method IndexRecordScanner::NextRecord  -----
+
+bool IndexRecordScanner::NextFixedWidthRecord(IndexRecord &record)
+{
+    // form index lines look like:
+    // Form Type   Company Name        CIK         Date Filed  File Name
+    // Form types and company names can have spaces in them so we take the form
+    // type from its column and work back from the end of the line for the last
+    // 3 fields, which never do.
+
+    while (current_ < end_)
+    {
+        const auto *line_end = static_cast<const char *>(std::memchr(current_, '\n', end_ - current_));
+        if (line_end == nullptr)
+        {
+            line_end = end_;
+        }
+        COL::sview line(current_, line_end - current_);
+        current_ = line_end == end_ ? end_ : line_end + 1;
+
+        const auto last_char = line.find_last_not_of(" \r");
+        if (last_char == COL::sview::npos || last_char < form_type_width_)
+        {
+            continue;
+        }
+        line = line.substr(0, last_char + 1);
+
+        auto form_type = line.substr(0, form_type_width_);
+        form_type = form_type.substr(0, form_type.find_last_not_of(' ') + 1);
+
+        // file name, date filed, CIK
+
+        std::array<COL::sview, 3> trailing_fields;
+        auto rest = line.substr(form_type_width_);
+        int fld = 0;
+        for (; fld < 3; ++fld)
+        {
+            const auto space = rest.rfind(' ');
+            if (space == COL::sview::npos)
+            {
+                break;
+            }
+            trailing_fields[fld] = rest.substr(space + 1);
+            rest = rest.substr(0, rest.find_last_not_of(' ', space) + 1);
+        }
+
+        if (fld < 3 || form_type.empty())
+        {
+            // short or blank line.  Nothing we can use here so move on.
+
+            continue;
+        }
+
+        record.CIK = trailing_fields[2];
+        record.company_name = rest.substr(std::min(rest.size(), rest.find_first_not_of(' ')));
+        record.form_type = form_type;
+        record.date_filed = trailing_fields[1];
+        record.file_name = trailing_fields[0];
+
+        ++record_count_;
+        return true;
+    }
+    return false;
+} // -----  end of method IndexRecordScanner::NextFixedWidthRecord  -----
+
+COL::sview::size_type FindIndexDataStart(COL::sview index_data)
+{
+    for (COL::sview::size_type pos = 0; pos < index_data.size();)
+    {
+        auto line_end = index_data.find('\n', pos);
+        if (index_data.substr(pos).starts_with("----------"))
+        {
+            return line_end == COL::sview::npos ? index_data.size() : line_end + 1;
+        }
+        if (line_end == COL::sview::npos)
+        {
+            break;
+        }
+        pos = line_end + 1;
+    }
+    return COL::sview::npos;
+} // -----  end of function FindIndexDataStart  -----
+
+std::vector<COL::sview> SplitAtLineBoundaries(COL::sview index_data, std::size_t how_many)
+{
+    std::vector<COL::sview> chunks;
+
+    const auto target_size = index_data.size() / std::max<std::size_t>(1, how_many);
+
+    COL::sview::size_type chunk_start = 0;
+    while (how_many > 1 && chunks.size() < how_many - 1 && chunk_start + target_size < index_data.size())
+    {
+        auto chunk_end = index_data.find('\n', chunk_start + target_size);
+        if (chunk_end == COL::sview::npos)
+        {
+            break;
+        }
+        chunks.emplace_back(index_data.substr(chunk_start, chunk_end + 1 - chunk_start));
+        chunk_start = chunk_end + 1;
+    }
+    if (chunk_start < index_data.size() || chunks.empty())
+    {
+        chunks.emplace_back(index_data.substr(chunk_start));
+    }
+    return chunks;
+} // -----  end of function SplitAtLineBoundaries  -----
+
+// some helpers for binary searching a buffer full of lines.  Positions passed
+// in as line starts need to be line starts.
+
+static COL::sview::size_type NextLineStart(COL::sview index_records, COL::sview::size_type line_start)
+{
+    const auto line_end = index_records.find('\n', line_start);
+    return line_end == COL::sview::npos ? index_records.size() : line_end + 1;
+}
+
+static COL::sview::size_type LineStartAtOrAfter(COL::sview index_records, COL::sview::size_type pos)
+{
+    if (pos == 0 || pos >= index_records.size() || index_records[pos - 1] == '\n')
+    {
+        return std::min(pos, index_records.size());
+    }
+    return NextLineStart(index_records, pos);
+}
+
+// the CIK field is everything up to the first '|'.  Lines without one (blank
+// lines at the end of the file) have no CIK and sort after everything else.
+
+static std::optional<COL::sview> CIKFieldAt(COL::sview index_records, COL::sview::size_type line_start)
+{
+    auto line = index_records.substr(line_start, NextLineStart(index_records, line_start) - line_start);
+    const auto delim = line.find_first_of("|\n");
+    if (delim == COL::sview::npos || line[delim] != '|')
+    {
+        return std::nullopt;
+    }
+    return line.substr(0, delim);
+}
+
+// the form type is the first column of a form index line with the padding
+// removed.  Same deal for blank lines as above.
+
+static std::optional<COL::sview> FormTypeFieldAt(COL::sview index_records, COL::sview::size_type line_start,
+                                                 std::size_t form_type_width)
+{
+    auto line = index_records.substr(line_start, NextLineStart(index_records, line_start) - line_start);
+    if (line.size() <= form_type_width)
+    {
+        return std::nullopt;
+    }
+    auto form_type = line.substr(0, form_type_width);
+    form_type.remove_suffix(form_type.size() - (form_type.find_last_not_of(' ') + 1));
+    if (form_type.empty())
+    {
+        return std::nullopt;
+    }
+    return form_type;
+}
+
+// returns the start of the first line for which 'goes_before' is false
+// (or the end of the data).  This is std::partition_point over lines.
+
+template <typename KeyAt, typename GoesBefore>
+static COL::sview::size_type FindFirstLineNotBefore(COL::sview index_records, KeyAt key_at, GoesBefore goes_before)
+{
+    COL::sview::size_type low = 0;
+    COL::sview::size_type high = index_records.size();
+
+    while (low < high)
+    {
+        auto line_start = LineStartAtOrAfter(index_records, low + (high - low) / 2);
+
+        // no line starts in the upper half of our window so the only candidate
+        // left is the first line in it.
+
+        if (line_start >= high)
+        {
+            line_start = low;
+        }
+        if (goes_before(key_at(index_records, line_start)))
+        {
+            low = NextLineStart(index_records, line_start);
+        }
+        else
+        {
+            high = line_start;
+        }
+    }
+    return low;
+}
+
+// we can't afford to check every line to see if a file is really sorted the
+// way we expect so we look at some evenly spaced lines.
+
+template <typename KeyAt>
+static std::vector<COL::sview> SampleLineKeys(COL::sview index_records, KeyAt key_at)
+{
+    constexpr int k_samples = 128;
+
+    std::vector<COL::sview> samples;
+    for (int i = 0; i <= k_samples; ++i)
+    {
+        const auto line_start = LineStartAtOrAfter(index_records, index_records.size() * i / k_samples);
+        if (line_start < index_records.size())
+        {
+            if (auto key = key_at(index_records, line_start); key)
+            {
+                samples.push_back(*key);
+            }
+        }
+    }
+    return samples;
+}
+
+// put our ranges in file order and combine any which overlap so no line
+// gets scanned twice.
+
+static std::vector<COL::sview> MergeRanges(COL::sview index_records,
+                                           std::vector<std::pair<COL::sview::size_type, COL::sview::size_type>> &ranges)
+{
+    std::ranges::sort(ranges);
+
+    std::vector<COL::sview> results;
+    for (std::size_t i = 0; i < ranges.size();)
+    {
+        auto [first, last] = ranges[i];
+        for (++i; i < ranges.size() && ranges[i].first <= last; ++i)
+        {
+            last = std::max(last, ranges[i].second);
+        }
+        results.push_back(index_records.substr(first, last - first));
+    }
+    return results;
+}
+
+std::optional<std::vector<COL::sview>> FindCIKRanges(COL::sview index_records, const std::vector<std::uint32_t> &CIKs)
+{
+    // we need to know what 'in order by CIK' means for this file.  EDGAR sorts
+    // the CIK field as text but let's not count on that.  Sample some lines
+    // and see which ordering they are consistent with.
+
+    const auto samples = SampleLineKeys(index_records, CIKFieldAt);
+
+    const bool text_order = std::ranges::is_sorted(samples);
+    const bool numeric_order =
+        std::ranges::all_of(samples, [](auto CIK) { return ParseCIK(CIK).has_value(); }) &&
+        std::ranges::is_sorted(samples, {}, [](auto CIK) { return *ParseCIK(CIK); });
+
+    if (!text_order && !numeric_order)
+    {
+        return std::nullopt;
+    }
+
+    // when all our samples have the same number of digits, both orderings look
+    // fine.  Searching both ways is cheap and any extra lines we pick up get
+    // filtered out anyway, so just do that.
+
+    std::vector<std::pair<COL::sview::size_type, COL::sview::size_type>> ranges;
+
+    for (const auto CIK : CIKs)
+    {
+        const auto CIK_text = std::to_string(CIK);
+
+        if (text_order)
+        {
+            auto first = FindFirstLineNotBefore(index_records, CIKFieldAt,
+                                                [&CIK_text](auto key) { return key && *key < CIK_text; });
+            auto last = FindFirstLineNotBefore(index_records, CIKFieldAt,
+                                               [&CIK_text](auto key) { return key && *key <= CIK_text; });
+            if (first < last)
+            {
+                ranges.emplace_back(first, last);
+            }
+        }
+        if (numeric_order)
+        {
+            auto as_number = [](auto key) { return key ? ParseCIK(*key) : std::nullopt; };
+            auto first = FindFirstLineNotBefore(index_records, CIKFieldAt, [&](auto key) {
+                auto value = as_number(key);
+                return value && *value < CIK;
+            });
+            auto last = FindFirstLineNotBefore(index_records, CIKFieldAt, [&](auto key) {
+                auto value = as_number(key);
+                return value && *value <= CIK;
+            });
+            if (first < last)
+            {
+                ranges.emplace_back(first, last);
+            }
+        }
+    }
+
+    return MergeRanges(index_records, ranges);
+} // -----  end of function FindCIKRanges  -----
+
+std::optional<std::size_t> FindFormTypeColumnWidth(COL::sview index_data, COL::sview::size_type data_start)
+{
+    // the header line is just above the line of dashes.
+
+    if (data_start == COL::sview::npos || data_start < 2)
+    {
+        return std::nullopt;
+    }
+    const auto header_end = index_data.rfind('\n', data_start - 2);
+    if (header_end == COL::sview::npos || header_end == 0)
+    {
+        return std::nullopt;
+    }
+    auto header_start = index_data.rfind('\n', header_end - 1);
+    header_start = header_start == COL::sview::npos ? 0 : header_start + 1;
+    const auto header = index_data.substr(header_start, header_end - header_start);
+
+    if (!header.starts_with("Form Type"))
+    {
+        return std::nullopt;
+    }
+    const auto company_name_column = header.find("Company Name");
+    if (company_name_column == COL::sview::npos)
+    {
+        return std::nullopt;
+    }
+    return company_name_column;
+} // -----  end of function FindFormTypeColumnWidth  -----
+
+std::optional<std::vector<COL::sview>> FindFormTypeRanges(COL::sview index_records, std::size_t form_type_width,
+                                                          const std::vector<std::string> &form_types,
+                                                          const std::vector<std::string> &prefix_patterns)
+{
+    auto form_type_at = [form_type_width](COL::sview data, COL::sview::size_type line_start) {
+        return FormTypeFieldAt(data, line_start, form_type_width);
+    };
+
+    if (!std::ranges::is_sorted(SampleLineKeys(index_records, form_type_at)))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::pair<COL::sview::size_type, COL::sview::size_type>> ranges;
+
+    for (const auto &form_type : form_types)
+    {
+        auto first = FindFirstLineNotBefore(index_records, form_type_at,
+                                            [&form_type](auto key) { return key && *key < form_type; });
+        auto last = FindFirstLineNotBefore(index_records, form_type_at,
+                                           [&form_type](auto key) { return key && *key <= form_type; });
+        if (first < last)
+        {
+            ranges.emplace_back(first, last);
+        }
+    }
+
+    // all the form types starting with a prefix sort together right after
+    // the prefix itself.
+
+    for (const auto &prefix : prefix_patterns)
+    {
+        auto first = FindFirstLineNotBefore(index_records, form_type_at,
+                                            [&prefix](auto key) { return key && *key < prefix; });
+        auto last = FindFirstLineNotBefore(index_records, form_type_at, [&prefix](auto key) {
+            return key && (*key < prefix || key->starts_with(prefix));
+        });
+        if (first < last)
+        {
+            ranges.emplace_back(first, last);
+        }
+    }
+
+    return MergeRanges(index_records, ranges);
+} // -----  end of function FindFormTypeRanges  -----
+
+std::optional<std::chrono::sys_days> ParseIndexDate(COL::sview date_filed)
+{
+    // this gets called for every row when converting index files so we don't
+    // want to go through the stream based date parsing.
+
+    auto as_number = [date_filed](std::size_t pos, std::size_t len) -> std::optional<int> {
+        int result = 0;
+        const char *first = date_filed.data() + pos;
+        const auto [ptr, ec] = std::from_chars(first, first + len, result);
+        if (ec != std::errc{} || ptr != first + len)
+        {
+            return std::nullopt;
+        }
+        return result;
+    };
+
+    std::optional<int> year;
+    std::optional<int> month;
+    std::optional<int> day;
+
+    if (date_filed.size() == 10 && date_filed[4] == '-' && date_filed[7] == '-')
+    {
+        year = as_number(0, 4);
+        month = as_number(5, 2);
+        day = as_number(8, 2);
+    }
+    else if (date_filed.size() == 8)
+    {
+        year = as_number(0, 4);
+        month = as_number(4, 2);
+        day = as_number(6, 2);
+    }
+    if (!year || !month || !day)
+    {
+        return std::nullopt;
+    }
+
+    const std::chrono::year_month_day result{std::chrono::year{*year},
+                                             std::chrono::month{static_cast<unsigned>(*month)},
+                                             std::chrono::day{static_cast<unsigned>(*day)}};
+    if (!result.ok())
+    {
+        return std::nullopt;
+    }
+    return std::chrono::sys_days{result};
+} // -----  end of function ParseIndexDate  -----
+
+const char *FindFieldDelimiter(const char *first, const char *last)
+{
+    // look at a register's worth of bytes at a time and use the compare mask
+    // to find the first delimiter in the block.  Only full blocks are loaded so
+    // we never read past the end of the buffer.
+
+#if defined(__AVX2__)
+    const __m256i pipes_32 = _mm256_set1_epi8('|');
+    const __m256i new_lines_32 = _mm256_set1_epi8('\n');
+
+    for (; last - first >= 32; first += 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        const __m256i hits =
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, pipes_32), _mm256_cmpeq_epi8(block, new_lines_32));
+        if (const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(hits)); mask != 0)
+        {
+            return first + std::countr_zero(mask);
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i pipes_16 = _mm_set1_epi8('|');
+    const __m128i new_lines_16 = _mm_set1_epi8('\n');
+
+    for (; last - first >= 16; first += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, pipes_16), _mm_cmpeq_epi8(block, new_lines_16));
+        if (const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hits)); mask != 0)
+        {
+            return first + std::countr_zero(mask);
+        }
+    }
+#endif
+
+    // whatever is left (or everything, if no SIMD support)
+
+    return FindFieldDelimiterScalar(first, last);
+} // -----  end of function FindFieldDelimiter  -----
+
+const char *FindFieldDelimiterScalar(const char *first, const char *last)
+{
+    for (; first != last; ++first)
+    {
+        if (*first == '|' || *first == '\n')
+        {
+            return first;
+        }
+    }
+    return last;
+} // -----  end of function FindFieldDelimiterScalar  -----
+
+void BenchmarkIndexScan(std::size_t row_count)
+{
+    BOOST_ASSERT_MSG(row_count > 0, "Need rows to scan.");
+
+    // rows that look like a quarterly master index: CIKs in order and a mix
+    // of company name and file name lengths.
+
+    constexpr std::array<COL::sview, 6> form_types{"4", "8-K", "10-Q", "SC 13G/A", "424B2", "10-K"};
+
+    std::string index_data;
+    index_data.reserve(row_count * 100);
+    for (std::size_t row = 0; row < row_count; ++row)
+    {
+        const auto CIK = 1000 + row / 8;
+        std::format_to(std::back_inserter(index_data),
+                       "{}|{} HOLDINGS {}INC|{}|2024-{:02}-{:02}|edgar/data/{}/{:010}-24-{:06}.txt\n", CIK, row % 977,
+                       row % 3 == 0 ? "INTERNATIONAL " : "", form_types[row % form_types.size()], row % 3 + 1,
+                       row % 28 + 1, CIK, CIK, row);
+    }
+
+    for (const bool use_scalar : {true, false})
+    {
+        // best of a few runs so we see the scanner and not the first touch
+        // of the data.
+
+        std::chrono::duration<double> best_time{std::numeric_limits<double>::max()};
+        std::size_t records = 0;
+        for (int run = 0; run < 3; ++run)
+        {
+            const auto scan_start = std::chrono::steady_clock::now();
+
+            IndexRecordScanner scanner{index_data};
+            scanner.UseScalarDelimiterSearch(use_scalar);
+            IndexRecord record;
+            std::size_t file_name_bytes = 0;
+            while (scanner.NextRecord(record))
+            {
+                file_name_bytes += record.file_name.size();
+            }
+            best_time = std::min<std::chrono::duration<double>>(best_time,
+                                                                std::chrono::steady_clock::now() - scan_start);
+            records = scanner.GetRecordCount();
+            BOOST_ASSERT_MSG(file_name_bytes > 0, "Scanner found no file names.");
+        }
+        spdlog::info(std::format("P: {} delimiter search: {} rows ({} bytes) in {:.3f} seconds. {:.0f} rows/sec. "
+                                 "{:.1f} MB/s.",
+                                 use_scalar ? "Scalar" : "SIMD", records, index_data.size(), best_time.count(),
+                                 static_cast<double>(records) / best_time.count(),
+                                 static_cast<double>(index_data.size()) / (1024 * 1024) / best_time.count()));
+    }
+} // -----  end of function BenchmarkIndexScan  -----
@@ -0,0 +1,176 @@
+// =====================================================================================
+//
+//       Filename:  IndexRecordScanner.h
+//
+//    Description:  Streaming scanner for records in EDGAR master index files
+//
+//        Version:  1.0
+//        Created:  10/19/2026 10:02:51 AM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef INDEXRECORDSCANNER_H_
+#define INDEXRECORDSCANNER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Collector_Utils.h"
+
+// the fields of a data line in an index file.
+// master index data lines look like: CIK|Company Name|Form Type|Date Filed|File Name
+// form index data lines have the same fields in fixed width columns with the
+// form type first.
+// all fields are views into the scanned buffer.
+
+struct IndexRecord
+{
+    COL::sview CIK;
+    COL::sview company_name;
+    COL::sview form_type;
+    COL::sview date_filed;
+    COL::sview file_name;
+};
+
+// =====================================================================================
+//        Class:  IndexRecordScanner
+//  Description:  walks the data lines of an index file buffer and hands back
+//                each record's fields without building any intermediate
+//                containers.  Delimiters are located 16 or 32 bytes at a time
+//                when SSE2/AVX2 are available.
+// =====================================================================================
+class IndexRecordScanner
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    IndexRecordScanner() = delete;
+
+    // index_data should begin at the first data line.  See FindIndexDataStart.
+
+    explicit IndexRecordScanner(COL::sview index_data);
+
+    // for form index data.  See FindFormTypeColumnWidth.
+
+    IndexRecordScanner(COL::sview index_data, std::size_t form_type_width);
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] std::size_t GetRecordCount() const
+    {
+        return record_count_;
+    }
+
+    // ====================  MUTATORS      =======================================
+
+    // for comparing against the SIMD search.  See BenchmarkIndexScan.
+
+    void UseScalarDelimiterSearch(bool use_scalar_delimiter_search)
+    {
+        use_scalar_delimiter_search_ = use_scalar_delimiter_search;
+    }
+
+    // returns false when there are no more records.
+    // lines which do not have all 5 fields are skipped.
+
+    bool NextRecord(IndexRecord &record);
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    bool NextFixedWidthRecord(IndexRecord &record);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    const char *current_;
+    const char *end_;
+
+    std::size_t record_count_ = 0;
+    std::size_t form_type_width_ = 0; // 0 means '|' delimited master index data
+    bool use_scalar_delimiter_search_ = false;
+
+}; // -----  end of class IndexRecordScanner  -----
+
+// index files start with some descriptive header lines which end with a line of
+// dashes.  Returns the offset of the first data line or npos if there is no
+// such line.
+
+COL::sview::size_type FindIndexDataStart(COL::sview index_data);
+
+// break index data into (roughly) equal sized pieces which each end at a line
+// boundary so the pieces can be scanned independently.  May return fewer pieces
+// than asked for if the data is small.
+
+std::vector<COL::sview> SplitAtLineBoundaries(COL::sview index_data, std::size_t how_many);
+
+// master index files are in order by CIK.  Given the CIKs we want, find the
+// runs of lines for each of them with binary searches so we only touch the
+// parts of the index we need.  The returned ranges are in file order and may
+// include a few extra lines so records still need to be filtered.
+// Returns nothing if the data does not look to be in CIK order.  In that case,
+// just scan everything.
+
+std::optional<std::vector<COL::sview>> FindCIKRanges(COL::sview index_records, const std::vector<std::uint32_t> &CIKs);
+
+// form index files are sorted by form type and have fixed width columns.  The
+// header line just above the dashes tells us how wide the form type column is.
+// Returns nothing if this does not look like a form index.
+
+std::optional<std::size_t> FindFormTypeColumnWidth(COL::sview index_data, COL::sview::size_type data_start);
+
+// like FindCIKRanges but for form index files.  Finds the block of lines for
+// each form type and for each prefix pattern.  Returns nothing if the data
+// does not look to be in form type order.
+
+std::optional<std::vector<COL::sview>> FindFormTypeRanges(COL::sview index_records, std::size_t form_type_width,
+                                                          const std::vector<std::string> &form_types,
+                                                          const std::vector<std::string> &prefix_patterns);
+
+// the date filed field is 'YYYY-MM-DD' in quarterly index files and
+// 'YYYYMMDD' in daily index files.  Nothing if the text is neither.
+
+std::optional<std::chrono::sys_days> ParseIndexDate(COL::sview date_filed);
+
+// locate the first '|' or '\n' in [first, last).  Returns last if neither is
+// found.
+
+const char *FindFieldDelimiter(const char *first, const char *last);
+
+// same thing a byte at a time.
+
+const char *FindFieldDelimiterScalar(const char *first, const char *last);
+
+// makes up row_count rows of master index data and logs how fast the scanner
+// gets through them with the scalar and SIMD delimiter searches.
+
+void BenchmarkIndexScan(std::size_t row_count);
+
+#endif /* INDEXRECORDSCANNER_H_ */
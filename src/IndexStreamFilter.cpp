@@ -0,0 +1,197 @@
+// =====================================================================================
+//
+//       Filename:  IndexStreamFilter.cpp
+//
+//    Description:  Implements filtering of index file data while the index
+//                  file is downloading
+//
+//        Version:  1.0
+//        Created:  10/19/2026 07:12:26 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <format>
+#include <iterator>
+
+#include <spdlog/spdlog.h>
+
+#include "IndexRecordScanner.h"
+#include "IndexStreamFilter.h"
+
+//--------------------------------------------------------------------------------------
+//       Class:  IndexStreamFilter
+//      Method:  IndexStreamFilter
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+IndexStreamFilter::IndexStreamFilter(FormFileRetriever &form_file_retriever,
+                                     const std::vector<std::string> &the_form_types,
+                                     const TickerConverter::TickerCIKMap &ticker_map)
+    : form_file_retriever_{form_file_retriever},
+      the_form_types_{the_form_types},
+      ticker_map_{ticker_map},
+      form_matcher_{the_form_types},
+      cik_filter_{ticker_map}
+{
+} // -----  end of method IndexStreamFilter::IndexStreamFilter  (constructor)  -----
+
+IndexStreamFilter::~IndexStreamFilter()
+{
+    {
+        std::lock_guard<std::mutex> lock{blocks_mutex_};
+        no_more_blocks_ = true;
+    }
+    blocks_ready_.notify_one();
+} // -----  end of method IndexStreamFilter::~IndexStreamFilter  -----
+
+void IndexStreamFilter::AddData(COL::sview index_data)
+{
+    if (pending_data_.empty() && !found_data_start_)
+    {
+        first_data_time_ = std::chrono::steady_clock::now();
+    }
+    pending_data_.append(index_data);
+
+    if (!found_data_start_)
+    {
+        // only look at whole lines.  We may have just part of the line of
+        // dashes so far.
+
+        const auto last_line_end = pending_data_.rfind('\n');
+        if (last_line_end == std::string::npos)
+        {
+            return;
+        }
+        const COL::sview header{pending_data_.data(), last_line_end + 1};
+        const auto data_start = FindIndexDataStart(header);
+        if (data_start == COL::sview::npos)
+        {
+            return;
+        }
+
+        // form index files have fixed width columns.  master index files
+        // don't have the header this looks for.
+
+        form_type_width_ = FindFormTypeColumnWidth(header, data_start).value_or(0);
+        pending_data_.erase(0, data_start);
+        found_data_start_ = true;
+
+        filter_results_ = std::async(std::launch::async, &IndexStreamFilter::FilterBlocks, this);
+    }
+
+    if (pending_data_.size() >= k_block_size)
+    {
+        QueueWholeLines();
+    }
+} // -----  end of method IndexStreamFilter::AddData  -----
+
+void IndexStreamFilter::QueueWholeLines()
+{
+    const auto last_line_end = pending_data_.rfind('\n');
+    if (last_line_end == std::string::npos)
+    {
+        return;
+    }
+    std::string rest_of_data{pending_data_.substr(last_line_end + 1)};
+    pending_data_.resize(last_line_end + 1);
+    QueueBlock(std::exchange(pending_data_, std::move(rest_of_data)));
+} // -----  end of method IndexStreamFilter::QueueWholeLines  -----
+
+void IndexStreamFilter::QueueBlock(std::string block)
+{
+    {
+        std::lock_guard<std::mutex> lock{blocks_mutex_};
+        blocks_.push_back(std::move(block));
+    }
+    blocks_ready_.notify_one();
+} // -----  end of method IndexStreamFilter::QueueBlock  -----
+
+std::pair<FilingPlan, std::size_t> IndexStreamFilter::FilterBlocks()
+{
+    FilingPlan results;
+
+    std::size_t record_count{0};
+    while (true)
+    {
+        std::string block;
+        {
+            std::unique_lock<std::mutex> lock{blocks_mutex_};
+            blocks_ready_.wait(lock, [this] { return !blocks_.empty() || no_more_blocks_; });
+            if (blocks_.empty())
+            {
+                break;
+            }
+            block = std::move(blocks_.front());
+            blocks_.pop_front();
+        }
+
+        // blocks arrive in file order so just add them to the end.
+
+        auto [block_files, block_records] =
+            form_file_retriever_.FilterIndexRecords(block, form_matcher_, cik_filter_, form_type_width_);
+        results.Append(block_files);
+        record_count += block_records;
+    }
+    return {std::move(results), record_count};
+} // -----  end of method IndexStreamFilter::FilterBlocks  -----
+
+FilingPlan IndexStreamFilter::Finish(const fs::path &local_index_file_name)
+{
+    if (!found_data_start_)
+    {
+        spdlog::debug(catenate("F: No index data streamed for: ", local_index_file_name.string(),
+                               ". Searching local file."));
+        return form_file_retriever_.FindFilesForForms(the_form_types_, local_index_file_name, ticker_map_);
+    }
+
+    const auto download_done_time = std::chrono::steady_clock::now();
+
+    // the last line may not have a newline.
+
+    if (!pending_data_.empty())
+    {
+        QueueBlock(std::move(pending_data_));
+        pending_data_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock{blocks_mutex_};
+        no_more_blocks_ = true;
+    }
+    blocks_ready_.notify_one();
+
+    auto [results, record_count] = filter_results_.get();
+
+    const std::chrono::duration<double> stream_time = download_done_time - first_data_time_;
+    const std::chrono::duration<double> wait_time = std::chrono::steady_clock::now() - download_done_time;
+
+    spdlog::debug(std::format("F: Streamed index file: {} has: {} rows. Filtered while downloading for {:.3f} "
+                              "seconds then waited {:.3f} seconds for the rest.",
+                              local_index_file_name, record_count, stream_time.count(), wait_time.count()));
+
+    results.SortByFormType();
+
+    spdlog::debug(catenate("F: Found a total of ", results.GetFilingCount(), " files for specified forms: ",
+                           the_form_types_));
+    return std::move(results);
+} // -----  end of method IndexStreamFilter::Finish  -----
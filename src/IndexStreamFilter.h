@@ -0,0 +1,156 @@
+// =====================================================================================
+//
+//       Filename:  IndexStreamFilter.h
+//
+//    Description:  Filters index file data for the forms we want while the
+//                  index file is downloading
+//
+//        Version:  1.0
+//        Created:  10/19/2026 07:05:52 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef INDEXSTREAMFILTER_H_
+#define INDEXSTREAMFILTER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CIKFilter.h"
+#include "Collector_Utils.h"
+#include "FormFileRetriever.h"
+#include "FormTypeMatcher.h"
+#include "TickerConverter.h"
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  IndexStreamFilter
+//  Description:  does the same search as FormFileRetriever::FindFilesForForms
+//                but on index data as it is downloaded instead of on the
+//                local file afterwards.
+//
+//                The downloader hands us the data as it arrives.  Once we
+//                have found the start of the index entries, whole lines are
+//                passed in blocks to a worker thread which filters them while
+//                the download continues.  When the download is done, only
+//                the last block is left to filter.
+//
+//                If no data was given to us (the index file was already here
+//                or came in a zip archive), Finish searches the local file.
+// =====================================================================================
+class IndexStreamFilter
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    IndexStreamFilter() = delete;
+
+    // the retriever's date filter and the ticker map are used as they are when
+    // Finish is called so they need to live until then.
+
+    IndexStreamFilter(FormFileRetriever &form_file_retriever,
+                      const std::vector<std::string> &the_form_types,
+                      const TickerConverter::TickerCIKMap &ticker_map);
+
+    IndexStreamFilter(const IndexStreamFilter &rhs) = delete;
+    IndexStreamFilter(IndexStreamFilter &&rhs) = delete;
+
+    // if the download failed part way through, we need to stop our worker.
+
+    ~IndexStreamFilter();
+
+    // ====================  ACCESSORS     =======================================
+
+    // ====================  MUTATORS      =======================================
+
+    IndexStreamFilter &operator=(const IndexStreamFilter &rhs) = delete;
+    IndexStreamFilter &operator=(IndexStreamFilter &&rhs) = delete;
+
+    // give this to the downloader.
+
+    void AddData(COL::sview index_data);
+
+    // ====================  OPERATORS     =======================================
+
+    // call when the download is done.
+
+    FilingPlan Finish(const fs::path &local_index_file_name);
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // pass along everything up to the last complete line.
+
+    void QueueWholeLines();
+    void QueueBlock(std::string block);
+
+    // runs on the worker thread.
+
+    std::pair<FilingPlan, std::size_t> FilterBlocks();
+
+    // ====================  DATA MEMBERS  =======================================
+
+    // daily index files are generally a few MB so this gives the worker a
+    // handful of blocks to do while the rest arrives.
+
+    static constexpr std::size_t k_block_size = 256 * 1024;
+
+    FormFileRetriever &form_file_retriever_;
+    const std::vector<std::string> &the_form_types_;
+    const TickerConverter::TickerCIKMap &ticker_map_;
+
+    FormTypeMatcher form_matcher_;
+    CIKFilter cik_filter_;
+
+    // data we have received but not yet passed along.  Before we find the
+    // start of the index entries this is the header.
+
+    std::string pending_data_;
+    std::size_t form_type_width_ = 0;
+    bool found_data_start_ = false;
+
+    std::chrono::steady_clock::time_point first_data_time_;
+
+    std::mutex blocks_mutex_;
+    std::condition_variable blocks_ready_;
+    std::deque<std::string> blocks_;
+    bool no_more_blocks_ = false;
+
+    // last so the worker is done before the things it uses go away.
+
+    std::future<std::pair<FilingPlan, std::size_t>> filter_results_;
+
+}; // -----  end of class IndexStreamFilter  -----
+
+#endif /* INDEXSTREAMFILTER_H_ */
@@ -0,0 +1,145 @@
+// =====================================================================================
+//
+//       Filename:  MemoryMappedFile.cpp
+//
+//    Description:  Implements read-only memory mapped view of a data file
+//
+//        Version:  1.0
+//        Created:  10/19/2026 09:20:13 AM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Collector_Utils.h"
+#include "MemoryMappedFile.h"
+
+//--------------------------------------------------------------------------------------
+//       Class:  MemoryMappedFile
+//      Method:  MemoryMappedFile
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+MemoryMappedFile::MemoryMappedFile(const fs::path &file_name, AccessPattern access_pattern) : file_name_{file_name}
+{
+    int fd = ::open(file_name_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't open data file: ", file_name_.string())};
+    }
+
+    struct stat file_info;
+    if (::fstat(fd, &file_info) == -1)
+    {
+        std::error_code err{errno, std::system_category()};
+        ::close(fd);
+        throw std::system_error{err, catenate("Can't get size of data file: ", file_name_.string())};
+    }
+
+    // mmap will not map an empty file.  Just leave ourselves with an empty view.
+
+    if (file_info.st_size > 0)
+    {
+        size_ = static_cast<std::size_t>(file_info.st_size);
+        void *mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            std::error_code err{errno, std::system_category()};
+            ::close(fd);
+            throw std::system_error{err, catenate("Can't map data file: ", file_name_.string())};
+        }
+        data_ = static_cast<const char *>(mapped);
+
+        Advise(access_pattern);
+    }
+
+    // the mapping stays valid after the descriptor is closed.
+
+    ::close(fd);
+} // -----  end of method MemoryMappedFile::MemoryMappedFile  (constructor)  -----
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile &&rhs) noexcept
+    : file_name_{std::move(rhs.file_name_)}, data_{std::exchange(rhs.data_, nullptr)},
+      size_{std::exchange(rhs.size_, 0)}
+{
+} // -----  end of method MemoryMappedFile::MemoryMappedFile  (move constructor)  -----
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    Unmap();
+} // -----  end of method MemoryMappedFile::~MemoryMappedFile  (destructor)  -----
+
+MemoryMappedFile &MemoryMappedFile::operator=(MemoryMappedFile &&rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        Unmap();
+        file_name_ = std::move(rhs.file_name_);
+        data_ = std::exchange(rhs.data_, nullptr);
+        size_ = std::exchange(rhs.size_, 0);
+    }
+    return *this;
+} // -----  end of method MemoryMappedFile::operator=  -----
+
+void MemoryMappedFile::Advise(AccessPattern access_pattern) const
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+
+    // these are hints only so we ignore failures.
+
+    auto *mapped = const_cast<char *>(data_);
+    if (access_pattern == AccessPattern::sequential)
+    {
+        // we scan our data files front to back so let the kernel know it can
+        // read ahead aggressively.
+
+        ::madvise(mapped, size_, MADV_SEQUENTIAL);
+        ::madvise(mapped, size_, MADV_WILLNEED);
+    }
+    else
+    {
+        ::madvise(mapped, size_, MADV_RANDOM);
+    }
+} // -----  end of method MemoryMappedFile::Advise  -----
+
+void MemoryMappedFile::Unmap()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<char *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+} // -----  end of method MemoryMappedFile::Unmap  -----
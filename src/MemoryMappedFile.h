@@ -0,0 +1,109 @@
+// =====================================================================================
+//
+//       Filename:  MemoryMappedFile.h
+//
+//    Description:  Read-only memory mapped view of a data file
+//
+//        Version:  1.0
+//        Created:  10/19/2026 09:12:40 AM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef MEMORYMAPPEDFILE_H_
+#define MEMORYMAPPEDFILE_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  MemoryMappedFile
+//  Description:  maps an entire file read-only and exposes it as a string_view.
+//                Index files can be hundreds of MB so this lets us parse them
+//                in place instead of copying them into a string first.
+// =====================================================================================
+class MemoryMappedFile
+{
+public:
+    // tells the kernel how we expect to touch the data.  'sequential' reads
+    // ahead aggressively, 'random' only faults in the pages we look at.
+
+    enum class AccessPattern
+    {
+        sequential,
+        random
+    };
+
+    // ====================  LIFECYCLE     =======================================
+
+    MemoryMappedFile() = delete;
+    explicit MemoryMappedFile(const fs::path &file_name, AccessPattern access_pattern = AccessPattern::sequential);
+    MemoryMappedFile(const MemoryMappedFile &rhs) = delete;
+    MemoryMappedFile(MemoryMappedFile &&rhs) noexcept;
+
+    ~MemoryMappedFile();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] std::string_view GetView() const
+    {
+        return {data_, size_};
+    }
+    [[nodiscard]] std::size_t GetSize() const
+    {
+        return size_;
+    }
+    [[nodiscard]] const fs::path &GetFileName() const
+    {
+        return file_name_;
+    }
+
+    // ====================  MUTATORS      =======================================
+
+    MemoryMappedFile &operator=(const MemoryMappedFile &rhs) = delete;
+    MemoryMappedFile &operator=(MemoryMappedFile &&rhs) noexcept;
+
+    // change our mind about how the data will be accessed.
+
+    void Advise(AccessPattern access_pattern) const;
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    void Unmap();
+
+    // ====================  DATA MEMBERS  =======================================
+
+    fs::path file_name_;
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+
+}; // -----  end of class MemoryMappedFile  -----
+
+#endif /* MEMORYMAPPEDFILE_H_ */
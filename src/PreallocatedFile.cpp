@@ -0,0 +1,191 @@
+// =====================================================================================
+//
+//       Filename:  PreallocatedFile.cpp
+//
+//    Description:  Writes a downloaded file into space reserved for it up
+//                  front so it ends up in a few large extents
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:59 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Collector_Utils.h"
+#include "PreallocatedFile.h"
+
+namespace
+{
+// smaller files are written in one go or close to it and the file system
+// keeps them together on its own.
+
+constexpr std::uint64_t k_min_preallocated_size = 1024 * 1024;
+
+// big files are written this much at a time, at offsets that are multiples
+// of it.
+
+constexpr std::size_t k_large_write_size = 1024 * 1024;
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  PreallocatedFile
+//      Method:  PreallocatedFile
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+PreallocatedFile::PreallocatedFile(const fs::path &file_name, std::uint64_t expected_size) : file_name_{file_name}
+{
+    fd_ = ::open(file_name_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd_ == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Unable to open file: ", file_name_.string())};
+    }
+
+    if (expected_size < k_min_preallocated_size)
+    {
+        return;
+    }
+
+    // reserving the space is a nicety.  File systems which can't do it
+    // (EOPNOTSUPP) just get the writes.  If there really isn't room, the
+    // writes will tell us.  Keep the size as is so the file is only ever as
+    // long as what we have written.
+
+    if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(expected_size)) == 0)
+    {
+        preallocated_size_ = expected_size;
+    }
+    write_buffer_.resize(k_large_write_size);
+} // -----  end of method PreallocatedFile::PreallocatedFile  (constructor)  -----
+
+PreallocatedFile::~PreallocatedFile()
+{
+    if (fd_ != -1)
+    {
+        ::close(fd_);
+    }
+} // -----  end of method PreallocatedFile::~PreallocatedFile  (destructor)  -----
+
+void PreallocatedFile::Write(std::string_view data)
+{
+    BOOST_ASSERT_MSG(fd_ != -1, "Writing to a closed file.");
+
+    if (write_buffer_.empty())
+    {
+        WriteToFile(data.data(), data.size());
+        return;
+    }
+
+    // top up what we have.
+
+    if (buffered_size_ > 0)
+    {
+        const auto to_copy = std::min(data.size(), write_buffer_.size() - buffered_size_);
+        std::memcpy(write_buffer_.data() + buffered_size_, data.data(), to_copy);
+        buffered_size_ += to_copy;
+        data.remove_prefix(to_copy);
+
+        if (buffered_size_ < write_buffer_.size())
+        {
+            return;
+        }
+        WriteToFile(write_buffer_.data(), buffered_size_);
+        buffered_size_ = 0;
+    }
+
+    // whole pieces can go straight from the caller's data.  We are at a
+    // multiple of the write size here.
+
+    if (const auto whole_pieces = data.size() - data.size() % write_buffer_.size(); whole_pieces > 0)
+    {
+        WriteToFile(data.data(), whole_pieces);
+        data.remove_prefix(whole_pieces);
+    }
+
+    if (!data.empty())
+    {
+        std::memcpy(write_buffer_.data(), data.data(), data.size());
+        buffered_size_ = data.size();
+    }
+} // -----  end of method PreallocatedFile::Write  -----
+
+void PreallocatedFile::Close()
+{
+    if (fd_ == -1)
+    {
+        return;
+    }
+
+    if (buffered_size_ > 0)
+    {
+        WriteToFile(write_buffer_.data(), buffered_size_);
+        buffered_size_ = 0;
+    }
+
+    // a short file still has the rest of its reserved space past its end.
+    // Truncating to its own size gives that back.
+
+    if (bytes_written_ < preallocated_size_ && ::ftruncate(fd_, static_cast<off_t>(bytes_written_)) == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Unable to trim file: ", file_name_.string(), " to: ", bytes_written_)};
+    }
+
+    const int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Unable to close file: ", file_name_.string())};
+    }
+} // -----  end of method PreallocatedFile::Close  -----
+
+void PreallocatedFile::WriteToFile(const char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const auto written = ::write(fd_, data, size);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error{std::error_code{errno, std::system_category()},
+                                    catenate("Unable to write file: ", file_name_.string())};
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        bytes_written_ += static_cast<std::uint64_t>(written);
+    }
+} // -----  end of method PreallocatedFile::WriteToFile  -----
@@ -0,0 +1,134 @@
+// =====================================================================================
+//
+//       Filename:  PreallocatedFile.h
+//
+//    Description:  Writes a downloaded file into space reserved for it up
+//                  front so it ends up in a few large extents
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:59 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef PREALLOCATEDFILE_H_
+#define PREALLOCATEDFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  PreallocatedFile
+//  Description:  creates or replaces a file we are about to write front to
+//                back.
+//
+//                Big files (zipped notes, full 10-K submissions) arrive a
+//                chunk at a time while other downloads are writing too, so
+//                the file system hands out space a little at a time and the
+//                file ends up in pieces all over the disk.  Reading it back
+//                later is slower for it.
+//
+//                When we are told about how big the file will be (a
+//                Content-Length, the size recorded in a zip archive) and it
+//                is big enough to matter, the space is reserved with
+//                fallocate before anything is written and the data is
+//                written in large, aligned pieces.  Reserving the space
+//                doesn't change the file's size so a download which fails
+//                part way never leaves a file padded out with zeros.  The
+//                size is only a hint.  Less or more than expected is fine
+//                too.
+// =====================================================================================
+class PreallocatedFile
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    PreallocatedFile() = delete;
+
+    // expected_size is 0 if we have no idea.
+
+    PreallocatedFile(const fs::path &file_name, std::uint64_t expected_size);
+
+    PreallocatedFile(const PreallocatedFile &rhs) = delete;
+    PreallocatedFile(PreallocatedFile &&rhs) = delete;
+
+    // closes the file if Close wasn't called.  Doesn't remove it.  That's up
+    // to the caller.
+
+    ~PreallocatedFile();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] std::uint64_t GetBytesWritten() const
+    {
+        return bytes_written_ + buffered_size_;
+    }
+    [[nodiscard]] bool IsPreallocated() const
+    {
+        return preallocated_size_ > 0;
+    }
+
+    // ====================  MUTATORS      =======================================
+
+    PreallocatedFile &operator=(const PreallocatedFile &rhs) = delete;
+    PreallocatedFile &operator=(PreallocatedFile &&rhs) = delete;
+
+    // appends data.  Throws a system_error if it can't be written.
+
+    void Write(std::string_view data);
+
+    // writes whatever is still buffered, gives back any space reserved but
+    // not used and closes the file.  Throws a system_error if any of that fails.
+
+    void Close();
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    void WriteToFile(const char *data, std::size_t size);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    fs::path file_name_;
+    int fd_ = -1;
+
+    std::uint64_t preallocated_size_ = 0;
+    std::uint64_t bytes_written_ = 0;
+
+    // only used for big files.  Empty otherwise and writes go straight to
+    // the file.
+
+    std::vector<char> write_buffer_;
+    std::size_t buffered_size_ = 0;
+
+}; // -----  end of class PreallocatedFile  -----
+
+#endif /* PREALLOCATEDFILE_H_ */
@@ -35,6 +35,7 @@
 #include <spdlog/spdlog.h>
 
 #include "Collector_Utils.h"
+#include "DownloadManifest.h"
 #include "HTTPS_Downloader.h"
 #include "PathNameGenerator.h"
 #include "QuarterlyIndexFileRetriever.h"
@@ -45,8 +46,9 @@
 // Description:  constructor
 //--------------------------------------------------------------------------------------
 QuarterlyIndexFileRetriever::QuarterlyIndexFileRetriever(const std::string &host, const std::string &port,
-                                                         const fs::path &prefix)
-    : host_{host}, port_{port}, remote_directory_prefix_{prefix}
+                                                         const fs::path &prefix, COL::IndexFileType index_file_type)
+    : host_{host}, port_{port}, remote_directory_prefix_{prefix},
+      index_file_base_name_{COL::IndexFileBaseName(index_file_type)}
 {
 } // -----  end of method
   // QuarterlyIndexFileRetriever::QuarterlyIndexFileRetriever  (constructor)
@@ -64,12 +66,25 @@ std::chrono::year_month_day QuarterlyIndexFileRetriever::CheckDate(std::chrono::
     return day_in_quarter;
 } // -----  end of method QuarterlyIndexFileRetriever::CheckDate  -----
 
+bool QuarterlyIndexFileRetriever::HaveLocalFile(const fs::path &local_file_name) const
+{
+    return download_manifest_ != nullptr ? download_manifest_->HasFile(local_file_name) : fs::exists(local_file_name);
+} // -----  end of method QuarterlyIndexFileRetriever::HaveLocalFile  -----
+
+void QuarterlyIndexFileRetriever::RecordLocalFile(const fs::path &local_file_name)
+{
+    if (download_manifest_ != nullptr)
+    {
+        download_manifest_->RecordFile(local_file_name);
+    }
+} // -----  end of method QuarterlyIndexFileRetriever::RecordLocalFile  -----
+
 fs::path QuarterlyIndexFileRetriever::MakeQuarterlyIndexPathName(std::chrono::year_month_day day_in_quarter)
 {
     input_date_ = CheckDate(day_in_quarter);
 
     auto remote_quarterly_index_file_name = GeneratePath(remote_directory_prefix_, day_in_quarter);
-    remote_quarterly_index_file_name /= "master.zip"; // we know this.
+    remote_quarterly_index_file_name /= index_file_base_name_ + ".zip"; // we know this.
 
     return remote_quarterly_index_file_name;
 
@@ -78,11 +93,12 @@ fs::path QuarterlyIndexFileRetriever::MakeQuarterlyIndexPathName(std::chrono::ye
 
 fs::path QuarterlyIndexFileRetriever::HierarchicalCopyRemoteIndexFileTo(const fs::path &remote_file_name,
                                                                         const fs::path &local_directory_name,
-                                                                        bool replace_files)
+                                                                        bool replace_files,
+                                                                        const HTTPS_Downloader::DataHandler &handle_data)
 {
     auto local_quarterly_index_file_name = this->MakeLocalIndexFilePath(local_directory_name, remote_file_name);
 
-    if (!replace_files && fs::exists(local_quarterly_index_file_name))
+    if (!replace_files && HaveLocalFile(local_quarterly_index_file_name))
     {
         spdlog::info(catenate("Q: File exists and 'replace' is false: skipping download: ",
                               local_quarterly_index_file_name.filename().string()));
@@ -93,7 +109,15 @@ fs::path QuarterlyIndexFileRetriever::HierarchicalCopyRemoteIndexFileTo(const fs
     fs::create_directories(local_quarterly_index_file_directory);
 
     HTTPS_Downloader the_server(host_, port_);
-    the_server.DownloadFile(remote_file_name, local_quarterly_index_file_name);
+    if (handle_data)
+    {
+        the_server.DownloadAndProcessFile(remote_file_name, local_quarterly_index_file_name, handle_data);
+    }
+    else
+    {
+        the_server.DownloadFile(remote_file_name, local_quarterly_index_file_name);
+    }
+    RecordLocalFile(local_quarterly_index_file_name);
 
     spdlog::info(catenate("Q: Retrieved remote quarterly index file: ", remote_file_name.string(),
                           " to: ", local_quarterly_index_file_name.string()));
@@ -140,7 +164,7 @@ std::vector<fs::path> QuarterlyIndexFileRetriever::MakeIndexFileNamesForDateRang
 
     std::transform(std::begin(range), std::end(range), std::back_inserter(results), [this](const auto &qtr_begin) {
         auto remote_file_name = GeneratePath(this->remote_directory_prefix_, qtr_begin);
-        return (std::move(remote_file_name /= "master.zip"));
+        return (std::move(remote_file_name /= this->index_file_base_name_ + ".zip"));
     });
 
     return results;
@@ -173,7 +197,7 @@ auto QuarterlyIndexFileRetriever::AddToCopyList(const fs::path &local_directory_
     return [this, local_directory_name, replace_files](const auto &remote_file_name) {
         auto local_quarterly_index_file_name = this->MakeLocalIndexFilePath(local_directory_name, remote_file_name);
 
-        if (!replace_files && fs::exists(local_quarterly_index_file_name))
+        if (!replace_files && HaveLocalFile(local_quarterly_index_file_name))
         {
             // we use an empty remote file name to indicate no copy needed as the
             // local file already exists.
@@ -211,7 +235,9 @@ std::vector<fs::path> QuarterlyIndexFileRetriever::ConcurrentlyHierarchicalCopyI
     // now, we expect some magic to happen here...
 
     HTTPS_Downloader the_server(host_, port_);
-    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(concurrent_copy_list, max_at_a_time);
+    auto [success_counter, error_counter] = the_server.DownloadFilesConcurrently(
+        concurrent_copy_list, max_at_a_time,
+        [this](const fs::path &local_file_name, const std::string &) { RecordLocalFile(local_file_name); });
 
     // if the first file name in the pair is empty, there was no download done.
 
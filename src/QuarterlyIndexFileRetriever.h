@@ -39,8 +39,13 @@
 #include <string>
 #include <vector>
 
+#include "Collector_Utils.h"
+#include "HTTPS_Downloader.h"
+
 namespace fs = std::filesystem;
 
+class DownloadManifest;
+
 // =====================================================================================
 //        Class:  QuarterlyIndexFileRetriever
 //  Description:
@@ -50,8 +55,8 @@ class QuarterlyIndexFileRetriever
 public:
     // ====================  LIFECYCLE     =======================================
     QuarterlyIndexFileRetriever() = delete;
-    QuarterlyIndexFileRetriever(const std::string &host, const std::string &port,
-                                const fs::path &prefix); // constructor
+    QuarterlyIndexFileRetriever(const std::string &host, const std::string &port, const fs::path &prefix,
+                                COL::IndexFileType index_file_type = COL::IndexFileType::master); // constructor
 
     ~QuarterlyIndexFileRetriever() = default;
 
@@ -65,10 +70,23 @@ public:
     QuarterlyIndexFileRetriever &operator=(const QuarterlyIndexFileRetriever &rhs) = delete;
     QuarterlyIndexFileRetriever &operator=(QuarterlyIndexFileRetriever &&rhs) = delete;
 
+    // decide which index files we already have from the manifest instead of
+    // looking in the file system.  Downloads are recorded in it.
+
+    void UseDownloadManifest(DownloadManifest *download_manifest)
+    {
+        download_manifest_ = download_manifest;
+    }
+
     fs::path MakeQuarterlyIndexPathName(std::chrono::year_month_day day_in_quarter);
+
+    // if handle_data is given, the index data is also passed to it as it
+    // downloads.  See HTTPS_Downloader::DownloadAndProcessFile.
+
     fs::path HierarchicalCopyRemoteIndexFileTo(const fs::path &remote_file_name,
                                                const fs::path &local_directory_name,
-                                               bool replace_files = false);
+                                               bool replace_files = false,
+                                               const HTTPS_Downloader::DataHandler &handle_data = {});
 
     //	This method treats the date range as a closed interval.
 
@@ -90,6 +108,9 @@ protected:
     // ====================  DATA MEMBERS  =======================================
 
 private:
+    [[nodiscard]] bool HaveLocalFile(const fs::path &local_file_name) const;
+    void RecordLocalFile(const fs::path &local_file_name);
+
     auto AddToCopyList(const fs::path &local_directory_name, bool replace_files);
 
     // ====================  DATA MEMBERS  =======================================
@@ -102,6 +123,10 @@ private:
     std::string host_;
     std::string port_;
 
+    std::string index_file_base_name_; // 'master' or 'form'
+
+    DownloadManifest *download_manifest_ = nullptr;
+
 }; // -----  end of class QuarterlyIndexFileRetriever  -----
 
 #endif /* QUARTERLYINDEXFILERETRIEVER_H_ */
@@ -0,0 +1,313 @@
+// =====================================================================================
+//
+//       Filename:  QueryResultCache.cpp
+//
+//    Description:  Implements saved results of searching an index file with a
+//                  given filter
+//
+//        Version:  1.0
+//        Created:  10/19/2026 06:20:31 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryFileUtils.h"
+#include "CIKFilter.h"
+#include "Collector_Utils.h"
+#include "FormTypeMatcher.h"
+#include "MemoryMappedFile.h"
+#include "QueryResultCache.h"
+
+// the file starts with this header.  Each section starts on an 8 byte
+// boundary.
+//
+//  filter key          char[filter_key_size]
+//  form type offsets   uint64[form_count + 1]
+//  form types          char[form_types_size]
+//  filings             FilingPlan::Filing[filing_count]
+//  file names          char[file_names_size]
+//
+// which is just the filing plan's own data so loading it is a few copies.
+
+namespace
+{
+constexpr std::array<char, 8> k_magic{'C', 'O', 'L', 'Q', 'R', 'Y', '0', '2'};
+constexpr std::uint32_t k_version = 2;
+
+struct QueryResultHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t form_count;
+    std::uint64_t filing_count;
+    std::uint64_t source_size;
+    std::int64_t source_mtime;
+    std::uint64_t filter_key_size;
+    std::uint64_t form_types_size;
+    std::uint64_t file_names_size;
+};
+static_assert(sizeof(QueryResultHeader) == 64);
+static_assert(sizeof(FilingPlan::Filing) == 20);
+
+struct QueryResultLayout
+{
+    std::size_t filter_key;
+    std::size_t form_type_offsets;
+    std::size_t form_types;
+    std::size_t filings;
+    std::size_t file_names;
+    std::size_t total_size;
+};
+
+QueryResultLayout ComputeLayout(const QueryResultHeader &header)
+{
+    QueryResultLayout layout;
+    layout.filter_key = AlignUp(sizeof(QueryResultHeader));
+    layout.form_type_offsets = AlignUp(layout.filter_key + header.filter_key_size);
+    layout.form_types = AlignUp(layout.form_type_offsets + (header.form_count + 1) * sizeof(std::uint64_t));
+    layout.filings = AlignUp(layout.form_types + header.form_types_size);
+    layout.file_names = AlignUp(layout.filings + header.filing_count * sizeof(FilingPlan::Filing));
+    layout.total_size = layout.file_names + header.file_names_size;
+    return layout;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  QueryResultCache
+//      Method:  QueryResultCache
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+QueryResultCache::QueryResultCache(const fs::path &index_file_name,
+                                   const FormTypeMatcher &form_matcher,
+                                   const CIKFilter &cik_filter,
+                                   std::optional<std::chrono::sys_days> first_date_filed,
+                                   std::optional<std::chrono::sys_days> last_date_filed)
+    : filter_key_{MakeFilterKey(form_matcher, cik_filter, first_date_filed, last_date_filed)},
+      source_size_{fs::file_size(index_file_name)},
+      source_mtime_{FileModificationTime(index_file_name)}
+{
+    cache_file_name_ = MakeCacheFileName(index_file_name, filter_key_);
+} // -----  end of method QueryResultCache::QueryResultCache  (constructor)  -----
+
+std::optional<FilingPlan> QueryResultCache::Load() const
+{
+    if (!fs::exists(cache_file_name_))
+    {
+        return {};
+    }
+
+    const MemoryMappedFile cache_file{cache_file_name_};
+    const auto data = cache_file.GetView();
+
+    if (data.size() < sizeof(QueryResultHeader))
+    {
+        throw std::runtime_error(catenate("Query result file: ", cache_file_name_.string(), " is too short."));
+    }
+
+    QueryResultHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != k_magic || header.version != k_version)
+    {
+        throw std::runtime_error(
+            catenate("File: ", cache_file_name_.string(), " is not a version ", k_version, " query result file."));
+    }
+
+    const auto layout = ComputeLayout(header);
+    if (layout.total_size != data.size())
+    {
+        throw std::runtime_error(
+            catenate("Query result file: ", cache_file_name_.string(), " has the wrong size for its contents."));
+    }
+
+    if (header.source_size != source_size_ || header.source_mtime != source_mtime_)
+    {
+        spdlog::debug(catenate("R: Query result file: ", cache_file_name_.string(), " is out of date."));
+        return {};
+    }
+
+    // the file name comes from a hash of the key so make sure this really is
+    // our filter.
+
+    if (data.substr(layout.filter_key, header.filter_key_size) != filter_key_)
+    {
+        spdlog::debug(catenate("R: Query result file: ", cache_file_name_.string(), " is for a different filter."));
+        return {};
+    }
+
+    const std::span<const std::uint64_t> form_type_offsets{
+        reinterpret_cast<const std::uint64_t *>(data.data() + layout.form_type_offsets), header.form_count + 1};
+    const auto form_types = data.substr(layout.form_types, header.form_types_size);
+
+    if (!std::ranges::is_sorted(form_type_offsets) || form_type_offsets.back() != form_types.size())
+    {
+        throw std::runtime_error(catenate("Query result file: ", cache_file_name_.string(), " is damaged."));
+    }
+
+    std::vector<std::string> form_type_list;
+    form_type_list.reserve(header.form_count);
+    for (std::size_t i = 0; i < header.form_count; ++i)
+    {
+        form_type_list.emplace_back(
+            form_types.substr(form_type_offsets[i], form_type_offsets[i + 1] - form_type_offsets[i]));
+    }
+
+    std::vector<FilingPlan::Filing> filings(header.filing_count);
+    std::memcpy(filings.data(), data.data() + layout.filings, header.filing_count * sizeof(FilingPlan::Filing));
+
+    // the plan checks its filings against the form types and file names.
+
+    try
+    {
+        return FilingPlan{std::move(form_type_list), std::move(filings),
+                          std::string{data.substr(layout.file_names, header.file_names_size)}};
+    }
+    catch (const std::runtime_error &e)
+    {
+        throw std::runtime_error(catenate("Query result file: ", cache_file_name_.string(), " is damaged: ", e.what()));
+    }
+} // -----  end of method QueryResultCache::Load  -----
+
+void QueryResultCache::Save(const FilingPlan &results) const
+{
+    QueryResultHeader header{};
+    header.magic = k_magic;
+    header.version = k_version;
+    header.form_count = static_cast<std::uint32_t>(results.GetFormTypes().size());
+    header.filing_count = results.GetFilingCount();
+    header.source_size = source_size_;
+    header.source_mtime = source_mtime_;
+    header.filter_key_size = filter_key_.size();
+    header.file_names_size = results.GetFileNames().size();
+
+    std::vector<std::uint64_t> form_type_offsets{0};
+    std::string form_types;
+
+    for (const auto &form : results.GetFormTypes())
+    {
+        form_types.append(form);
+        form_type_offsets.push_back(form_types.size());
+    }
+    header.form_types_size = form_types.size();
+
+    const auto temp_file_name = MakeTempFileName(cache_file_name_);
+
+    {
+        std::ofstream output{temp_file_name, std::ios::out | std::ios::binary | std::ios::trunc};
+        if (!output.is_open())
+        {
+            throw std::runtime_error(catenate("Unable to open query result file: ", temp_file_name.string()));
+        }
+
+        WriteSection(output, &header, 1);
+        WriteSection(output, filter_key_.data(), filter_key_.size());
+        WriteSection(output, form_type_offsets.data(), form_type_offsets.size());
+        WriteSection(output, form_types.data(), form_types.size());
+        WriteSection(output, results.GetFilings().data(), results.GetFilingCount());
+        output.write(results.GetFileNames().data(), static_cast<std::streamsize>(header.file_names_size));
+
+        output.close();
+        if (output.fail())
+        {
+            fs::remove(temp_file_name);
+            throw std::runtime_error(catenate("Unable to write query result file: ", temp_file_name.string()));
+        }
+    }
+    fs::rename(temp_file_name, cache_file_name_);
+
+    spdlog::debug(catenate("R: Saved ", header.filing_count, " filings for ", header.form_count,
+                           " forms to query result file: ", cache_file_name_.string()));
+} // -----  end of method QueryResultCache::Save  -----
+
+std::string QueryResultCache::MakeFilterKey(const FormTypeMatcher &form_matcher,
+                                            const CIKFilter &cik_filter,
+                                            std::optional<std::chrono::sys_days> first_date_filed,
+                                            std::optional<std::chrono::sys_days> last_date_filed)
+{
+    // the matcher keeps its forms and patterns sorted and de-duplicated and
+    // the filter does the same for its CIKs.
+
+    std::string filter_key{"forms="};
+    for (const auto &form : form_matcher.GetExactForms())
+    {
+        filter_key += form;
+        filter_key += ',';
+    }
+    for (const auto &pattern : form_matcher.GetPrefixPatterns())
+    {
+        filter_key += pattern;
+        filter_key += "*,";
+    }
+    if (form_matcher.MatchesEverything())
+    {
+        filter_key += '*';
+    }
+
+    filter_key += ";CIKs=";
+    if (cik_filter.IsActive())
+    {
+        for (const auto CIK : cik_filter.GetCIKs())
+        {
+            filter_key += std::format("{},", CIK);
+        }
+    }
+    else
+    {
+        filter_key += '*';
+    }
+
+    filter_key += ";dates=";
+    if (first_date_filed)
+    {
+        filter_key += std::format("{}..{}", first_date_filed->time_since_epoch().count(),
+                                  last_date_filed->time_since_epoch().count());
+    }
+    else
+    {
+        filter_key += '*';
+    }
+    return filter_key;
+} // -----  end of method QueryResultCache::MakeFilterKey  -----
+
+fs::path QueryResultCache::MakeCacheFileName(const fs::path &index_file_name, const std::string &filter_key)
+{
+    // the hash only names the file.  The whole key is kept in the file and
+    // checked so a collision just means a cache miss.
+
+    auto cache_file_name = index_file_name;
+    cache_file_name.replace_extension(std::format("{:016x}.qcache", FNV1a64(filter_key)));
+    return cache_file_name;
+} // -----  end of method QueryResultCache::MakeCacheFileName  -----
@@ -0,0 +1,133 @@
+// =====================================================================================
+//
+//       Filename:  QueryResultCache.h
+//
+//    Description:  Saved results of searching an index file with a given
+//                  filter
+//
+//        Version:  1.0
+//        Created:  10/19/2026 06:14:09 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef QUERYRESULTCACHE_H_
+#define QUERYRESULTCACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "FilingPlan.h"
+
+namespace fs = std::filesystem;
+
+class CIKFilter;
+class FormTypeMatcher;
+
+// =====================================================================================
+//        Class:  QueryResultCache
+//  Description:  historical index files don't change so searching one with
+//                the same filter always gives the same answer.  We save that
+//                answer in a small binary file next to the index file and use
+//                it next time.
+//
+//                The cache file is keyed by the filter in canonical form
+//                (sorted forms, sorted CIKs, date range) and records the index
+//                file's size and modification time.  A cache file that does
+//                not match both is ignored and replaced.
+// =====================================================================================
+class QueryResultCache
+{
+public:
+    // ====================  LIFECYCLE     =======================================
+
+    QueryResultCache() = delete;
+
+    // the index file's size and modification time are taken now, before it
+    // is searched.  If it changes while we are searching, what we save will
+    // just look out of date next time.
+
+    QueryResultCache(const fs::path &index_file_name,
+                     const FormTypeMatcher &form_matcher,
+                     const CIKFilter &cik_filter,
+                     std::optional<std::chrono::sys_days> first_date_filed,
+                     std::optional<std::chrono::sys_days> last_date_filed);
+
+    QueryResultCache(const QueryResultCache &rhs) = delete;
+    QueryResultCache(QueryResultCache &&rhs) = delete;
+
+    ~QueryResultCache() = default;
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] const fs::path &GetCacheFileName() const
+    {
+        return cache_file_name_;
+    }
+
+    // nothing if there is no usable cache file for this index file and filter.
+    // Throws if the cache file is damaged.
+
+    [[nodiscard]] std::optional<FilingPlan> Load() const;
+
+    // ====================  MUTATORS      =======================================
+
+    QueryResultCache &operator=(const QueryResultCache &rhs) = delete;
+    QueryResultCache &operator=(QueryResultCache &&rhs) = delete;
+
+    // ====================  OPERATORS     =======================================
+
+    // written under a temporary name and renamed into place.
+
+    void Save(const FilingPlan &results) const;
+
+    // the filter as text with everything in a fixed order so equivalent
+    // filters give the same key.
+
+    static std::string MakeFilterKey(const FormTypeMatcher &form_matcher,
+                                     const CIKFilter &cik_filter,
+                                     std::optional<std::chrono::sys_days> first_date_filed,
+                                     std::optional<std::chrono::sys_days> last_date_filed);
+
+    // master.idx -> master.<filter hash>.qcache
+
+    static fs::path MakeCacheFileName(const fs::path &index_file_name, const std::string &filter_key);
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    // ====================  DATA MEMBERS  =======================================
+
+    fs::path cache_file_name_;
+    std::string filter_key_;
+
+    std::uint64_t source_size_ = 0;
+    std::int64_t source_mtime_ = 0;
+
+}; // -----  end of class QueryResultCache  -----
+
+#endif /* QUERYRESULTCACHE_H_ */
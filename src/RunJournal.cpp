@@ -0,0 +1,649 @@
+// =====================================================================================
+//
+//       Filename:  RunJournal.cpp
+//
+//    Description:  Records the plan for a run and what has been done so an
+//                  interrupted run can pick up where it stopped
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:59 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryFileUtils.h"
+#include "MemoryMappedFile.h"
+#include "RunJournal.h"
+
+// the journal file looks like this:
+//
+//  JournalHeader
+//  RecordHeader, payload
+//  ...
+//
+// with these records:
+//
+//  arguments       each option followed by a nul
+//  index files     each remote index file name followed by a nul
+//  plan            PlanHeader, source, each form type followed by a nul,
+//                  FilingPlan::Filing[filing_count], file names
+//  items           ItemRecord[]
+//
+// When a filing shows up more than once, the last record wins.
+
+namespace
+{
+constexpr std::array<char, 8> k_magic{'C', 'O', 'L', 'J', 'R', 'N', 'L', '1'};
+constexpr std::uint32_t k_version = 1;
+
+constexpr std::uint32_t k_arguments_record = 1;
+constexpr std::uint32_t k_index_files_record = 2;
+constexpr std::uint32_t k_plan_record = 3;
+constexpr std::uint32_t k_items_record = 4;
+
+struct JournalHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t unused;
+};
+static_assert(sizeof(JournalHeader) == 16);
+
+struct RecordHeader
+{
+    std::uint32_t type;
+    std::uint32_t size;
+    std::uint64_t checksum;
+};
+static_assert(sizeof(RecordHeader) == 16);
+
+struct PlanHeader
+{
+    std::uint32_t source_size;
+    std::uint32_t form_count;
+    std::uint64_t filing_count;
+    std::uint64_t form_types_size;
+    std::uint64_t file_names_size;
+};
+static_assert(sizeof(PlanHeader) == 32);
+static_assert(sizeof(FilingPlan::Filing) == 20);
+
+// FNV-1a of the record type, size and payload.  Tells us a record was cut
+// short or never finished.
+
+std::uint64_t RecordChecksum(std::uint32_t record_type, COL::sview payload)
+{
+    const auto payload_size = static_cast<std::uint32_t>(payload.size());
+    auto hash = FNV1a64(COL::sview{reinterpret_cast<const char *>(&record_type), sizeof(record_type)});
+    hash = FNV1a64(COL::sview{reinterpret_cast<const char *>(&payload_size), sizeof(payload_size)}, hash);
+    return FNV1a64(payload, hash);
+}
+
+// calls handle_record with each whole record until it returns false.
+// Returns where the last whole record we looked at ends.
+
+template <typename Handler>
+std::size_t ForEachRecord(COL::sview data, const fs::path &journal_file_name, Handler &&handle_record)
+{
+    JournalHeader header;
+    if (data.size() < sizeof(header))
+    {
+        throw std::runtime_error(catenate("Run journal: ", journal_file_name.string(), " is too short."));
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != k_magic || header.version != k_version)
+    {
+        throw std::runtime_error(
+            catenate("File: ", journal_file_name.string(), " is not a version ", k_version, " run journal."));
+    }
+
+    std::size_t offset = sizeof(header);
+    while (data.size() - offset >= sizeof(RecordHeader))
+    {
+        RecordHeader record_header;
+        std::memcpy(&record_header, data.data() + offset, sizeof(record_header));
+        if (record_header.size > data.size() - offset - sizeof(record_header))
+        {
+            break;
+        }
+        const auto payload = data.substr(offset + sizeof(record_header), record_header.size);
+        if (RecordChecksum(record_header.type, payload) != record_header.checksum)
+        {
+            break;
+        }
+        offset += sizeof(record_header) + record_header.size;
+        if (!handle_record(record_header.type, payload))
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
+std::vector<std::string> SplitNulTerminated(COL::sview data)
+{
+    std::vector<std::string> results;
+    while (!data.empty())
+    {
+        const auto end = data.find('\0');
+        if (end == COL::sview::npos)
+        {
+            throw std::runtime_error("Unterminated name in run journal.");
+        }
+        results.emplace_back(data.substr(0, end));
+        data.remove_prefix(end + 1);
+    }
+    return results;
+}
+
+std::string EncodePlan(const std::string &source, const FilingPlan &plan)
+{
+    std::string form_types;
+    for (const auto &form_type : plan.GetFormTypes())
+    {
+        form_types += form_type;
+        form_types += '\0';
+    }
+
+    PlanHeader header{};
+    header.source_size = static_cast<std::uint32_t>(source.size());
+    header.form_count = static_cast<std::uint32_t>(plan.GetFormTypes().size());
+    header.filing_count = plan.GetFilingCount();
+    header.form_types_size = form_types.size();
+    header.file_names_size = plan.GetFileNames().size();
+
+    std::string payload;
+    payload.reserve(sizeof(header) + source.size() + form_types.size() +
+                    plan.GetFilingCount() * sizeof(FilingPlan::Filing) + plan.GetFileNames().size());
+    payload.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    payload += source;
+    payload += form_types;
+    payload.append(reinterpret_cast<const char *>(plan.GetFilings().data()),
+                   plan.GetFilingCount() * sizeof(FilingPlan::Filing));
+    payload += plan.GetFileNames();
+    return payload;
+}
+
+std::pair<std::string, FilingPlan> DecodePlan(COL::sview payload)
+{
+    PlanHeader header;
+    if (payload.size() < sizeof(header))
+    {
+        throw std::runtime_error("Plan record is too short.");
+    }
+    std::memcpy(&header, payload.data(), sizeof(header));
+    payload.remove_prefix(sizeof(header));
+
+    const auto filings_size = header.filing_count * sizeof(FilingPlan::Filing);
+    if (payload.size() != header.source_size + header.form_types_size + filings_size + header.file_names_size)
+    {
+        throw std::runtime_error("Plan record has the wrong size for its contents.");
+    }
+
+    std::string source{payload.substr(0, header.source_size)};
+    payload.remove_prefix(header.source_size);
+
+    auto form_types = SplitNulTerminated(payload.substr(0, header.form_types_size));
+    payload.remove_prefix(header.form_types_size);
+    if (form_types.size() != header.form_count)
+    {
+        throw std::runtime_error("Plan record has the wrong number of form types.");
+    }
+
+    std::vector<FilingPlan::Filing> filings(header.filing_count);
+    std::memcpy(filings.data(), payload.data(), filings_size);
+    payload.remove_prefix(filings_size);
+
+    // the plan checks its filings against the form types and file names.
+
+    return {std::move(source), FilingPlan{std::move(form_types), std::move(filings), std::string{payload}}};
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  RunJournal
+//      Method:  RunJournal
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+RunJournal::RunJournal(const fs::path &journal_file_name,
+                       bool resume,
+                       std::size_t batch_size,
+                       std::chrono::milliseconds interval)
+    : journal_file_name_{journal_file_name}, resumed_{resume}, batch_size_{batch_size}, interval_{interval}
+{
+    BOOST_ASSERT_MSG(batch_size_ > 0, "Run journal batch size must be > 0.");
+    BOOST_ASSERT_MSG(interval_.count() > 0, "Run journal interval must be > 0.");
+
+    if (resumed_)
+    {
+        Load();
+    }
+    else
+    {
+        Create();
+    }
+
+    pending_items_.reserve(batch_size_);
+    writer_ = std::thread{&RunJournal::WriteAtIntervals, this};
+} // -----  end of method RunJournal::RunJournal  (constructor)  -----
+
+RunJournal::~RunJournal()
+{
+    {
+        std::lock_guard<std::mutex> lock{journal_mutex_};
+        stopping_ = true;
+    }
+    pending_condition_.notify_one();
+    writer_.join();
+
+    WritePendingItems();
+
+    if (journal_fd_ != -1)
+    {
+        ::close(journal_fd_);
+    }
+} // -----  end of method RunJournal::~RunJournal  (destructor)  -----
+
+std::vector<std::string> RunJournal::GetArguments() const
+{
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    return arguments_;
+} // -----  end of method RunJournal::GetArguments  -----
+
+std::optional<std::vector<fs::path>> RunJournal::GetIndexFiles() const
+{
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    return index_files_;
+} // -----  end of method RunJournal::GetIndexFiles  -----
+
+std::optional<std::uint32_t> RunJournal::FindPlan(COL::sview source) const
+{
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    for (std::uint32_t i = 0; i < plan_sources_.size(); ++i)
+    {
+        if (plan_sources_[i] == source)
+        {
+            return i;
+        }
+    }
+    return {};
+} // -----  end of method RunJournal::FindPlan  -----
+
+const FilingPlan &RunJournal::GetPlan(std::uint32_t plan_number) const
+{
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    BOOST_ASSERT_MSG(plan_number < plans_.size(), catenate("No plan: ", plan_number, " in run journal.").c_str());
+    return plans_[plan_number];
+} // -----  end of method RunJournal::GetPlan  -----
+
+RunJournal::ItemState RunJournal::GetItemState(Item item) const
+{
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    BOOST_ASSERT_MSG(item.plan < item_states_.size() && item.filing < item_states_[item.plan].size(),
+                     "No such filing in run journal.");
+    return item_states_[item.plan][item.filing];
+} // -----  end of method RunJournal::GetItemState  -----
+
+RunJournal::Statistics RunJournal::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    return statistics_;
+} // -----  end of method RunJournal::GetStatistics  -----
+
+void RunJournal::LogStatistics() const
+{
+    const auto statistics = GetStatistics();
+    const std::chrono::duration<double> write_time = statistics.write_time;
+    spdlog::info(std::format("J: Run journal: {}. Plans: {}. Filings: {}. Done: {}. Failed: {}. Recorded {} filings "
+                             "in {} batches in {:.3f} seconds. Errors: {}.",
+                             journal_file_name_.string(), statistics.plans, statistics.filings, statistics.completed,
+                             statistics.failed, statistics.items_recorded, statistics.batches_written,
+                             write_time.count(), statistics.errors));
+} // -----  end of method RunJournal::LogStatistics  -----
+
+std::vector<std::string> RunJournal::ReadArguments(const fs::path &journal_file_name)
+{
+    const MemoryMappedFile journal_file{journal_file_name};
+
+    std::vector<std::string> arguments;
+    ForEachRecord(journal_file.GetView(), journal_file_name,
+                  [&arguments](std::uint32_t record_type, COL::sview payload)
+                  {
+                      if (record_type != k_arguments_record)
+                      {
+                          return true;
+                      }
+                      arguments = SplitNulTerminated(payload);
+                      return false;
+                  });
+    return arguments;
+} // -----  end of method RunJournal::ReadArguments  -----
+
+void RunJournal::SetArguments(const std::vector<std::string> &arguments)
+{
+    std::string payload;
+    for (const auto &argument : arguments)
+    {
+        payload += argument;
+        payload += '\0';
+    }
+
+    std::lock_guard<std::mutex> write_lock{write_mutex_};
+    AppendRecord(k_arguments_record, payload);
+
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    arguments_ = arguments;
+} // -----  end of method RunJournal::SetArguments  -----
+
+void RunJournal::SetIndexFiles(const std::vector<fs::path> &index_files)
+{
+    std::string payload;
+    for (const auto &index_file : index_files)
+    {
+        payload += index_file.string();
+        payload += '\0';
+    }
+
+    std::lock_guard<std::mutex> write_lock{write_mutex_};
+    AppendRecord(k_index_files_record, payload);
+
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    index_files_ = index_files;
+} // -----  end of method RunJournal::SetIndexFiles  -----
+
+std::uint32_t RunJournal::AddPlan(const std::string &source, FilingPlan plan)
+{
+    const auto payload = EncodePlan(source, plan);
+
+    // plans are numbered in the order they are in the file.
+
+    std::lock_guard<std::mutex> write_lock{write_mutex_};
+    AppendRecord(k_plan_record, payload);
+
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    const auto plan_number = static_cast<std::uint32_t>(plans_.size());
+    statistics_.filings += plan.GetFilingCount();
+    ++statistics_.plans;
+    item_states_.emplace_back(plan.GetFilingCount(), ItemState::e_pending);
+    plan_sources_.push_back(source);
+    plans_.push_back(std::move(plan));
+    return plan_number;
+} // -----  end of method RunJournal::AddPlan  -----
+
+void RunJournal::RecordItem(Item item, ItemState state)
+{
+    bool batch_is_full = false;
+    {
+        std::lock_guard<std::mutex> lock{journal_mutex_};
+        BOOST_ASSERT_MSG(item.plan < item_states_.size() && item.filing < item_states_[item.plan].size(),
+                         "No such filing in run journal.");
+
+        auto &item_state = item_states_[item.plan][item.filing];
+        statistics_.completed -= item_state == ItemState::e_completed ? 1 : 0;
+        statistics_.failed -= item_state == ItemState::e_failed ? 1 : 0;
+        item_state = state;
+        statistics_.completed += state == ItemState::e_completed ? 1 : 0;
+        statistics_.failed += state == ItemState::e_failed ? 1 : 0;
+
+        pending_items_.push_back(ItemRecord{item.plan, item.filing, static_cast<std::uint32_t>(state)});
+        batch_is_full = pending_items_.size() >= batch_size_;
+    }
+    if (batch_is_full)
+    {
+        pending_condition_.notify_one();
+    }
+} // -----  end of method RunJournal::RecordItem  -----
+
+void RunJournal::MarkDownloadsStarting()
+{
+    if (downloads_started_.exchange(true))
+    {
+        return;
+    }
+    const std::chrono::duration<double> startup_time = std::chrono::steady_clock::now() - opened_at_;
+    spdlog::info(std::format("J: {} run ready to download {:.3f} seconds after opening run journal: {}.",
+                             resumed_ ? "Resumed" : "New", startup_time.count(), journal_file_name_.string()));
+} // -----  end of method RunJournal::MarkDownloadsStarting  -----
+
+void RunJournal::Flush()
+{
+    WritePendingItems();
+} // -----  end of method RunJournal::Flush  -----
+
+void RunJournal::Load()
+{
+    const auto load_start = std::chrono::steady_clock::now();
+
+    std::size_t good_size = 0;
+    std::size_t file_size = 0;
+    {
+        const MemoryMappedFile journal_file{journal_file_name_};
+        const auto data = journal_file.GetView();
+        file_size = data.size();
+
+        try
+        {
+            good_size = ForEachRecord(
+                data, journal_file_name_,
+                [this](std::uint32_t record_type, COL::sview payload)
+                {
+                    if (record_type == k_arguments_record)
+                    {
+                        arguments_ = SplitNulTerminated(payload);
+                    }
+                    else if (record_type == k_index_files_record)
+                    {
+                        const auto index_files = SplitNulTerminated(payload);
+                        index_files_.emplace(index_files.begin(), index_files.end());
+                    }
+                    else if (record_type == k_plan_record)
+                    {
+                        auto [source, plan] = DecodePlan(payload);
+                        item_states_.emplace_back(plan.GetFilingCount(), ItemState::e_pending);
+                        plan_sources_.push_back(std::move(source));
+                        plans_.push_back(std::move(plan));
+                    }
+                    else if (record_type == k_items_record && payload.size() % sizeof(ItemRecord) == 0)
+                    {
+                        for (std::size_t i = 0; i < payload.size(); i += sizeof(ItemRecord))
+                        {
+                            ItemRecord item;
+                            std::memcpy(&item, payload.data() + i, sizeof(item));
+                            if (item.plan >= item_states_.size() || item.filing >= item_states_[item.plan].size() ||
+                                item.state > static_cast<std::uint32_t>(ItemState::e_failed))
+                            {
+                                throw std::runtime_error("Item record is for a filing we don't have.");
+                            }
+                            item_states_[item.plan][item.filing] = static_cast<ItemState>(item.state);
+                        }
+                    }
+                    else
+                    {
+                        throw std::runtime_error(catenate("Unknown record type: ", record_type));
+                    }
+                    return true;
+                });
+        }
+        catch (const std::runtime_error &e)
+        {
+            throw std::runtime_error(catenate("Run journal: ", journal_file_name_.string(), " is damaged: ", e.what()));
+        }
+    }
+
+    for (const auto &plan_states : item_states_)
+    {
+        statistics_.filings += plan_states.size();
+        statistics_.completed += std::ranges::count(plan_states, ItemState::e_completed);
+        statistics_.failed += std::ranges::count(plan_states, ItemState::e_failed);
+    }
+    statistics_.plans = plans_.size();
+
+    journal_fd_ = ::open(journal_file_name_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (journal_fd_ == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't open run journal: ", journal_file_name_.string())};
+    }
+
+    // the last record was cut short.  Anything we add has to follow the
+    // last whole one.
+
+    if (good_size < file_size)
+    {
+        if (::ftruncate(journal_fd_, static_cast<off_t>(good_size)) == -1)
+        {
+            throw std::system_error{std::error_code{errno, std::system_category()},
+                                    catenate("Can't trim run journal: ", journal_file_name_.string())};
+        }
+        spdlog::info(catenate("J: Dropped ", file_size - good_size, " bytes of an unfinished record from run journal: ",
+                              journal_file_name_.string()));
+    }
+
+    const std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - load_start;
+    spdlog::info(std::format("J: Loaded run journal: {} in {:.3f} seconds. Plans: {}. Filings: {}. Done: {}. "
+                             "Failed: {}.",
+                             journal_file_name_.string(), load_time.count(), statistics_.plans, statistics_.filings,
+                             statistics_.completed, statistics_.failed));
+} // -----  end of method RunJournal::Load  -----
+
+void RunJournal::Create()
+{
+    journal_fd_ = ::open(journal_file_name_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0666);
+    if (journal_fd_ == -1 && errno == EEXIST)
+    {
+        throw std::runtime_error(catenate("Run journal: ", journal_file_name_.string(),
+                                          " is already there. Use 'resume' to carry on with that run or remove it."));
+    }
+    if (journal_fd_ == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't make run journal: ", journal_file_name_.string())};
+    }
+
+    const JournalHeader header{k_magic, k_version, 0};
+    if (::write(journal_fd_, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't write run journal: ", journal_file_name_.string())};
+    }
+} // -----  end of method RunJournal::Create  -----
+
+void RunJournal::AppendRecord(std::uint32_t record_type, COL::sview payload)
+{
+    const RecordHeader header{record_type, static_cast<std::uint32_t>(payload.size()),
+                              RecordChecksum(record_type, payload)};
+
+    std::string record;
+    record.reserve(sizeof(header) + payload.size());
+    record.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    record.append(payload);
+
+    const auto written = ::write(journal_fd_, record.data(), record.size());
+    if (written != static_cast<ssize_t>(record.size()))
+    {
+        throw std::system_error{std::error_code{written == -1 ? errno : EIO, std::system_category()},
+                                catenate("Can't add to run journal: ", journal_file_name_.string())};
+    }
+    if (::fdatasync(journal_fd_) != 0)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't flush run journal: ", journal_file_name_.string())};
+    }
+} // -----  end of method RunJournal::AppendRecord  -----
+
+void RunJournal::WriteAtIntervals()
+{
+    std::unique_lock<std::mutex> lock{journal_mutex_};
+    while (!stopping_)
+    {
+        pending_condition_.wait_for(lock, interval_,
+                                    [this] { return stopping_ || pending_items_.size() >= batch_size_; });
+        lock.unlock();
+        WritePendingItems();
+        lock.lock();
+    }
+} // -----  end of method RunJournal::WriteAtIntervals  -----
+
+void RunJournal::WritePendingItems()
+{
+    // holding write_mutex_ while taking the batch keeps the batches in the
+    // file in the order they were taken.
+
+    std::lock_guard<std::mutex> write_lock{write_mutex_};
+
+    std::vector<ItemRecord> batch;
+    {
+        std::lock_guard<std::mutex> lock{journal_mutex_};
+        batch.swap(pending_items_);
+        pending_items_.reserve(batch_size_);
+    }
+    if (batch.empty())
+    {
+        return;
+    }
+
+    const auto write_start = std::chrono::steady_clock::now();
+
+    // if it can't be written, those filings will just be done again next
+    // time.
+
+    bool written = true;
+    try
+    {
+        AppendRecord(k_items_record,
+                     COL::sview{reinterpret_cast<const char *>(batch.data()), batch.size() * sizeof(ItemRecord)});
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error(catenate("J: ", e.what()));
+        written = false;
+    }
+
+    std::lock_guard<std::mutex> lock{journal_mutex_};
+    if (written)
+    {
+        statistics_.items_recorded += batch.size();
+        ++statistics_.batches_written;
+    }
+    else
+    {
+        statistics_.errors += batch.size();
+    }
+    statistics_.write_time += std::chrono::steady_clock::now() - write_start;
+} // -----  end of method RunJournal::WritePendingItems  -----
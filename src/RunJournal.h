@@ -0,0 +1,256 @@
+// =====================================================================================
+//
+//       Filename:  RunJournal.h
+//
+//    Description:  Records the plan for a run and what has been done so an
+//                  interrupted run can pick up where it stopped
+//
+//        Version:  1.0
+//        Created:  10/19/2026 11:59:59 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef RUNJOURNAL_H_
+#define RUNJOURNAL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Collector_Utils.h"
+#include "FilingPlan.h"
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  RunJournal
+//  Description:  a backfill can run for days.  When it dies, starting it
+//                again means listing the index directories, downloading
+//                and searching the index files and checking for every form
+//                file all over again before the first new download.
+//
+//                The journal is a file with the run's options, the index
+//                files it uses and the filing plan made from each (or from
+//                all of them), followed by which filings have been
+//                downloaded or failed.  A resumed run takes all of that from
+//                the journal, skips the filings already done without looking
+//                for their files and carries on with the rest.  Filings
+//                which failed are tried again.
+//
+//                Plans are written and flushed to disk as they are added.
+//                Finished filings are written a batch at a time with one
+//                flush per batch, the same way group commit does files.  A
+//                crash can lose the last batch, which just means those
+//                filings are done again.  Each record has a checksum so a
+//                record cut short by a crash is ignored.
+// =====================================================================================
+class RunJournal
+{
+public:
+    enum class ItemState : std::uint8_t
+    {
+        e_pending,
+        e_completed,
+        e_failed
+    };
+
+    // a filing in one of our plans.
+
+    struct Item
+    {
+        std::uint32_t plan;
+        std::uint32_t filing;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t plans = 0;
+        std::uint64_t filings = 0;
+        std::uint64_t completed = 0;
+        std::uint64_t failed = 0;
+
+        // this run only.
+
+        std::uint64_t items_recorded = 0;
+        std::uint64_t batches_written = 0;
+        std::uint64_t errors = 0;
+        std::chrono::steady_clock::duration write_time{};
+    };
+
+    // the source of a plan made from all of a run's index files at once.
+
+    static constexpr const char *k_all_index_files = "*";
+
+    // ====================  LIFECYCLE     =======================================
+
+    RunJournal() = delete;
+
+    // starts a new journal or, with resume, loads the one there and adds to
+    // it.  A new journal won't replace an old one.  Throws if the file is
+    // there (new) or isn't usable (resume).
+
+    RunJournal(const fs::path &journal_file_name,
+               bool resume,
+               std::size_t batch_size,
+               std::chrono::milliseconds interval);
+
+    RunJournal(const RunJournal &rhs) = delete;
+    RunJournal(RunJournal &&rhs) = delete;
+
+    // writes anything still waiting.
+
+    ~RunJournal();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] const fs::path &GetJournalFileName() const
+    {
+        return journal_file_name_;
+    }
+    [[nodiscard]] bool IsResumed() const
+    {
+        return resumed_;
+    }
+
+    // the options the run was started with.  Empty for a journal that never
+    // got that far.
+
+    [[nodiscard]] std::vector<std::string> GetArguments() const;
+
+    // nothing if the run hadn't found its index files yet.
+
+    [[nodiscard]] std::optional<std::vector<fs::path>> GetIndexFiles() const;
+
+    [[nodiscard]] std::optional<std::uint32_t> FindPlan(COL::sview source) const;
+
+    // the plan stays put for as long as we are around.
+
+    [[nodiscard]] const FilingPlan &GetPlan(std::uint32_t plan_number) const;
+
+    [[nodiscard]] ItemState GetItemState(Item item) const;
+
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    void LogStatistics() const;
+
+    // just the options from a journal.  Used to set up a resumed run before
+    // anything else is.
+
+    static std::vector<std::string> ReadArguments(const fs::path &journal_file_name);
+
+    // ====================  MUTATORS      =======================================
+
+    RunJournal &operator=(const RunJournal &rhs) = delete;
+    RunJournal &operator=(RunJournal &&rhs) = delete;
+
+    void SetArguments(const std::vector<std::string> &arguments);
+    void SetIndexFiles(const std::vector<fs::path> &index_files);
+
+    // source is the index file the plan came from or k_all_index_files.
+    // Returns the plan's number.  Safe to call from any thread.
+
+    std::uint32_t AddPlan(const std::string &source, FilingPlan plan);
+
+    // written with the next batch.  Safe to call from any thread.
+
+    void RecordItem(Item item, ItemState state);
+
+    // logs, the first time only, how long it took from opening the journal
+    // to having something to download.  That is most of the run's start up
+    // time and what resuming saves.
+
+    void MarkDownloadsStarting();
+
+    // writes everything waiting now and returns when it is on disk.
+
+    void Flush();
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    struct ItemRecord
+    {
+        std::uint32_t plan;
+        std::uint32_t filing;
+        std::uint32_t state;
+    };
+
+    void Load();
+    void Create();
+
+    // one write and one flush per record.
+
+    void AppendRecord(std::uint32_t record_type, COL::sview payload);
+
+    void WriteAtIntervals();
+    void WritePendingItems();
+
+    // ====================  DATA MEMBERS  =======================================
+
+    fs::path journal_file_name_;
+    bool resumed_;
+
+    std::size_t batch_size_;
+    std::chrono::milliseconds interval_;
+
+    std::chrono::steady_clock::time_point opened_at_ = std::chrono::steady_clock::now();
+    std::atomic<bool> downloads_started_{false};
+
+    std::vector<std::string> arguments_;
+    std::optional<std::vector<fs::path>> index_files_;
+
+    std::deque<FilingPlan> plans_;
+    std::vector<std::string> plan_sources_;
+    std::vector<std::vector<ItemState>> item_states_;
+
+    std::vector<ItemRecord> pending_items_;
+    bool stopping_ = false;
+
+    Statistics statistics_;
+
+    mutable std::mutex journal_mutex_;
+    std::condition_variable pending_condition_;
+
+    // one record at a time.
+
+    std::mutex write_mutex_;
+    int journal_fd_ = -1;
+
+    std::thread writer_;
+
+}; // -----  end of class RunJournal  -----
+
+#endif /* RUNJOURNAL_H_ */
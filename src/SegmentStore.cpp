@@ -0,0 +1,635 @@
+// =====================================================================================
+//
+//       Filename:  SegmentStore.cpp
+//
+//    Description:  Keeps small form files packed together in large segment
+//                  files instead of a file each
+//
+//        Version:  1.0
+//        Created:  10/19/2026 10:41:26 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "Collector_Utils.h"
+#include "FormFileRetriever.h"
+#include "SegmentStore.h"
+
+// the index file looks like this:
+//
+//  <segment>\t<offset>\t<size>\t<CIK>\t<form type>\t<EDGAR file name>
+//  ...
+//
+// When the same CIK and accession number show up more than once, the last
+// line wins.  Lines for different CIKs can point at the same data.
+
+namespace
+{
+constexpr const char *k_index_file_name = "segments.idx";
+constexpr const char *k_incoming_directory = "incoming";
+constexpr const char *k_benchmark_directory_name = ".segment_benchmark";
+
+template <typename T>
+bool ParseNumber(COL::sview text, T &result)
+{
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), result);
+    return ec == std::errc{} && ptr == text.data() + text.size();
+}
+
+double MegabytesPerSecond(std::uint64_t bytes, std::chrono::steady_clock::duration elapsed)
+{
+    const std::chrono::duration<double> seconds = elapsed;
+    return seconds.count() > 0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds.count() : 0.0;
+}
+
+// what the files under directory take up on disk, not just their sizes.
+
+std::uint64_t DiskSpaceUsed(const fs::path &directory)
+{
+    std::uint64_t space_used = 0;
+    for (const auto &dir_entry : fs::recursive_directory_iterator(directory))
+    {
+        struct stat file_status;
+        if (::stat(dir_entry.path().c_str(), &file_status) == 0)
+        {
+            space_used += static_cast<std::uint64_t>(file_status.st_blocks) * 512;
+        }
+    }
+    return space_used;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------
+//       Class:  SegmentStore
+//      Method:  SegmentStore
+// Description:  constructor
+//--------------------------------------------------------------------------------------
+
+SegmentStore::SegmentStore(const fs::path &store_directory, const std::vector<std::string> &form_types)
+    : store_directory_{store_directory}, index_file_name_{store_directory / k_index_file_name},
+      form_matcher_{form_types}
+{
+    fs::create_directories(store_directory_ / k_incoming_directory);
+
+    const bool cut_off_line = Load();
+
+    index_fd_ = ::open(index_file_name_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (index_fd_ == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't open segment index: ", index_file_name_.string())};
+    }
+
+    // finish off a partial line so it doesn't run into the next one.
+
+    if (cut_off_line)
+    {
+        Write(index_fd_, "\n", index_file_name_);
+    }
+
+    // keep adding to the last segment we used.
+
+    OpenSegment(std::max<std::uint32_t>(segment_, 1));
+} // -----  end of method SegmentStore::SegmentStore  (constructor)  -----
+
+SegmentStore::~SegmentStore()
+{
+    if (segment_fd_ != -1)
+    {
+        ::close(segment_fd_);
+    }
+    if (index_fd_ != -1)
+    {
+        ::close(index_fd_);
+    }
+} // -----  end of method SegmentStore::~SegmentStore  (destructor)  -----
+
+std::size_t SegmentStore::GetFileCount() const
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    return entries_.size();
+} // -----  end of method SegmentStore::GetFileCount  -----
+
+bool SegmentStore::WantsFormType(COL::sview form_type) const
+{
+    return form_matcher_.Match(form_type).has_value();
+} // -----  end of method SegmentStore::WantsFormType  -----
+
+COL::sview SegmentStore::AccessionNumberFromFileName(COL::sview file_name)
+{
+    if (const auto last_slash = file_name.rfind('/'); last_slash != COL::sview::npos)
+    {
+        file_name.remove_prefix(last_slash + 1);
+    }
+    return file_name.substr(0, file_name.find('.'));
+} // -----  end of method SegmentStore::AccessionNumberFromFileName  -----
+
+bool SegmentStore::HasFile(std::uint32_t CIK, COL::sview file_name) const
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    return entries_by_CIK_accession_number_.contains({CIK, std::string{AccessionNumberFromFileName(file_name)}});
+} // -----  end of method SegmentStore::HasFile  -----
+
+std::optional<SegmentStore::Entry> SegmentStore::FindFile(std::uint32_t CIK, COL::sview accession_number) const
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    if (const auto found = entries_by_CIK_accession_number_.find({CIK, std::string{accession_number}});
+        found != entries_by_CIK_accession_number_.end())
+    {
+        return entries_[found->second];
+    }
+    return {};
+} // -----  end of method SegmentStore::FindFile  -----
+
+std::optional<SegmentStore::Entry> SegmentStore::FindFile(COL::sview accession_number) const
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    if (const auto found = entries_by_accession_number_.find(std::string{accession_number});
+        found != entries_by_accession_number_.end())
+    {
+        return entries_[found->second.front()];
+    }
+    return {};
+} // -----  end of method SegmentStore::FindFile  -----
+
+std::vector<SegmentStore::Entry> SegmentStore::FindFiles(std::uint32_t CIK, COL::sview form_type) const
+{
+    std::vector<Entry> results;
+
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    if (const auto found = entries_by_CIK_form_.find({CIK, std::string{form_type}});
+        found != entries_by_CIK_form_.end())
+    {
+        results.reserve(found->second.size());
+        for (const auto entry_index : found->second)
+        {
+            results.push_back(entries_[entry_index]);
+        }
+    }
+    return results;
+} // -----  end of method SegmentStore::FindFiles  -----
+
+std::string SegmentStore::ReadFile(const Entry &entry) const
+{
+    const auto segment_file_name = MakeSegmentFileName(entry.segment);
+
+    std::ifstream segment_file{segment_file_name, std::ios::in | std::ios::binary};
+    if (!segment_file.is_open())
+    {
+        throw std::runtime_error(catenate("Unable to open segment file: ", segment_file_name.string()));
+    }
+
+    std::string contents(entry.size, '\0');
+    segment_file.seekg(static_cast<std::streamoff>(entry.offset));
+    segment_file.read(contents.data(), static_cast<std::streamsize>(entry.size));
+    if (segment_file.gcount() != static_cast<std::streamsize>(entry.size))
+    {
+        throw std::runtime_error(catenate("Segment file: ", segment_file_name.string(), " is too short for: ",
+                                          entry.file_name));
+    }
+    return contents;
+} // -----  end of method SegmentStore::ReadFile  -----
+
+fs::path SegmentStore::MakeDownloadFileName(std::uint32_t CIK, COL::sview file_name) const
+{
+    return store_directory_ / k_incoming_directory /
+           std::format("{}_{}.tmp", CIK, fs::path{file_name}.filename().string());
+} // -----  end of method SegmentStore::MakeDownloadFileName  -----
+
+fs::path SegmentStore::MakeSegmentFileName(std::uint32_t segment) const
+{
+    return store_directory_ / std::format("segment_{:06}.pack", segment);
+} // -----  end of method SegmentStore::MakeSegmentFileName  -----
+
+std::size_t SegmentStore::ExportTo(const fs::path &local_form_directory,
+                                   bool replace_files,
+                                   FormDirectoryLayout layout) const
+{
+    const auto export_start = std::chrono::steady_clock::now();
+
+    // read the segments front to back instead of jumping around in them.
+
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock{store_mutex_};
+        entries = entries_;
+    }
+    std::ranges::sort(entries, [](const auto &lhs, const auto &rhs) {
+        return std::tie(lhs.segment, lhs.offset) < std::tie(rhs.segment, rhs.offset);
+    });
+
+    std::set<std::string> made_directories;
+    std::ifstream segment_file;
+    std::uint32_t open_segment = 0;
+    std::string contents;
+
+    std::size_t exported_files_counter = 0;
+    std::size_t skipped_files_counter = 0;
+    std::uint64_t exported_bytes = 0;
+
+    for (const auto &entry : entries)
+    {
+        std::string form_name{entry.form_type};
+        std::replace(form_name.begin(), form_name.end(), '/', '_');
+
+        const auto local_dir_name =
+            MakeLocalDirName(local_form_directory, std::to_string(entry.CIK), form_name, layout);
+        auto local_file_name{local_dir_name};
+        local_file_name /= fs::path{entry.file_name}.filename();
+
+        if (!replace_files && fs::exists(local_file_name))
+        {
+            ++skipped_files_counter;
+            continue;
+        }
+        if (made_directories.insert(local_dir_name.string()).second)
+        {
+            fs::create_directories(local_dir_name);
+        }
+
+        if (entry.segment != open_segment)
+        {
+            segment_file.close();
+            segment_file.open(MakeSegmentFileName(entry.segment), std::ios::in | std::ios::binary);
+            if (!segment_file.is_open())
+            {
+                throw std::runtime_error(
+                    catenate("Unable to open segment file: ", MakeSegmentFileName(entry.segment).string()));
+            }
+            open_segment = entry.segment;
+        }
+        contents.resize(entry.size);
+        segment_file.seekg(static_cast<std::streamoff>(entry.offset));
+        segment_file.read(contents.data(), static_cast<std::streamsize>(entry.size));
+        if (segment_file.gcount() != static_cast<std::streamsize>(entry.size))
+        {
+            throw std::runtime_error(catenate("Segment file: ", MakeSegmentFileName(entry.segment).string(),
+                                              " is too short for: ", entry.file_name));
+        }
+
+        std::ofstream local_file{local_file_name, std::ios::out | std::ios::binary | std::ios::trunc};
+        local_file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        local_file.close();
+        if (local_file.fail())
+        {
+            throw std::runtime_error(catenate("Unable to write exported file: ", local_file_name.string()));
+        }
+        ++exported_files_counter;
+        exported_bytes += entry.size;
+    }
+
+    const auto export_time = std::chrono::steady_clock::now() - export_start;
+    spdlog::info(std::format("G: Exported {} files ({} bytes) from segment store: {} to: {} in {:.3f} seconds "
+                             "({:.1f} MB/s). Skipped: {}.",
+                             exported_files_counter, exported_bytes, store_directory_.string(),
+                             local_form_directory.string(), std::chrono::duration<double>(export_time).count(),
+                             MegabytesPerSecond(exported_bytes, export_time), skipped_files_counter));
+    return exported_files_counter;
+} // -----  end of method SegmentStore::ExportTo  -----
+
+void SegmentStore::LogStatistics() const
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+    spdlog::info(std::format("G: Segment store: {}. Files: {}. Added: {} ({} bytes) in {:.3f} seconds of writing "
+                             "({:.1f} MB/s). Shared with another CIK: {}.",
+                             store_directory_.string(), entries_.size(), files_added_, bytes_added_,
+                             std::chrono::duration<double>(write_time_).count(),
+                             MegabytesPerSecond(bytes_added_, write_time_), files_shared_));
+} // -----  end of method SegmentStore::LogStatistics  -----
+
+void SegmentStore::AddFile(const fs::path &downloaded_file_name,
+                           std::uint32_t CIK,
+                           COL::sview form_type,
+                           COL::sview file_name)
+{
+    const auto contents = LoadDataFileForUse(downloaded_file_name);
+
+    {
+        std::lock_guard<std::mutex> lock{store_mutex_};
+
+        const auto write_start = std::chrono::steady_clock::now();
+
+        if (segment_size_ > 0 && segment_size_ + contents.size() > k_segment_size)
+        {
+            OpenSegment(segment_ + 1);
+        }
+
+        // the data goes in before the index line that points at it.
+
+        Entry entry{segment_, segment_size_, contents.size(), CIK, std::string{form_type}, std::string{file_name}};
+        Write(segment_fd_, contents, MakeSegmentFileName(segment_));
+        segment_size_ += contents.size();
+
+        WriteIndexLine(entry);
+        AddEntry(std::move(entry));
+
+        write_time_ += std::chrono::steady_clock::now() - write_start;
+        ++files_added_;
+        bytes_added_ += contents.size();
+    }
+
+    fs::remove(downloaded_file_name);
+
+    spdlog::debug(catenate("G: Added: ", file_name, " to segment store."));
+} // -----  end of method SegmentStore::AddFile  -----
+
+bool SegmentStore::AddSharedFile(std::uint32_t CIK, COL::sview form_type, COL::sview file_name)
+{
+    std::lock_guard<std::mutex> lock{store_mutex_};
+
+    const auto found = entries_by_accession_number_.find(std::string{AccessionNumberFromFileName(file_name)});
+    if (found == entries_by_accession_number_.end())
+    {
+        return false;
+    }
+
+    auto entry = entries_[found->second.front()];
+    entry.CIK = CIK;
+    entry.form_type = form_type;
+    entry.file_name = file_name;
+
+    WriteIndexLine(entry);
+    AddEntry(std::move(entry));
+    ++files_shared_;
+    return true;
+} // -----  end of method SegmentStore::AddSharedFile  -----
+
+bool SegmentStore::Load()
+{
+    std::ifstream input{index_file_name_};
+    if (!input.is_open())
+    {
+        return false;
+    }
+
+    std::string line;
+    int bad_lines{0};
+    bool cut_off_line{false};
+    while (std::getline(input, line))
+    {
+        // a line without a newline was cut off part way through.
+
+        if (input.eof())
+        {
+            ++bad_lines;
+            cut_off_line = true;
+            break;
+        }
+
+        // 6 fields. The file name is last so it can hold anything but a newline.
+
+        std::array<COL::sview, 6> fields;
+        COL::sview record{line};
+        std::size_t field_count = 0;
+        for (; field_count < fields.size() - 1; ++field_count)
+        {
+            const auto tab = record.find('\t');
+            if (tab == COL::sview::npos)
+            {
+                break;
+            }
+            fields[field_count] = record.substr(0, tab);
+            record.remove_prefix(tab + 1);
+        }
+        fields[field_count] = record;
+
+        Entry entry;
+        if (field_count != fields.size() - 1 || !ParseNumber(fields[0], entry.segment) ||
+            !ParseNumber(fields[1], entry.offset) || !ParseNumber(fields[2], entry.size) ||
+            !ParseNumber(fields[3], entry.CIK) || fields[4].empty() || fields[5].empty())
+        {
+            ++bad_lines;
+            continue;
+        }
+        entry.form_type = fields[4];
+        entry.file_name = fields[5];
+
+        segment_ = std::max(segment_, entry.segment);
+        AddEntry(std::move(entry));
+    }
+
+    spdlog::info(catenate("G: Loaded segment index: ", index_file_name_.string(), " with ", entries_.size(),
+                          " files."));
+    if (bad_lines > 0)
+    {
+        spdlog::info(catenate("G: Ignored ", bad_lines, " damaged lines in segment index."));
+    }
+    return cut_off_line;
+} // -----  end of method SegmentStore::Load  -----
+
+void SegmentStore::OpenSegment(std::uint32_t segment)
+{
+    if (segment_fd_ != -1)
+    {
+        ::close(segment_fd_);
+        segment_fd_ = -1;
+    }
+
+    const auto segment_file_name = MakeSegmentFileName(segment);
+    segment_fd_ = ::open(segment_file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (segment_fd_ == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't open segment file: ", segment_file_name.string())};
+    }
+
+    // anything past the last indexed file (from a run that stopped between
+    // writing the data and its index line) is left as it is.
+
+    struct stat segment_stat{};
+    if (::fstat(segment_fd_, &segment_stat) == -1)
+    {
+        throw std::system_error{std::error_code{errno, std::system_category()},
+                                catenate("Can't stat segment file: ", segment_file_name.string())};
+    }
+    segment_ = segment;
+    segment_size_ = static_cast<std::uint64_t>(segment_stat.st_size);
+} // -----  end of method SegmentStore::OpenSegment  -----
+
+void SegmentStore::AddEntry(Entry entry)
+{
+    std::string accession_number{AccessionNumberFromFileName(entry.file_name)};
+    const auto [found, inserted] =
+        entries_by_CIK_accession_number_.try_emplace({entry.CIK, accession_number}, entries_.size());
+    if (inserted)
+    {
+        entries_by_accession_number_[std::move(accession_number)].push_back(entries_.size());
+        entries_by_CIK_form_[std::make_pair(entry.CIK, entry.form_type)].push_back(entries_.size());
+        entries_.push_back(std::move(entry));
+        return;
+    }
+
+    // a newer copy of a file we have for this CIK.  The old data stays in
+    // its segment.
+
+    auto &old_entry = entries_[found->second];
+    if (old_entry.form_type != entry.form_type)
+    {
+        std::erase(entries_by_CIK_form_[std::make_pair(old_entry.CIK, old_entry.form_type)], found->second);
+        entries_by_CIK_form_[std::make_pair(entry.CIK, entry.form_type)].push_back(found->second);
+    }
+    old_entry = std::move(entry);
+} // -----  end of method SegmentStore::AddEntry  -----
+
+void SegmentStore::WriteIndexLine(const Entry &entry)
+{
+    Write(index_fd_,
+          std::format("{}\t{}\t{}\t{}\t{}\t{}\n", entry.segment, entry.offset, entry.size, entry.CIK,
+                      entry.form_type, entry.file_name),
+          index_file_name_);
+} // -----  end of method SegmentStore::WriteIndexLine  -----
+
+void SegmentStore::Write(int fd, COL::sview data, const fs::path &file_name)
+{
+    while (!data.empty())
+    {
+        const auto written = ::write(fd, data.data(), data.size());
+        if (written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            throw std::system_error{std::error_code{written == -1 ? errno : EIO, std::system_category()},
+                                    catenate("Can't write to segment store file: ", file_name.string())};
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+} // -----  end of method SegmentStore::Write  -----
+
+void BenchmarkSegmentStore(const fs::path &directory, std::size_t file_count, std::size_t file_size)
+{
+    BOOST_ASSERT_MSG(file_count > 0, "Need files to write.");
+
+    const auto benchmark_directory = directory / k_benchmark_directory_name;
+    const auto files_directory = benchmark_directory / "files";
+    const auto store_directory = benchmark_directory / "segments";
+    fs::remove_all(benchmark_directory);
+
+    // something that looks like a small form 4.  About 10 per CIK.
+
+    std::string contents(file_size, ' ');
+    for (std::size_t i = 0; i < contents.size(); ++i)
+    {
+        contents[i] = (i % 80 == 79) ? '\n' : static_cast<char>('a' + i % 26);
+    }
+    auto make_CIK = [](std::size_t i) { return static_cast<std::uint32_t>(1000 + i / 10); };
+    auto make_file_name = [](std::uint32_t CIK, std::size_t i)
+    { return std::format("edgar/data/{}/{:010}-24-{:06}.txt", CIK, CIK, i); };
+
+    auto log_result = [file_count, file_size](COL::sview what, std::chrono::steady_clock::duration elapsed)
+    {
+        const std::chrono::duration<double> seconds = elapsed;
+        spdlog::info(std::format("G: {}: {} files in {:.3f} seconds. {:.0f} files per second. {:.1f} MB/s.", what,
+                                 file_count, seconds.count(), static_cast<double>(file_count) / seconds.count(),
+                                 MegabytesPerSecond(file_count * file_size, elapsed)));
+    };
+
+    // a file each.  The downloader writes straight to the final name.
+
+    auto phase_start = std::chrono::steady_clock::now();
+    std::vector<fs::path> local_file_names;
+    local_file_names.reserve(file_count);
+    for (std::size_t i = 0; i < file_count; ++i)
+    {
+        const auto CIK = make_CIK(i);
+        const auto file_name = make_file_name(CIK, i);
+        const auto local_dir_name = files_directory / std::to_string(CIK) / "4";
+        if (i % 10 == 0)
+        {
+            fs::create_directories(local_dir_name);
+        }
+        local_file_names.push_back(local_dir_name / fs::path{file_name}.filename());
+
+        std::ofstream output{local_file_names.back(), std::ios::out | std::ios::binary | std::ios::trunc};
+        output.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+    log_result("Write a file each", std::chrono::steady_clock::now() - phase_start);
+
+    phase_start = std::chrono::steady_clock::now();
+    std::size_t bytes_read = 0;
+    for (const auto &local_file_name : local_file_names)
+    {
+        bytes_read += LoadDataFileForUse(local_file_name).size();
+    }
+    log_result("Read a file each", std::chrono::steady_clock::now() - phase_start);
+    BOOST_ASSERT_MSG(bytes_read == file_count * file_size, "Didn't read back what we wrote.");
+
+    // segments.  The downloader writes to the incoming directory and the
+    // store appends that to a segment.
+
+    {
+        SegmentStore segment_store{store_directory, {"4"}};
+
+        phase_start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < file_count; ++i)
+        {
+            const auto CIK = make_CIK(i);
+            const auto file_name = make_file_name(CIK, i);
+            const auto download_file_name = segment_store.MakeDownloadFileName(CIK, file_name);
+            {
+                std::ofstream output{download_file_name, std::ios::out | std::ios::binary | std::ios::trunc};
+                output.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            }
+            segment_store.AddFile(download_file_name, CIK, "4", file_name);
+        }
+        log_result("Write to segments", std::chrono::steady_clock::now() - phase_start);
+
+        phase_start = std::chrono::steady_clock::now();
+        bytes_read = 0;
+        for (std::size_t i = 0; i < file_count; ++i)
+        {
+            const auto CIK = make_CIK(i);
+            const auto file_name = make_file_name(CIK, i);
+            const auto entry = segment_store.FindFile(CIK, SegmentStore::AccessionNumberFromFileName(file_name));
+            BOOST_ASSERT_MSG(entry, "Segment store lost a file.");
+            bytes_read += segment_store.ReadFile(*entry).size();
+        }
+        log_result("Read from segments", std::chrono::steady_clock::now() - phase_start);
+        BOOST_ASSERT_MSG(bytes_read == file_count * file_size, "Didn't read back what we wrote.");
+    }
+
+    spdlog::info(std::format("G: Disk space used for {} bytes of files: a file each: {} bytes. Segments: {} bytes.",
+                             file_count * file_size, DiskSpaceUsed(files_directory),
+                             DiskSpaceUsed(store_directory)));
+
+    fs::remove_all(benchmark_directory);
+} // -----  end of function BenchmarkSegmentStore  -----
@@ -0,0 +1,231 @@
+// =====================================================================================
+//
+//       Filename:  SegmentStore.h
+//
+//    Description:  Keeps small form files packed together in large segment
+//                  files instead of a file each
+//
+//        Version:  1.0
+//        Created:  10/19/2026 10:41:26 PM
+//       Revision:  none
+//       Compiler:  g++
+//
+//         Author:  David P. Riedel (dpr), driedel@cox.net
+//        License:  GNU General Public License v3
+//        Company:
+//
+// =====================================================================================
+
+/* This file is part of Collector. */
+
+/* Collector is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU General Public License as published by */
+/* the Free Software Foundation, either version 3 of the License, or */
+/* (at your option) any later version. */
+
+/* Collector is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU General Public License for more details. */
+
+/* You should have received a copy of the GNU General Public License */
+/* along with Collector.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef SEGMENTSTORE_H_
+#define SEGMENTSTORE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Collector_Utils.h"
+#include "FormDirectoryLayout.h"
+#include "FormTypeMatcher.h"
+
+namespace fs = std::filesystem;
+
+// =====================================================================================
+//        Class:  SegmentStore
+//  Description:  forms 3, 4 and 5 are a few KB each and there are hundreds
+//                of thousands of them.  As a file each, they swamp inode
+//                caches and backups.
+//
+//                The segment store appends each file to the end of a large
+//                segment file (segment_000001.pack, ...) and adds a line to
+//                an index file giving the segment, offset, size, CIK, form
+//                type and EDGAR file name.  Like the download manifest, each
+//                index line is a single write so a crash can at most leave a
+//                partial last line, which is ignored.  The data is always
+//                written before its index line.
+//
+//                An accession is listed in the index files under each CIK it
+//                involves.  Forms 3, 4 and 5 are under both the issuer and
+//                the reporting owner.  So files are kept by CIK and accession
+//                number (the EDGAR file name without its directory or
+//                extension), the same as the <CIK>/<form type>/<file>
+//                layout.  The second CIK's index line points at the data
+//                already in a segment instead of a second copy.
+//
+//                Files are found by CIK and accession number, by accession
+//                number alone or by CIK and form type.  ExportTo writes them
+//                back out to the usual layout.
+// =====================================================================================
+class SegmentStore
+{
+public:
+    struct Entry
+    {
+        std::uint32_t segment;
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t CIK;
+        std::string form_type;
+        std::string file_name; // EDGAR file name, e.g. edgar/data/1234/0001234567-24-000001.txt
+    };
+
+    // ====================  LIFECYCLE     =======================================
+
+    SegmentStore() = delete;
+
+    // form_types are the ones to keep in segments.  They can use the same
+    // trailing '*' patterns as the form list.
+
+    SegmentStore(const fs::path &store_directory, const std::vector<std::string> &form_types);
+
+    SegmentStore(const SegmentStore &rhs) = delete;
+    SegmentStore(SegmentStore &&rhs) = delete;
+
+    ~SegmentStore();
+
+    // ====================  ACCESSORS     =======================================
+
+    [[nodiscard]] const fs::path &GetStoreDirectory() const
+    {
+        return store_directory_;
+    }
+    [[nodiscard]] std::size_t GetFileCount() const;
+
+    [[nodiscard]] bool WantsFormType(COL::sview form_type) const;
+
+    // file_name is the EDGAR file name.
+
+    [[nodiscard]] bool HasFile(std::uint32_t CIK, COL::sview file_name) const;
+
+    [[nodiscard]] std::optional<Entry> FindFile(std::uint32_t CIK, COL::sview accession_number) const;
+
+    // any CIK's copy.
+
+    [[nodiscard]] std::optional<Entry> FindFile(COL::sview accession_number) const;
+    [[nodiscard]] std::vector<Entry> FindFiles(std::uint32_t CIK, COL::sview form_type) const;
+
+    [[nodiscard]] std::string ReadFile(const Entry &entry) const;
+
+    // download to this name then call AddFile.  Unique to the CIK since the
+    // same accession can be downloaded for 2 CIKs at once.
+
+    [[nodiscard]] fs::path MakeDownloadFileName(std::uint32_t CIK, COL::sview file_name) const;
+
+    // 0001234567-24-000001 from edgar/data/1234/0001234567-24-000001.txt
+
+    [[nodiscard]] static COL::sview AccessionNumberFromFileName(COL::sview file_name);
+
+    // writes every file in the store to local_form_directory in the usual
+    // layout.  Returns how many files were written.
+
+    std::size_t ExportTo(const fs::path &local_form_directory,
+                         bool replace_files,
+                         FormDirectoryLayout layout = FormDirectoryLayout::e_flat) const;
+
+    // logs what this run added to the store.
+
+    void LogStatistics() const;
+
+    // ====================  MUTATORS      =======================================
+
+    SegmentStore &operator=(const SegmentStore &rhs) = delete;
+    SegmentStore &operator=(SegmentStore &&rhs) = delete;
+
+    // appends the downloaded file to the current segment, indexes it and
+    // removes the downloaded file.  A file already in the store is replaced.
+    // Safe to call from any thread.
+
+    void AddFile(const fs::path &downloaded_file_name,
+                 std::uint32_t CIK,
+                 COL::sview form_type,
+                 COL::sview file_name);
+
+    // if the accession in file_name is already in the store under another
+    // CIK, indexes it for this CIK too, using the same data, and returns
+    // true.  Nothing to download then.  Safe to call from any thread.
+
+    bool AddSharedFile(std::uint32_t CIK, COL::sview form_type, COL::sview file_name);
+
+    // ====================  OPERATORS     =======================================
+
+protected:
+    // ====================  DATA MEMBERS  =======================================
+
+private:
+    [[nodiscard]] fs::path MakeSegmentFileName(std::uint32_t segment) const;
+
+    // returns true if the last index line was cut off.
+
+    bool Load();
+    void OpenSegment(std::uint32_t segment);
+    void AddEntry(Entry entry);
+
+    // under store_mutex_.
+
+    void WriteIndexLine(const Entry &entry);
+    void Write(int fd, COL::sview data, const fs::path &file_name);
+
+    // ====================  DATA MEMBERS  =======================================
+
+    // start a new segment when the current one gets this big.
+
+    static constexpr std::uint64_t k_segment_size = 1024ULL * 1024 * 1024;
+
+    fs::path store_directory_;
+    fs::path index_file_name_;
+
+    FormTypeMatcher form_matcher_;
+
+    // the latest entry for each CIK and accession number.
+
+    std::vector<Entry> entries_;
+    std::map<std::pair<std::uint32_t, std::string>, std::size_t> entries_by_CIK_accession_number_;
+    std::unordered_map<std::string, std::vector<std::size_t>> entries_by_accession_number_;
+    std::map<std::pair<std::uint32_t, std::string>, std::vector<std::size_t>> entries_by_CIK_form_;
+
+    std::uint32_t segment_ = 0;
+    std::uint64_t segment_size_ = 0;
+    int segment_fd_ = -1;
+    int index_fd_ = -1;
+
+    // for LogStatistics.
+
+    std::uint64_t files_added_ = 0;
+    std::uint64_t files_shared_ = 0;
+    std::uint64_t bytes_added_ = 0;
+    std::chrono::steady_clock::duration write_time_{};
+
+    mutable std::mutex store_mutex_;
+
+}; // -----  end of class SegmentStore  -----
+
+// writes file_count files of file_size bytes in a scratch directory under
+// directory, once as a file each in <CIK>/<form type> directories and once
+// to a segment store, then reads them all back.  Logs the times and the disk
+// space each used.  The scratch directory is removed afterwards.
+
+void BenchmarkSegmentStore(const fs::path &directory, std::size_t file_count, std::size_t file_size);
+
+#endif /* SEGMENTSTORE_H_ */